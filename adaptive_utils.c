@@ -0,0 +1,167 @@
+/**
+ * @file adaptive_utils.c
+ * @brief Implementation of the adaptive single-pass coder
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "adaptive_utils.h"
+#include <stdio.h>
+
+/* Builds the table of the next interval from the running counts */
+static bool rebuild(struct huff_adaptive_coder *a)
+{
+    uint64_t total = 0;
+    int i;
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+        total += a->counts[i];
+    if (total > HUFF_ADAPTIVE_MAX_TOTAL)
+    {
+        for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+            a->counts[i] = (a->counts[i] + 1) / 2;
+    }
+    a->since_rebuild = 0;
+    a->period = (a->period * 2 < a->interval) ? a->period * 2 : a->interval;
+    /* Tree is built from the counts as in the two-pass coder */
+    return huff_table_from_freq(&a->table, a->counts, HUFF_DEFAULT_MAX_BITS);
+}
+
+/**
+ * @param a coder to initialize. The first table is flat
+ * @param interval symbols between rebuilds e.g HUFF_ADAPTIVE_INTERVAL
+ * @return true if allocation did not fail
+ */
+bool huff_adaptive_init(struct huff_adaptive_coder *a, size_t interval)
+{
+    int i;
+    if (interval == 0)
+    {
+        fprintf(stderr, "ERROR: Adaptive interval must be positive!\n");
+        return false;
+    }
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+        a->counts[i] = 1;
+    a->interval = interval;
+    a->period = HUFF_ADAPTIVE_FIRST / 2;
+    a->acc = 0;
+    a->nbits = 0;
+    if (!huff_table_init(&a->table, HUFF_BYTE_SYMBOLS))
+        return false;
+    if (!rebuild(a))
+    {
+        huff_table_free(&a->table);
+        return false;
+    }
+    return true;
+}
+
+void huff_adaptive_free(struct huff_adaptive_coder *a)
+{
+    huff_table_free(&a->table);
+}
+
+/**
+ * @brief Worst case output of one call of huff_adaptive_encode()
+ *
+ * @param len input size
+ * @return max number of bytes written
+ */
+size_t huff_adaptive_bound(size_t len)
+{
+    return (len * HUFF_DEFAULT_MAX_BITS + 7) / 8 + 1;
+}
+
+/**
+ * @brief Encodes the next piece of a stream. Complete bytes are written right away,
+ * at most 7 bits stay pending until the next call or huff_adaptive_finish()
+ *
+ * @param a the coder
+ * @param in piece of the stream
+ * @param len piece size
+ * @param out output of at least huff_adaptive_bound(len) bytes
+ * @return written bytes, 0 is valid for very short pieces
+ */
+size_t huff_adaptive_encode(struct huff_adaptive_coder *a, const unsigned char *in, size_t len, unsigned char *out)
+{
+    struct bit_writer w;
+    size_t i = 0;
+
+    w.out = out;
+    w.pos = 0;
+    w.acc = a->acc;
+    w.nbits = a->nbits;
+    while (i < len)
+    {
+        /* Symbols up to the next rebuild share the same table */
+        size_t end = i + (a->period - a->since_rebuild);
+        if (end > len)
+            end = len;
+        a->since_rebuild += end - i;
+        for (; i < end; i++)
+        {
+            bw_put(&w, a->table.codes[in[i]], a->table.lengths[in[i]]);
+            a->counts[in[i]]++;
+        }
+        if (a->since_rebuild == a->period && !rebuild(a))
+            return 0;
+    }
+    a->acc = w.acc;
+    a->nbits = w.nbits;
+    return w.pos;
+}
+
+/**
+ * @brief Writes the pending bits padded with zeros
+ *
+ * @param a the coder
+ * @param out output of at least 1 byte
+ * @return written bytes
+ */
+size_t huff_adaptive_finish(struct huff_adaptive_coder *a, unsigned char *out)
+{
+    struct bit_writer w;
+    w.out = out;
+    w.pos = 0;
+    w.acc = a->acc;
+    w.nbits = a->nbits;
+    a->acc = 0;
+    a->nbits = 0;
+    return bw_flush(&w);
+}
+
+/**
+ * @brief Decodes exactly 'out_len' bytes of a stream, rebuilding tables as the encoder did
+ *
+ * @param a coder freshly initialized with the interval of the encoder
+ * @param in encoded stream
+ * @param in_len encoded size
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool huff_adaptive_decode(struct huff_adaptive_coder *a, const unsigned char *in, size_t in_len,
+                          unsigned char *out, size_t out_len)
+{
+    struct bit_reader r;
+    size_t i = 0;
+    br_init(&r, in, in_len);
+    while (i < out_len)
+    {
+        size_t end = i + (a->period - a->since_rebuild);
+        if (end > out_len)
+            end = out_len;
+        a->since_rebuild += end - i;
+        for (; i < end; i++)
+        {
+            br_refill(&r);
+            int symbol = huff_decode_symbol(&a->table, &r);
+            if (symbol < 0)
+                return false;
+            out[i] = (unsigned char)symbol;
+            a->counts[symbol]++;
+        }
+        if (a->since_rebuild == a->period && !rebuild(a))
+            return false;
+    }
+    return br_consumed(&r) <= in_len * 8;
+}
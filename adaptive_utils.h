@@ -0,0 +1,88 @@
+/**
+ * @file adaptive_utils.h
+ * @brief Adaptive single-pass coding: the table is rebuilt from running counts
+ *        every 'interval' symbols, so output starts without a frequency pass
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "codec_utils.h"
+
+#ifndef ADAPTIVE_H
+# define ADAPTIVE_H
+
+/* Default number of symbols between two table rebuilds */
+#define HUFF_ADAPTIVE_INTERVAL (16 * 1024)
+
+/* First rebuild comes after this many symbols, the period then doubles up to the interval */
+#define HUFF_ADAPTIVE_FIRST 1024
+
+/* Counts are halved when their sum goes over this, so old data weighs less */
+#define HUFF_ADAPTIVE_MAX_TOTAL (1 << 20)
+
+/* State shared by encoder and decoder: both rebuild the same tables at the same positions */
+struct huff_adaptive_coder
+{
+    unsigned int counts[HUFF_BYTE_SYMBOLS]; /* running counts, start at 1 so every byte has a code */
+    struct huff_table table;                /* table of the current interval */
+    size_t interval;                        /* symbols between rebuilds */
+    size_t period;                          /* symbols until the next rebuild, grows up to 'interval' */
+    size_t since_rebuild;                   /* symbols coded with the current table */
+    uint64_t acc;                           /* encoder: bits not written yet */
+    int nbits;                              /* encoder: number of bits not written yet */
+};
+
+/**
+ * @param a coder to initialize. The first table is flat
+ * @param interval symbols between rebuilds e.g HUFF_ADAPTIVE_INTERVAL
+ * @return true if allocation did not fail
+ */
+bool huff_adaptive_init(struct huff_adaptive_coder *a, size_t interval);
+void huff_adaptive_free(struct huff_adaptive_coder *a);
+
+/**
+ * @brief Worst case output of one call of huff_adaptive_encode()
+ *
+ * @param len input size
+ * @return max number of bytes written
+ */
+size_t huff_adaptive_bound(size_t len);
+
+/**
+ * @brief Encodes the next piece of a stream. Complete bytes are written right away,
+ * at most 7 bits stay pending until the next call or huff_adaptive_finish()
+ *
+ * @param a the coder
+ * @param in piece of the stream
+ * @param len piece size
+ * @param out output of at least huff_adaptive_bound(len) bytes
+ * @return written bytes, 0 is valid for very short pieces
+ */
+size_t huff_adaptive_encode(struct huff_adaptive_coder *a, const unsigned char *in, size_t len, unsigned char *out);
+
+/**
+ * @brief Writes the pending bits padded with zeros
+ *
+ * @param a the coder
+ * @param out output of at least 1 byte
+ * @return written bytes
+ */
+size_t huff_adaptive_finish(struct huff_adaptive_coder *a, unsigned char *out);
+
+/**
+ * @brief Decodes exactly 'out_len' bytes of a stream, rebuilding tables as the encoder did
+ *
+ * @param a coder freshly initialized with the interval of the encoder
+ * @param in encoded stream
+ * @param in_len encoded size
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool huff_adaptive_decode(struct huff_adaptive_coder *a, const unsigned char *in, size_t in_len,
+                          unsigned char *out, size_t out_len);
+
+#endif
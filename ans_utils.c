@@ -0,0 +1,317 @@
+/**
+ * @file ans_utils.c
+ * @brief Implementation of the tANS entropy coder
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "ans_utils.h"
+#include "codec_utils.h"
+#include <math.h>
+#include <string.h>
+
+/* Position of the highest set bit */
+static int highest_bit(unsigned int v)
+{
+    return 31 - __builtin_clz(v);
+}
+
+/**
+ * @brief Scales frequencies so that they sum to ANS_TABLE_SIZE, every used symbol keeps at least 1
+ *
+ * @param freq the 256 frequencies
+ * @param norm location in which save the normalized counts
+ * @return true if there is at least one symbol
+ */
+bool ans_normalize(const unsigned int *freq, unsigned short *norm)
+{
+    uint64_t total = 0;
+    int i, sum = 0, largest = -1;
+    for (i = 0; i < ANS_SYMBOLS; i++)
+        total += freq[i];
+    if (total == 0)
+        return false;
+
+    for (i = 0; i < ANS_SYMBOLS; i++)
+    {
+        norm[i] = 0;
+        if (freq[i] == 0)
+            continue;
+        uint64_t n = ((uint64_t)freq[i] * ANS_TABLE_SIZE + total / 2) / total;
+        norm[i] = (n > 0) ? n : 1;
+        sum += norm[i];
+        if (largest < 0 || norm[i] > norm[largest])
+            largest = i;
+    }
+
+    /* Rounding error goes to the largest count, then to the others if it is not enough */
+    if (sum < ANS_TABLE_SIZE || norm[largest] - (sum - ANS_TABLE_SIZE) >= 1)
+    {
+        norm[largest] += ANS_TABLE_SIZE - sum;
+        return true;
+    }
+    while (sum > ANS_TABLE_SIZE)
+    {
+        largest = 0;
+        for (i = 1; i < ANS_SYMBOLS; i++)
+        {
+            if (norm[i] > norm[largest])
+                largest = i;
+        }
+        norm[largest]--;
+        sum--;
+    }
+    return true;
+}
+
+/**
+ * @brief Estimated size in bits of a histogram coded with normalized counts
+ *
+ * @param freq the 256 frequencies
+ * @param norm normalized counts
+ * @return estimated size in bits
+ */
+double ans_cost_bits(const unsigned int *freq, const unsigned short *norm)
+{
+    double bits = 0;
+    int i;
+    for (i = 0; i < ANS_SYMBOLS; i++)
+    {
+        if (freq[i] != 0)
+            bits += freq[i] * (ANS_TABLE_LOG - log2(norm[i]));
+    }
+    return bits + ANS_TABLE_LOG;
+}
+
+/**
+ * @brief Builds encoding and decoding tables from normalized counts
+ *
+ * @param t the table
+ * @param norm normalized counts, summing to ANS_TABLE_SIZE
+ * @return true if counts are valid
+ */
+bool ans_table_build(struct ans_table *t, const unsigned short *norm)
+{
+    unsigned char spread[ANS_TABLE_SIZE];
+    unsigned int next[ANS_SYMBOLS];
+    int cumul[ANS_SYMBOLS + 1];
+    int i, k, s, pos = 0, sum = 0;
+    const int step = (ANS_TABLE_SIZE >> 1) + (ANS_TABLE_SIZE >> 3) + 3;
+
+    for (s = 0; s < ANS_SYMBOLS; s++)
+        sum += norm[s];
+    if (sum != ANS_TABLE_SIZE)
+        return false;
+    memcpy(t->norm, norm, sizeof(t->norm));
+
+    /* Symbols are spread over the states so that each one is scattered evenly */
+    for (s = 0; s < ANS_SYMBOLS; s++)
+    {
+        for (k = 0; k < norm[s]; k++)
+        {
+            spread[pos] = s;
+            pos = (pos + step) & (ANS_TABLE_SIZE - 1);
+        }
+    }
+
+    /* Decoder: the k-th state of a symbol goes back to 'norm + k' scaled to the table */
+    for (s = 0; s < ANS_SYMBOLS; s++)
+        next[s] = norm[s];
+    for (i = 0; i < ANS_TABLE_SIZE; i++)
+    {
+        s = spread[i];
+        unsigned int x = next[s]++;
+        int nb_bits = ANS_TABLE_LOG - highest_bit(x);
+        t->decode[i].symbol = s;
+        t->decode[i].nb_bits = nb_bits;
+        t->decode[i].base = (x << nb_bits) - ANS_TABLE_SIZE;
+    }
+
+    /* Encoder: states of each symbol in increasing order */
+    cumul[0] = 0;
+    for (s = 0; s < ANS_SYMBOLS; s++)
+        cumul[s + 1] = cumul[s] + norm[s];
+    for (i = 0; i < ANS_TABLE_SIZE; i++)
+        t->next_state[cumul[spread[i]]++] = ANS_TABLE_SIZE + i;
+    for (s = 0; s < ANS_SYMBOLS; s++)
+    {
+        int start = cumul[s] - norm[s];
+        if (norm[s] == 0)
+        {
+            t->find_state[s] = 0;
+            t->delta_nb_bits[s] = 0;
+            continue;
+        }
+        int max_bits = ANS_TABLE_LOG - highest_bit(norm[s]);
+        unsigned int min_state = (unsigned int)norm[s] << max_bits;
+        t->delta_nb_bits[s] = (max_bits << 16) - min_state;
+        t->find_state[s] = start - norm[s];
+    }
+    return true;
+}
+
+/**
+ * @param t the table
+ * @param out output of at least ANS_TABLE_MAX_BYTES bytes
+ * @return written bytes
+ */
+size_t ans_write_table(const struct ans_table *t, unsigned char *out)
+{
+    size_t pos = 1;
+    int s, count = 0;
+    for (s = 0; s < ANS_SYMBOLS; s++)
+    {
+        if (t->norm[s] == 0)
+            continue;
+        out[pos++] = s;
+        out[pos++] = t->norm[s] & 0xff;
+        out[pos++] = t->norm[s] >> 8;
+        count++;
+    }
+    out[0] = count - 1;
+    return pos;
+}
+
+/**
+ * @brief Reads what ans_write_table() wrote and builds the table
+ *
+ * @param t the table
+ * @param in serialized table
+ * @param len available bytes
+ * @return consumed bytes, 0 on error
+ */
+size_t ans_read_table(struct ans_table *t, const unsigned char *in, size_t len)
+{
+    unsigned short norm[ANS_SYMBOLS] = {0};
+    int i;
+    if (len < 1)
+        return 0;
+    int count = in[0] + 1;
+    size_t size = 1 + 3 * (size_t)count;
+    if (len < size)
+        return 0;
+    for (i = 0; i < count; i++)
+        norm[in[1 + 3 * i]] = in[2 + 3 * i] | (in[3 + 3 * i] << 8);
+    return ans_table_build(t, norm) ? size : 0;
+}
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by ans_encode()
+ */
+size_t ans_bound(size_t len)
+{
+    return 4 + ((len + 1) * ANS_TABLE_LOG + 7) / 8;
+}
+
+/**
+ * @brief Encodes a buffer. Symbols are coded last to first so that decoding runs forward.
+ *
+ * @param t the table. Every byte of the input must have a count
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least ans_bound(len) bytes
+ * @return written bytes
+ */
+size_t ans_encode(const struct ans_table *t, const unsigned char *in, size_t len, unsigned char *out)
+{
+    struct bit_writer w;
+    unsigned int state = ANS_TABLE_SIZE;
+    size_t i;
+
+    bw_init(&w, out + 4);
+    for (i = len; i > 0; i--)
+    {
+        unsigned char s = in[i - 1];
+        int nb_bits = (state + t->delta_nb_bits[s]) >> 16;
+        bw_put(&w, state & ((1u << nb_bits) - 1), nb_bits);
+        state = t->next_state[(state >> nb_bits) + t->find_state[s]];
+    }
+    bw_put(&w, state - ANS_TABLE_SIZE, ANS_TABLE_LOG);
+
+    size_t total_bits = w.pos * 8 + w.nbits;
+    out[0] = total_bits & 0xff;
+    out[1] = (total_bits >> 8) & 0xff;
+    out[2] = (total_bits >> 16) & 0xff;
+    out[3] = (total_bits >> 24) & 0xff;
+    return 4 + bw_flush(&w);
+}
+
+/* Backward bit reader: a 64 bits window of the stream, reloaded when the next read would leave it */
+struct ans_reader
+{
+    const unsigned char *in; /* encoded bits */
+    size_t len;              /* size in bytes */
+    size_t bitpos;           /* bits not read yet are [0, bitpos) */
+    size_t first;            /* first bit of the window */
+    uint64_t window;         /* bits [first, first + 64), MSB first */
+};
+
+static inline void ar_reload(struct ans_reader *r)
+{
+    size_t byte = (r->bitpos > 64) ? (r->bitpos - 64 + 7) >> 3 : 0;
+    if (byte + 8 <= r->len)
+    {
+        memcpy(&r->window, r->in + byte, sizeof(r->window));
+        r->window = __builtin_bswap64(r->window);
+    }
+    else
+    {
+        int i;
+        r->window = 0;
+        for (i = 0; i < 8; i++)
+            r->window = (r->window << 8) | ((byte + i < r->len) ? r->in[byte + i] : 0);
+    }
+    r->first = byte * 8;
+}
+
+/* Reads the 'n' bits (0 to ANS_TABLE_LOG) before the current position */
+static inline unsigned int ar_read(struct ans_reader *r, int n)
+{
+    if (r->bitpos - n < r->first)
+        ar_reload(r);
+    r->bitpos -= n;
+    /* Double shift keeps n == 0 defined */
+    return (unsigned int)(((r->window << (r->bitpos - r->first)) >> 1) >> (63 - n));
+}
+
+/**
+ * @brief Decodes exactly 'out_len' bytes. Apart from the window reload the loop does not branch on the data.
+ *
+ * @param t the table
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool ans_decode(const struct ans_table *t, const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len)
+{
+    struct ans_reader r;
+    size_t i;
+    if (in_len < 4)
+        return false;
+    size_t total_bits = (size_t)in[0] | ((size_t)in[1] << 8) | ((size_t)in[2] << 16) | ((size_t)in[3] << 24);
+    /* Every symbol reads at most ANS_TABLE_LOG bits, so a valid stream can not underflow */
+    if (total_bits > (in_len - 4) * 8 || total_bits < ANS_TABLE_LOG ||
+        total_bits - ANS_TABLE_LOG > out_len * ANS_TABLE_LOG)
+        return false;
+
+    /* Bits are read backwards: the final state of the encoder comes first */
+    r.in = in + 4;
+    r.len = in_len - 4;
+    r.bitpos = total_bits;
+    ar_reload(&r);
+    unsigned int state = ar_read(&r, ANS_TABLE_LOG);
+    for (i = 0; i < out_len; i++)
+    {
+        struct ans_decode_entry e = t->decode[state];
+        out[i] = e.symbol;
+        if (r.bitpos < e.nb_bits)
+            return false;
+        state = e.base + ar_read(&r, e.nb_bits);
+    }
+    return r.bitpos == 0 && state == 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file ans_utils.h
+ * @brief Table based asymmetric numeral systems (tANS, FSE style) entropy coder
+ *        for byte alphabets. Alternative backend to Huffman tables for a block.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ANS_H
+# define ANS_H
+
+/* Number of states is 1 << ANS_TABLE_LOG */
+#define ANS_TABLE_LOG 11
+#define ANS_TABLE_SIZE (1 << ANS_TABLE_LOG)
+
+/* Alphabet size */
+#define ANS_SYMBOLS 256
+
+/* Serialized table: number of symbols, then (symbol, 2 bytes count) for each of them */
+#define ANS_TABLE_MAX_BYTES (1 + 3 * ANS_SYMBOLS)
+
+/* Decoding step of a state */
+struct ans_decode_entry
+{
+    unsigned char symbol;   /* decoded symbol */
+    unsigned char nb_bits;  /* bits to read */
+    unsigned short base;    /* next state is base + read bits */
+};
+
+/* Encoding and decoding tables of a normalized distribution */
+struct ans_table
+{
+    unsigned short norm[ANS_SYMBOLS];               /* counts normalized to ANS_TABLE_SIZE */
+    struct ans_decode_entry decode[ANS_TABLE_SIZE]; /* decoder: one entry per state */
+    unsigned short next_state[ANS_TABLE_SIZE];      /* encoder: states grouped by symbol */
+    int find_state[ANS_SYMBOLS];                    /* encoder: offset of a symbol into next_state */
+    unsigned int delta_nb_bits[ANS_SYMBOLS];        /* encoder: (state + delta) >> 16 gives bits to write */
+};
+
+/**
+ * @brief Scales frequencies so that they sum to ANS_TABLE_SIZE, every used symbol keeps at least 1
+ *
+ * @param freq the 256 frequencies
+ * @param norm location in which save the normalized counts
+ * @return true if there is at least one symbol
+ */
+bool ans_normalize(const unsigned int *freq, unsigned short *norm);
+
+/**
+ * @brief Estimated size in bits of a histogram coded with normalized counts
+ *
+ * @param freq the 256 frequencies
+ * @param norm normalized counts
+ * @return estimated size in bits
+ */
+double ans_cost_bits(const unsigned int *freq, const unsigned short *norm);
+
+/**
+ * @brief Builds encoding and decoding tables from normalized counts
+ *
+ * @param t the table
+ * @param norm normalized counts, summing to ANS_TABLE_SIZE
+ * @return true if counts are valid
+ */
+bool ans_table_build(struct ans_table *t, const unsigned short *norm);
+
+/**
+ * @param t the table
+ * @param out output of at least ANS_TABLE_MAX_BYTES bytes
+ * @return written bytes
+ */
+size_t ans_write_table(const struct ans_table *t, unsigned char *out);
+
+/**
+ * @brief Reads what ans_write_table() wrote and builds the table
+ *
+ * @param t the table
+ * @param in serialized table
+ * @param len available bytes
+ * @return consumed bytes, 0 on error
+ */
+size_t ans_read_table(struct ans_table *t, const unsigned char *in, size_t len);
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by ans_encode()
+ */
+size_t ans_bound(size_t len);
+
+/**
+ * @brief Encodes a buffer. Symbols are coded last to first so that decoding runs forward.
+ * Layout: total bits (4 bytes), then the bits, the final state being the last ones.
+ *
+ * @param t the table. Every byte of the input must have a count
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least ans_bound(len) bytes
+ * @return written bytes
+ */
+size_t ans_encode(const struct ans_table *t, const unsigned char *in, size_t len, unsigned char *out);
+
+/**
+ * @brief Decodes exactly 'out_len' bytes
+ *
+ * @param t the table
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool ans_decode(const struct ans_table *t, const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len);
+
+#endif
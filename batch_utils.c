@@ -0,0 +1,94 @@
+/**
+ * @file batch_utils.c
+ * @brief Implementation of batched encoding/decoding
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "batch_utils.h"
+#include <omp.h>
+#include <stdio.h>
+
+/* Records are small: hand them out to threads in groups */
+#define BATCH_CHUNK 64
+
+/**
+ * @brief Computes where every encoded record will be placed into the output arena.
+ *
+ * @param t shared byte table. Every byte of the records must have a code
+ * @param records input records
+ * @param nrecords number of records
+ * @param offsets location in which save 'nrecords + 1' offsets. Caller must allocate memory
+ * @return size of the arena e.g offsets[nrecords], (size_t)-1 if a byte of a record has no code
+ */
+size_t huff_batch_offsets(const struct huff_table *t, const struct huff_record *records, int nrecords, size_t *offsets)
+{
+    int i, uncoded = 0;
+
+    /* Sizes first, in parallel. offsets[i + 1] temporarily holds the size of record i */
+    #pragma omp parallel for schedule(dynamic, BATCH_CHUNK) reduction(+ : uncoded)
+    for (i = 0; i < nrecords; i++)
+    {
+        size_t bits = 0, k;
+        /* A byte without code would be encoded as 0 bits and decoded as another one */
+        for (k = 0; k < records[i].len; k++)
+        {
+            unsigned char len = t->lengths[records[i].data[k]];
+            uncoded += (len == 0);
+            bits += len;
+        }
+        offsets[i + 1] = (bits + 7) / 8;
+    }
+    if (uncoded > 0)
+    {
+        fprintf(stderr, "ERROR: %d bytes of the records have no code!\n", uncoded);
+        return (size_t)-1;
+    }
+
+    offsets[0] = 0;
+    for (i = 0; i < nrecords; i++)
+        offsets[i + 1] += offsets[i];
+    return offsets[nrecords];
+}
+
+/**
+ * @brief Encodes all records into one arena, in parallel across records.
+ *
+ * @param t shared byte table
+ * @param records input records
+ * @param nrecords number of records
+ * @param offsets offsets computed by huff_batch_offsets()
+ * @param arena output arena of offsets[nrecords] bytes
+ */
+void huff_encode_batch(const struct huff_table *t, const struct huff_record *records, int nrecords, const size_t *offsets, unsigned char *arena)
+{
+    int i;
+    #pragma omp parallel for schedule(dynamic, BATCH_CHUNK)
+    for (i = 0; i < nrecords; i++)
+        huff_encode(t, records[i].data, records[i].len, arena + offsets[i]);
+}
+
+/**
+ * @brief Decodes all records of an arena, in parallel across records.
+ *
+ * @param t shared byte table
+ * @param arena encoded arena
+ * @param offsets offsets of the encoded records, 'nrecords + 1' entries
+ * @param nrecords number of records
+ * @param out_arena location in which save decoded records. Caller must allocate out_offsets[nrecords] bytes
+ * @param out_offsets offsets of the decoded records e.g prefix sum of the original sizes
+ * @return true if every record was decoded
+ */
+bool huff_decode_batch(const struct huff_table *t, const unsigned char *arena, const size_t *offsets, int nrecords,
+                       unsigned char *out_arena, const size_t *out_offsets)
+{
+    int i, failed = 0;
+    #pragma omp parallel for schedule(dynamic, BATCH_CHUNK) reduction(+ : failed)
+    for (i = 0; i < nrecords; i++)
+    {
+        if (!huff_decode(t, arena + offsets[i], offsets[i + 1] - offsets[i],
+                         out_arena + out_offsets[i], out_offsets[i + 1] - out_offsets[i]))
+            failed++;
+    }
+    return failed == 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file batch_utils.h
+ * @brief Batched encoding/decoding of many small records with one shared table
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include "codec_utils.h"
+
+#ifndef BATCH_H
+# define BATCH_H
+
+/* A record of the batch */
+struct huff_record
+{
+    const unsigned char *data; /* record bytes */
+    size_t len;                /* record size */
+};
+
+/**
+ * @brief Computes where every encoded record will be placed into the output arena.
+ * Records are byte aligned, record i takes arena[offsets[i]] up to arena[offsets[i + 1]].
+ *
+ * @param t shared byte table. Every byte of the records must have a code
+ * @param records input records
+ * @param nrecords number of records
+ * @param offsets location in which save 'nrecords + 1' offsets. Caller must allocate memory
+ * @return size of the arena e.g offsets[nrecords], (size_t)-1 if a byte of a record has no code
+ */
+size_t huff_batch_offsets(const struct huff_table *t, const struct huff_record *records, int nrecords, size_t *offsets);
+
+/**
+ * @brief Encodes all records into one arena, in parallel across records.
+ * No memory is allocated.
+ *
+ * @param t shared byte table
+ * @param records input records
+ * @param nrecords number of records
+ * @param offsets offsets computed by huff_batch_offsets()
+ * @param arena output arena of offsets[nrecords] bytes
+ */
+void huff_encode_batch(const struct huff_table *t, const struct huff_record *records, int nrecords, const size_t *offsets, unsigned char *arena);
+
+/**
+ * @brief Decodes all records of an arena, in parallel across records.
+ * No memory is allocated.
+ *
+ * @param t shared byte table
+ * @param arena encoded arena
+ * @param offsets offsets of the encoded records, 'nrecords + 1' entries
+ * @param nrecords number of records
+ * @param out_arena location in which save decoded records. Caller must allocate out_offsets[nrecords] bytes
+ * @param out_offsets offsets of the decoded records e.g prefix sum of the original sizes
+ * @return true if every record was decoded
+ */
+bool huff_decode_batch(const struct huff_table *t, const unsigned char *arena, const size_t *offsets, int nrecords,
+                       unsigned char *out_arena, const size_t *out_offsets);
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * Benchmark of the block codec over synthetic corpora. The corpus is generated
+ * chunk by chunk (the same bytes whatever the number of processes), so sizes up to
+ * many GB need only a few chunks of memory. Three configurations are run:
+ * serial (process 0, one thread), mt (process 0, all threads) and hybrid
+ * (all processes, all threads). Only compression and decompression are timed.
+ * @file bench.c
+ * @brief Usage: mpirun -np <P> ./bench <uniform|zipf|english|binary> <size[K|M|G]> [options]
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "block_utils.h"
+#include "corpus_utils.h"
+#include "pool_utils.h"
+
+/* Corpus is generated and coded in chunks of this size */
+#define BENCH_CHUNK (64 * 1024 * 1024)
+
+/* Options of a run */
+struct bench_options
+{
+    enum corpus_kind kind;
+    size_t size;
+    int alphabet;
+    double zipf_s;
+    uint64_t seed;
+    int threads;
+    enum huff_backend backend;
+    bool json;
+    bool header;
+    char *configs;   /* comma separated list of configurations */
+    char *write_to;  /* write the corpus to this file instead of benchmarking */
+};
+
+/* Result of a configuration */
+struct bench_result
+{
+    unsigned long long raw;   /* input bytes */
+    unsigned long long coded; /* compressed bytes */
+    unsigned long long freq[HUFF_BYTE_SYMBOLS];
+    double enc_time;          /* seconds spent compressing */
+    double dec_time;          /* seconds spent decompressing */
+    int ok;                   /* 1 if every chunk round-tripped */
+};
+
+/* Generates chunk 'c' of the corpus. Every chunk has its own seed */
+static size_t make_chunk(const struct bench_options *o, size_t c, unsigned char *buf)
+{
+    struct corpus_gen g;
+    size_t start = c * BENCH_CHUNK;
+    size_t n = (o->size - start < BENCH_CHUNK) ? o->size - start : BENCH_CHUNK;
+    corpus_init(&g, o->kind, o->alphabet, o->zipf_s, o->seed + c * 0x9E3779B97F4A7C15ULL);
+    corpus_fill(&g, buf, n);
+    return n;
+}
+
+/**
+ * @brief Compresses and decompresses chunks first, first + step, ...
+ *
+ * @param o the options
+ * @param first first chunk
+ * @param step distance between chunks
+ * @param threads number of OpenMP threads
+ * @param r location in which save the result
+ * @return true if allocation did not fail
+ */
+static bool run_chunks(const struct bench_options *o, size_t first, size_t step, int threads, struct bench_result *r)
+{
+    size_t nchunks = (o->size + BENCH_CHUNK - 1) / BENCH_CHUNK;
+    size_t chunk_len = (o->size < BENCH_CHUNK) ? o->size : BENCH_CHUNK;
+    size_t c, i;
+
+    memset(r, 0, sizeof(*r));
+    r->ok = 1;
+    struct huff_block_ctx ctx;
+    struct huff_pool pool;
+    unsigned char *in = (unsigned char *)malloc(chunk_len);
+    omp_set_num_threads(threads);
+    if (in == NULL || !huff_block_ctx_init(&ctx, o->backend, threads))
+    {
+        fprintf(stderr, "ERROR: Not enough memory for a chunk!\n");
+        free(in);
+        return false;
+    }
+    /* Chunks are messages: buffers come from the pool, the context is reused */
+    huff_pool_init(&pool, 2 * (huff_fused_bound(chunk_len, HUFF_BLOCK_SIZE) + chunk_len));
+
+    for (c = first; c < nchunks; c += step)
+    {
+        size_t n = make_chunk(o, c, in), decoded_len;
+        for (i = 0; i < n; i++)
+            r->freq[in[i]]++;
+        unsigned char *coded = (unsigned char *)huff_pool_get(&pool, huff_fused_bound(n, HUFF_BLOCK_SIZE));
+        unsigned char *decoded = (unsigned char *)huff_pool_get(&pool, n);
+        if (coded == NULL || decoded == NULL)
+        {
+            fprintf(stderr, "ERROR: Not enough memory for a chunk!\n");
+            r->ok = 0;
+            huff_pool_put(&pool, coded);
+            huff_pool_put(&pool, decoded);
+            break;
+        }
+
+        double t0 = omp_get_wtime();
+        size_t coded_len = huff_compress_fused_ctx(&ctx, in, n, HUFF_BLOCK_SIZE, coded);
+        double t1 = omp_get_wtime();
+        bool ok = huff_decompress_blocks_ctx(&ctx, coded, coded_len, decoded, n, &decoded_len);
+        double t2 = omp_get_wtime();
+
+        r->enc_time += t1 - t0;
+        r->dec_time += t2 - t1;
+        r->raw += n;
+        r->coded += coded_len;
+        if (coded_len == 0 || !ok || decoded_len != n || memcmp(in, decoded, n) != 0)
+            r->ok = 0;
+        huff_pool_put(&pool, coded);
+        huff_pool_put(&pool, decoded);
+    }
+    free(in);
+    huff_pool_free(&pool);
+    huff_block_ctx_free(&ctx);
+    return true;
+}
+
+/* Prints one row */
+static void print_result(const struct bench_options *o, const char *config, int ranks, int threads,
+                         const struct bench_result *r)
+{
+    double entropy = 0, raw = (r->raw > 0) ? (double)r->raw : 1;
+    int i;
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+    {
+        if (r->freq[i] != 0)
+            entropy += r->freq[i] * log2(raw / r->freq[i]);
+    }
+    entropy /= raw;
+    double ratio = r->coded / raw;
+    double bits = 8.0 * r->coded / raw;
+    double enc_mbps = (r->enc_time > 0) ? raw / 1e6 / r->enc_time : 0;
+    double dec_mbps = (r->dec_time > 0) ? raw / 1e6 / r->dec_time : 0;
+
+    if (o->json)
+        printf("{\"config\": \"%s\", \"corpus\": \"%s\", \"size\": %llu, \"ranks\": %d, \"threads\": %d, "
+               "\"coded\": %llu, \"ratio\": %.4f, \"bits_per_symbol\": %.4f, \"entropy\": %.4f, "
+               "\"enc_mbps\": %.1f, \"dec_mbps\": %.1f, \"ok\": %s}\n",
+               config, corpus_kind_name(o->kind), r->raw, ranks, threads, r->coded, ratio, bits, entropy,
+               enc_mbps, dec_mbps, r->ok ? "true" : "false");
+    else
+        printf("%s,%s,%llu,%d,%d,%llu,%.4f,%.4f,%.4f,%.1f,%.1f,%d\n", config, corpus_kind_name(o->kind), r->raw,
+               ranks, threads, r->coded, ratio, bits, entropy, enc_mbps, dec_mbps, r->ok);
+    fflush(stdout);
+}
+
+/* Reads the options, returns false on usage error */
+static bool parse_options(int argc, char **argv, struct bench_options *o)
+{
+    int arg;
+    o->alphabet = 64;
+    o->zipf_s = 1.0;
+    o->seed = 1;
+    o->threads = omp_get_max_threads();
+    o->backend = HUFF_BACKEND_AUTO;
+    o->json = false;
+    o->header = true;
+    o->configs = "serial,mt,hybrid";
+    o->write_to = NULL;
+    if (argc < 3 || !corpus_parse_kind(argv[1], &o->kind) || (o->size = corpus_parse_size(argv[2])) == 0)
+        return false;
+
+    for (arg = 3; arg < argc; arg++)
+    {
+        bool has_value = arg + 1 < argc;
+        if (strcmp(argv[arg], "--json") == 0)
+            o->json = true;
+        else if (strcmp(argv[arg], "--no-header") == 0)
+            o->header = false;
+        else if (strcmp(argv[arg], "--threads") == 0 && has_value)
+            o->threads = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "--alphabet") == 0 && has_value)
+            o->alphabet = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "--zipf") == 0 && has_value)
+            o->zipf_s = atof(argv[++arg]);
+        else if (strcmp(argv[arg], "--seed") == 0 && has_value)
+            o->seed = strtoull(argv[++arg], NULL, 10);
+        else if (strcmp(argv[arg], "--configs") == 0 && has_value)
+            o->configs = argv[++arg];
+        else if (strcmp(argv[arg], "--write") == 0 && has_value)
+            o->write_to = argv[++arg];
+        else if (strcmp(argv[arg], "--backend") == 0 && has_value)
+        {
+            arg++;
+            if (strcmp(argv[arg], "huffman") == 0)
+                o->backend = HUFF_BACKEND_HUFFMAN;
+            else if (strcmp(argv[arg], "ans") == 0)
+                o->backend = HUFF_BACKEND_ANS;
+            else if (strcmp(argv[arg], "auto") != 0)
+                return false;
+        }
+        else
+            return false;
+    }
+    return o->threads > 0;
+}
+
+/* Writes the corpus to a file, chunk by chunk */
+static bool write_corpus(const struct bench_options *o)
+{
+    size_t nchunks = (o->size + BENCH_CHUNK - 1) / BENCH_CHUNK, c;
+    FILE *fp = fopen(o->write_to, "wb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not write [%s]!\n", o->write_to);
+        return false;
+    }
+    unsigned char *buf = (unsigned char *)malloc((o->size < BENCH_CHUNK) ? o->size : BENCH_CHUNK);
+    for (c = 0; c < nchunks; c++)
+    {
+        size_t n = make_chunk(o, c, buf);
+        fwrite(buf, 1, n, fp);
+    }
+    free(buf);
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_options o;
+    struct bench_result r, total;
+    int myrank, world_size;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+
+    if (!parse_options(argc, argv, &o))
+    {
+        if (myrank == 0)
+            fprintf(stderr, "Usage: %s <uniform|zipf|english|binary> <size[K|M|G]> [--threads N] [--json] [--no-header]\n"
+                            "       [--alphabet K] [--zipf S] [--seed S] [--backend auto|huffman|ans]\n"
+                            "       [--configs serial,mt,hybrid] [--write file]\n", argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+    if (o.write_to != NULL)
+    {
+        bool ok = (myrank == 0) ? write_corpus(&o) : true;
+        MPI_Finalize();
+        return ok ? 0 : 1;
+    }
+    if (myrank == 0 && !o.json && o.header)
+        printf("config,corpus,size,ranks,threads,coded,ratio,bits_per_symbol,entropy,enc_mbps,dec_mbps,ok\n");
+
+    /* Serial and multithreaded runs only involve process 0 */
+    if (myrank == 0 && strstr(o.configs, "serial") != NULL && run_chunks(&o, 0, 1, 1, &r))
+        print_result(&o, "serial", 1, 1, &r);
+    if (myrank == 0 && strstr(o.configs, "mt") != NULL && run_chunks(&o, 0, 1, o.threads, &r))
+        print_result(&o, "mt", 1, o.threads, &r);
+
+    /* Hybrid: chunks are dealt to processes, time is the one of the slowest process */
+    if (strstr(o.configs, "hybrid") != NULL)
+    {
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (!run_chunks(&o, myrank, world_size, o.threads, &r))
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        MPI_Reduce(&r.raw, &total.raw, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&r.coded, &total.coded, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(r.freq, total.freq, HUFF_BYTE_SYMBOLS, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&r.enc_time, &total.enc_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&r.dec_time, &total.dec_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&r.ok, &total.ok, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+        if (myrank == 0)
+            print_result(&o, "hybrid", world_size, o.threads, &total);
+    }
+
+    MPI_Finalize();
+    return 0;
+}
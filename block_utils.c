@@ -0,0 +1,708 @@
+/**
+ * @file block_utils.c
+ * @brief Implementation of the block container
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "block_utils.h"
+#include "sched_utils.h"
+#include "crc_utils.h"
+#include <omp.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void put_u32(unsigned char *out, size_t value)
+{
+    out[0] = value & 0xff;
+    out[1] = (value >> 8) & 0xff;
+    out[2] = (value >> 16) & 0xff;
+    out[3] = (value >> 24) & 0xff;
+}
+
+static size_t get_u32(const unsigned char *in)
+{
+    return (size_t)in[0] | ((size_t)in[1] << 8) | ((size_t)in[2] << 16) | ((size_t)in[3] << 24);
+}
+
+/* Cost in bits of a histogram coded with a table. Returns (uint64_t)-1 if a symbol has no code */
+static uint64_t table_cost(const struct huff_table *t, const unsigned int *freq)
+{
+    uint64_t bits = 0;
+    int i;
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+    {
+        if (freq[i] == 0)
+            continue;
+        if (t->lengths[i] == 0)
+            return (uint64_t)-1;
+        bits += (uint64_t)freq[i] * t->lengths[i];
+    }
+    return bits;
+}
+
+/* Writes the code lengths of a table as nibbles */
+static void write_table(const struct huff_table *t, unsigned char *out)
+{
+    int i;
+    for (i = 0; i < HUFF_TABLE_BYTES; i++)
+        out[i] = (t->lengths[2 * i] << 4) | t->lengths[2 * i + 1];
+}
+
+/* Reads the code lengths written by write_table() and builds the table */
+static bool read_table(struct huff_table *t, const unsigned char *in)
+{
+    unsigned char lengths[HUFF_BYTE_SYMBOLS];
+    int i;
+    for (i = 0; i < HUFF_TABLE_BYTES; i++)
+    {
+        lengths[2 * i] = in[i] >> 4;
+        lengths[2 * i + 1] = in[i] & 0x0f;
+    }
+    return huff_table_from_lengths(t, lengths);
+}
+
+/**
+ * @param enc encoder to initialize
+ * @param backend backends the blocks can be coded with
+ * @return true if allocation did not fail
+ */
+bool huff_block_encoder_init(struct huff_block_encoder *enc, enum huff_backend backend)
+{
+    enc->has_table = false;
+    enc->backend = backend;
+    enc->scratch = NULL;
+    enc->scratch_size = 0;
+    enc->shared = NULL;
+    enc->ans = (struct ans_table *)malloc(sizeof(struct ans_table));
+    if (enc->ans == NULL)
+        return false;
+    if (!huff_table_init(&enc->table, HUFF_BYTE_SYMBOLS))
+    {
+        free(enc->ans);
+        return false;
+    }
+    if (!huff_table_init(&enc->candidate, HUFF_BYTE_SYMBOLS))
+    {
+        huff_table_free(&enc->table);
+        free(enc->ans);
+        return false;
+    }
+    return true;
+}
+
+void huff_block_encoder_free(struct huff_block_encoder *enc)
+{
+    huff_table_free(&enc->table);
+    huff_table_free(&enc->candidate);
+    free(enc->ans);
+    free(enc->scratch);
+    enc->ans = NULL;
+    enc->scratch = NULL;
+    enc->scratch_size = 0;
+    enc->has_table = false;
+}
+
+/**
+ * @param dec decoder to initialize
+ * @return true if allocation did not fail
+ */
+bool huff_block_decoder_init(struct huff_block_decoder *dec)
+{
+    dec->has_table = false;
+    dec->shared = NULL;
+    dec->ans = (struct ans_table *)malloc(sizeof(struct ans_table));
+    if (dec->ans == NULL)
+        return false;
+    if (!huff_table_init(&dec->table, HUFF_BYTE_SYMBOLS))
+    {
+        free(dec->ans);
+        return false;
+    }
+    return true;
+}
+
+void huff_block_decoder_free(struct huff_block_decoder *dec)
+{
+    huff_table_free(&dec->table);
+    free(dec->ans);
+    dec->ans = NULL;
+    dec->has_table = false;
+}
+
+/**
+ * @brief Worst case size of a compressed block
+ *
+ * @param raw_len size of the block
+ * @return max number of bytes written by huff_compress_block()
+ */
+size_t huff_block_bound(size_t raw_len)
+{
+    /* Coded blocks are always smaller than raw ones */
+    return HUFF_BLOCK_HEADER + raw_len;
+}
+
+/**
+ * @brief Worst case size of a buffer compressed with huff_compress_fused()
+ *
+ * @param len input size
+ * @param block_size size of the blocks
+ * @return max number of bytes written
+ */
+size_t huff_fused_bound(size_t len, size_t block_size)
+{
+    size_t nblocks = (len + block_size - 1) / block_size;
+    return nblocks * huff_block_bound(block_size);
+}
+
+/**
+ * @brief Lower bound of the coded size of a histogram e.g its entropy
+ *
+ * @param freq the 256 frequencies
+ * @param len sum of the frequencies
+ * @return estimated size in bits
+ */
+double huff_entropy_bits(const unsigned int *freq, size_t len)
+{
+    double bits = 0;
+    int i;
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+    {
+        if (freq[i] != 0)
+            bits += freq[i] * log2((double)len / freq[i]);
+    }
+    return bits;
+}
+
+/* Stores a block uncompressed */
+static size_t store_raw(const unsigned char *in, size_t len, unsigned char *out)
+{
+    put_u32(out, len);
+    put_u32(out + 4, len);
+    out[8] = HUFF_BLOCK_RAW;
+    memcpy(out + HUFF_BLOCK_HEADER, in, len);
+    return HUFF_BLOCK_HEADER + len;
+}
+
+/* Block without its checksum, see huff_compress_block() */
+static size_t compress_block(struct huff_block_encoder *enc, const unsigned char *in, size_t len, unsigned char *out)
+{
+    unsigned int freq[HUFF_BYTE_SYMBOLS] = {0};
+    unsigned short norm[ANS_SYMBOLS];
+    size_t pos = HUFF_BLOCK_HEADER;
+    unsigned char flags = 0;
+    uint64_t raw_cost = (uint64_t)len * 8;
+    uint64_t reuse_cost = (uint64_t)-1, shared_cost = (uint64_t)-1, new_cost = (uint64_t)-1, ans_cost = (uint64_t)-1;
+
+    huff_histogram(in, len, freq);
+
+    /* No code can beat the entropy: skip the table build when even the entropy does not pay off */
+    if (enc->backend != HUFF_BACKEND_ANS && enc->has_table)
+        reuse_cost = table_cost(&enc->table, freq);
+    if (enc->backend != HUFF_BACKEND_ANS && enc->shared != NULL)
+        shared_cost = table_cost(enc->shared, freq);
+    uint64_t kept_cost = (reuse_cost < shared_cost) ? reuse_cost : shared_cost;
+    double new_bound = huff_entropy_bits(freq, len) + HUFF_TABLE_BYTES * 8;
+    if (kept_cost >= raw_cost && new_bound >= raw_cost)
+        return store_raw(in, len, out);
+
+    if (enc->backend != HUFF_BACKEND_HUFFMAN && ans_normalize(freq, norm))
+    {
+        int nsymbols = 0, i;
+        for (i = 0; i < ANS_SYMBOLS; i++)
+            nsymbols += (norm[i] != 0);
+        ans_cost = (uint64_t)ans_cost_bits(freq, norm) + (1 + 3 * nsymbols + 4) * 8;
+    }
+    /* A new table costs at least the entropy plus its header: no build when a kept table is cheaper */
+    if (enc->backend != HUFF_BACKEND_ANS && (double)kept_cost + 1 >= new_bound)
+    {
+        if (!huff_table_from_freq(&enc->candidate, freq, HUFF_DEFAULT_MAX_BITS))
+            return 0;
+        new_cost = table_cost(&enc->candidate, freq) + HUFF_TABLE_BYTES * 8;
+    }
+
+    /* Previous (or shared) table is kept if it costs less than a new table plus its header */
+    uint64_t huff_cost = (kept_cost < new_cost) ? kept_cost : new_cost;
+    if ((huff_cost < ans_cost ? huff_cost : ans_cost) >= raw_cost)
+        return store_raw(in, len, out);
+    if (ans_cost < huff_cost)
+    {
+        /* Estimate is not exact: coded into scratch memory, kept only if it is smaller than the raw block */
+        size_t bound = ANS_TABLE_MAX_BYTES + ans_bound(len);
+        if (enc->scratch_size < bound)
+        {
+            unsigned char *tmp = (unsigned char *)realloc(enc->scratch, bound);
+            if (tmp == NULL)
+                return 0;
+            enc->scratch = tmp;
+            enc->scratch_size = bound;
+        }
+        if (!ans_table_build(enc->ans, norm))
+            return 0;
+        size_t coded_len = ans_write_table(enc->ans, enc->scratch);
+        coded_len += ans_encode(enc->ans, in, len, enc->scratch + coded_len);
+        if (coded_len >= len)
+            return store_raw(in, len, out);
+        put_u32(out, len);
+        put_u32(out + 4, coded_len);
+        out[8] = HUFF_BLOCK_ANS;
+        memcpy(out + pos, enc->scratch, coded_len);
+        return pos + coded_len;
+    }
+    if (shared_cost <= huff_cost && shared_cost < reuse_cost)
+    {
+        /* The previous table stays the one later blocks may reuse */
+        size_t coded_len = huff_encode(enc->shared, in, len, out + pos);
+        put_u32(out, len);
+        put_u32(out + 4, coded_len);
+        out[8] = HUFF_BLOCK_SHARED;
+        return pos + coded_len;
+    }
+    if (reuse_cost > new_cost)
+    {
+        struct huff_table tmp = enc->table;
+        enc->table = enc->candidate;
+        enc->candidate = tmp;
+        enc->has_table = true;
+        flags |= HUFF_BLOCK_TABLE;
+        write_table(&enc->table, out + pos);
+        pos += HUFF_TABLE_BYTES;
+    }
+
+    size_t coded_len = huff_encode(&enc->table, in, len, out + pos);
+    put_u32(out, len);
+    put_u32(out + 4, coded_len);
+    out[8] = flags;
+    return pos + coded_len;
+}
+
+/**
+ * @brief Loads the table carried by a block into a decoder, so that blocks reusing it
+ * can be decoded without the block that carries it e.g out of order
+ *
+ * @param dec decoder state
+ * @param table the HUFF_TABLE_BYTES bytes that follow the header of a HUFF_BLOCK_TABLE block
+ * @return true if the table is valid
+ */
+bool huff_block_decoder_load_table(struct huff_block_decoder *dec, const unsigned char *table)
+{
+    dec->has_table = read_table(&dec->table, table);
+    return dec->has_table;
+}
+
+/* Block without checking its checksum, see huff_decompress_block() */
+static size_t decompress_block(struct huff_block_decoder *dec, const unsigned char *in, size_t in_len,
+                               unsigned char *out, size_t out_cap, size_t *raw_len)
+{
+    size_t pos = HUFF_BLOCK_HEADER;
+    if (in_len < HUFF_BLOCK_HEADER)
+        return 0;
+
+    size_t len = get_u32(in);
+    size_t coded_len = get_u32(in + 4);
+    unsigned char flags = in[8];
+    if (flags & HUFF_BLOCK_RAW)
+    {
+        if (len != coded_len || len > out_cap || in_len - pos < len)
+            return 0;
+        memcpy(out, in + pos, len);
+        *raw_len = len;
+        return pos + len;
+    }
+    if (flags & HUFF_BLOCK_ANS)
+    {
+        if (len > out_cap || in_len - pos < coded_len)
+            return 0;
+        size_t table_len = ans_read_table(dec->ans, in + pos, coded_len);
+        if (table_len == 0 || !ans_decode(dec->ans, in + pos + table_len, coded_len - table_len, out, len))
+            return 0;
+        *raw_len = len;
+        return pos + coded_len;
+    }
+    if (flags & HUFF_BLOCK_SHARED)
+    {
+        if (dec->shared == NULL || len > out_cap || in_len - pos < coded_len ||
+            !huff_decode(dec->shared, in + pos, coded_len, out, len))
+            return 0;
+        *raw_len = len;
+        return pos + coded_len;
+    }
+    if (flags & HUFF_BLOCK_TABLE)
+    {
+        if (in_len < pos + HUFF_TABLE_BYTES || !read_table(&dec->table, in + pos))
+            return 0;
+        dec->has_table = true;
+        pos += HUFF_TABLE_BYTES;
+    }
+    if (!dec->has_table || len > out_cap || in_len - pos < coded_len)
+        return 0;
+
+    if (!huff_decode(&dec->table, in + pos, coded_len, out, len))
+        return 0;
+    *raw_len = len;
+    return pos + coded_len;
+}
+
+/**
+ * @brief Counts, builds (or reuses) the table and encodes one block in a single pass.
+ * With HUFF_BACKEND_AUTO the block is coded with tANS when its estimated size is smaller.
+ * Blocks whose coded size would not be smaller than the raw one are stored raw. The CRC32C
+ * of the raw bytes goes into the header, computed while the block is in cache.
+ *
+ * @param enc encoder state
+ * @param in block bytes
+ * @param len block size
+ * @param out output of at least huff_block_bound(len) bytes
+ * @return written bytes, 0 on error
+ */
+size_t huff_compress_block(struct huff_block_encoder *enc, const unsigned char *in, size_t len, unsigned char *out)
+{
+    size_t written = compress_block(enc, in, len, out);
+    if (written > 0)
+        put_u32(out + 9, huff_crc32c(0, in, len));
+    return written;
+}
+
+/**
+ * @brief Decodes one block and checks the CRC32C of the decoded bytes
+ *
+ * @param dec decoder state
+ * @param in compressed stream, starting at a block header
+ * @param in_len available compressed bytes
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param raw_len location in which save the decoded size
+ * @return consumed bytes, 0 on error or checksum mismatch
+ */
+size_t huff_decompress_block(struct huff_block_decoder *dec, const unsigned char *in, size_t in_len,
+                             unsigned char *out, size_t out_cap, size_t *raw_len)
+{
+    size_t consumed = decompress_block(dec, in, in_len, out, out_cap, raw_len);
+    if (consumed > 0 && huff_crc32c(0, out, *raw_len) != get_u32(in + 9))
+    {
+        fprintf(stderr, "ERROR: Block checksum mismatch!\n");
+        return 0;
+    }
+    return consumed;
+}
+
+/**
+ * @brief Allocates the per-thread encoders and decoders, the scheduler and the block arrays
+ *
+ * @param ctx context to initialize
+ * @param backend backends the blocks can be coded with
+ * @param nthreads max number of threads, 0 for omp_get_max_threads()
+ * @return true if allocation did not fail
+ */
+bool huff_block_ctx_init(struct huff_block_ctx *ctx, enum huff_backend backend, int nthreads)
+{
+    int i;
+    memset(ctx, 0, sizeof(struct huff_block_ctx));
+    ctx->nthreads = (nthreads > 0) ? nthreads : omp_get_max_threads();
+    ctx->enc = (struct huff_block_encoder *)calloc(ctx->nthreads, sizeof(struct huff_block_encoder));
+    ctx->dec = (struct huff_block_decoder *)calloc(ctx->nthreads, sizeof(struct huff_block_decoder));
+    if (ctx->enc == NULL || ctx->dec == NULL || !huff_sched_init(&ctx->sched, 0, ctx->nthreads))
+    {
+        free(ctx->enc);
+        free(ctx->dec);
+        return false;
+    }
+    for (i = 0; i < ctx->nthreads; i++)
+    {
+        if (!huff_block_encoder_init(&ctx->enc[i], backend) || !huff_block_decoder_init(&ctx->dec[i]))
+        {
+            fprintf(stderr, "ERROR: Block context allocation failed!\n");
+            ctx->nthreads = i + 1;
+            huff_block_ctx_free(ctx);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Releases the context
+ *
+ * @param ctx the context
+ */
+void huff_block_ctx_free(struct huff_block_ctx *ctx)
+{
+    int i;
+    for (i = 0; ctx->enc != NULL && i < ctx->nthreads; i++)
+    {
+        huff_block_encoder_free(&ctx->enc[i]);
+        huff_block_decoder_free(&ctx->dec[i]);
+    }
+    free(ctx->enc);
+    free(ctx->dec);
+    free(ctx->written);
+    free(ctx->blocks);
+    huff_sched_free(&ctx->sched);
+    memset(ctx, 0, sizeof(struct huff_block_ctx));
+}
+
+/**
+ * @brief Gives the encoders and decoders of the context a table shared by many streams,
+ * e.g files with similar histograms. Blocks for which it is the cheapest table are coded
+ * with it and carry no table; decoding them needs the same table
+ *
+ * @param ctx the context
+ * @param shared the table, NULL to stop sharing. Must outlive its use by the context
+ */
+void huff_block_ctx_share(struct huff_block_ctx *ctx, const struct huff_table *shared)
+{
+    int i;
+    for (i = 0; i < ctx->nthreads; i++)
+    {
+        ctx->enc[i].shared = shared;
+        ctx->dec[i].shared = shared;
+    }
+}
+
+/* Grows the block arrays of the context, keeping them once large enough */
+static bool reserve_blocks(struct huff_block_ctx *ctx, size_t nblocks)
+{
+    if (nblocks + 1 <= ctx->capacity)
+        return true;
+    size_t *written = (size_t *)realloc(ctx->written, (nblocks + 1) * sizeof(size_t));
+    if (written == NULL)
+        return false;
+    ctx->written = written;
+    struct huff_block_info *blocks = (struct huff_block_info *)realloc(ctx->blocks, (nblocks + 1) * sizeof(struct huff_block_info));
+    if (blocks == NULL)
+        return false;
+    ctx->blocks = blocks;
+    ctx->capacity = nblocks + 1;
+    return true;
+}
+
+/* Threads of the next parallel region of a context */
+static int ctx_threads(const struct huff_block_ctx *ctx)
+{
+    int threads = omp_get_max_threads();
+    return (threads < ctx->nthreads) ? threads : ctx->nthreads;
+}
+
+/**
+ * @brief Compresses a buffer block by block with the encoders of the context. Threads
+ * start from contiguous ranges of blocks and steal blocks of slower threads
+ * (sched_utils.h). Every block is written at its worst case offset, then blocks are
+ * compacted in input order. A block carries a table unless the thread coded the
+ * previous block, whose table it can reuse. No allocation once the context has seen
+ * as many blocks
+ *
+ * @param ctx the context
+ * @param in input buffer
+ * @param len input size
+ * @param block_size size of the blocks e.g HUFF_BLOCK_SIZE
+ * @param out output of at least huff_fused_bound() bytes
+ * @return written bytes, 0 on error
+ */
+size_t huff_compress_fused_ctx(struct huff_block_ctx *ctx, const unsigned char *in, size_t len, size_t block_size,
+                               unsigned char *out)
+{
+    size_t nblocks = (len + block_size - 1) / block_size;
+    size_t bound = huff_block_bound(block_size);
+    int threads = ctx_threads(ctx), failed = 0;
+    size_t b;
+
+    if (!reserve_blocks(ctx, nblocks) || !huff_sched_reset(&ctx->sched, nblocks, threads))
+        return 0;
+
+    #pragma omp parallel num_threads(threads) reduction(+ : failed)
+    {
+        int tid = omp_get_thread_num();
+        struct huff_block_encoder *enc = &ctx->enc[tid];
+        size_t task, last = (size_t)-1;
+        /* Tables of the previous buffer are not in this stream */
+        enc->has_table = false;
+        while (!failed && huff_sched_next(&ctx->sched, tid, &task))
+        {
+            size_t start = task * block_size;
+            size_t n = (len - start < block_size) ? len - start : block_size;
+            /* The decoder takes the table of the previous block in the stream */
+            if (task != last + 1)
+                enc->has_table = false;
+            ctx->written[task] = huff_compress_block(enc, in + start, n, out + task * bound);
+            if (ctx->written[task] == 0)
+                failed++;
+            last = task;
+        }
+    }
+
+    size_t total = 0;
+    ctx->crc = 0;
+    for (b = 0; b < nblocks && !failed; b++)
+    {
+        memmove(out + total, out + b * bound, ctx->written[b]);
+        ctx->crc = huff_crc32c_combine(ctx->crc, get_u32(out + total + 9), get_u32(out + total));
+        total += ctx->written[b];
+    }
+    return failed ? 0 : total;
+}
+
+/**
+ * @brief Compresses a buffer block by block, see huff_compress_fused_ctx(). Allocates
+ * a context for the call
+ *
+ * @param in input buffer
+ * @param len input size
+ * @param block_size size of the blocks e.g HUFF_BLOCK_SIZE
+ * @param backend backends the blocks can be coded with
+ * @param out output of at least huff_fused_bound() bytes
+ * @return written bytes, 0 on error
+ */
+size_t huff_compress_fused(const unsigned char *in, size_t len, size_t block_size, enum huff_backend backend,
+                           unsigned char *out)
+{
+    struct huff_block_ctx ctx;
+    if (!huff_block_ctx_init(&ctx, backend, 0))
+        return 0;
+    size_t res = huff_compress_fused_ctx(&ctx, in, len, block_size, out);
+    huff_block_ctx_free(&ctx);
+    return res;
+}
+
+/**
+ * @brief Reads a block header, e.g to read a stream block by block
+ *
+ * @param in block header, HUFF_BLOCK_HEADER bytes
+ * @param raw_len location in which save the decoded size
+ * @param crc location in which save the CRC32C of the decoded bytes
+ * @return size of the whole block: header, table and coded bytes
+ */
+size_t huff_block_header(const unsigned char *in, size_t *raw_len, uint32_t *crc)
+{
+    *raw_len = get_u32(in);
+    *crc = get_u32(in + 9);
+    return HUFF_BLOCK_HEADER + ((in[8] & HUFF_BLOCK_TABLE) ? HUFF_TABLE_BYTES : 0) + get_u32(in + 4);
+}
+
+/**
+ * @brief Walks the block headers of a compressed stream
+ *
+ * @param in compressed stream
+ * @param len stream size
+ * @param blocks location in which save block positions, NULL to only count
+ * @param max_blocks size of 'blocks'
+ * @return number of blocks, -1 on malformed stream
+ */
+int huff_index_blocks(const unsigned char *in, size_t len, struct huff_block_info *blocks, int max_blocks)
+{
+    size_t pos = 0, raw_offset = 0;
+    int count = 0, table_block = -1;
+    while (pos < len)
+    {
+        if (len - pos < HUFF_BLOCK_HEADER)
+            return -1;
+        size_t raw_len;
+        uint32_t crc;
+        size_t size = huff_block_header(in + pos, &raw_len, &crc);
+        if (in[pos + 8] & HUFF_BLOCK_TABLE)
+            table_block = count;
+        if ((table_block < 0 && !(in[pos + 8] & (HUFF_BLOCK_RAW | HUFF_BLOCK_ANS | HUFF_BLOCK_SHARED))) || len - pos < size)
+            return -1;
+        if (blocks != NULL)
+        {
+            if (count >= max_blocks)
+                return -1;
+            blocks[count].offset = pos;
+            blocks[count].raw_offset = raw_offset;
+            blocks[count].raw_len = raw_len;
+            blocks[count].table_block = table_block;
+            blocks[count].crc = crc;
+        }
+        raw_offset += raw_len;
+        pos += size;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Decompresses a whole stream with the decoders of the context, blocks are
+ * decoded in parallel with work stealing. No allocation once the context has seen
+ * as many blocks
+ *
+ * @param ctx the context
+ * @param in compressed stream
+ * @param len stream size
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the stream was decoded
+ */
+bool huff_decompress_blocks_ctx(struct huff_block_ctx *ctx, const unsigned char *in, size_t len, unsigned char *out,
+                                size_t out_cap, size_t *out_len)
+{
+    int nblocks = huff_index_blocks(in, len, NULL, 0);
+    int threads = ctx_threads(ctx), failed = 0, i;
+    if (nblocks < 0 || !reserve_blocks(ctx, nblocks))
+        return false;
+    struct huff_block_info *blocks = ctx->blocks;
+    huff_index_blocks(in, len, blocks, nblocks);
+    size_t total = (nblocks > 0) ? blocks[nblocks - 1].raw_offset + blocks[nblocks - 1].raw_len : 0;
+    if (total > out_cap || !huff_sched_reset(&ctx->sched, nblocks, threads))
+        return false;
+
+    /* Blocks are written at their raw offset, so any thread can decode any block */
+    #pragma omp parallel num_threads(threads) reduction(+ : failed)
+    {
+        int tid = omp_get_thread_num(), loaded = -1, i;
+        struct huff_block_decoder *dec = &ctx->dec[tid];
+        size_t task;
+        dec->has_table = false;
+
+        while (!failed && huff_sched_next(&ctx->sched, tid, &task))
+        {
+            size_t raw_len;
+            i = (int)task;
+            /* Blocks reusing a table need the header of the block that carries it */
+            bool raw = in[blocks[i].offset + 8] & (HUFF_BLOCK_RAW | HUFF_BLOCK_ANS | HUFF_BLOCK_SHARED);
+            if (!raw && blocks[i].table_block != i && blocks[i].table_block != loaded)
+            {
+                size_t table_pos = blocks[blocks[i].table_block].offset + HUFF_BLOCK_HEADER;
+                if (!huff_block_decoder_load_table(dec, in + table_pos))
+                {
+                    failed++;
+                    continue;
+                }
+            }
+            if (!raw)
+                loaded = blocks[i].table_block;
+            if (huff_decompress_block(dec, in + blocks[i].offset, len - blocks[i].offset,
+                                      out + blocks[i].raw_offset, blocks[i].raw_len, &raw_len) == 0)
+                failed++;
+        }
+    }
+
+    /* Checksums of the blocks were verified, their combination is the one of the output */
+    ctx->crc = 0;
+    for (i = 0; i < nblocks && failed == 0; i++)
+        ctx->crc = huff_crc32c_combine(ctx->crc, blocks[i].crc, blocks[i].raw_len);
+    *out_len = total;
+    return failed == 0;
+}
+
+/**
+ * @brief Decompresses a whole stream, see huff_decompress_blocks_ctx(). Allocates
+ * a context for the call
+ *
+ * @param in compressed stream
+ * @param len stream size
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the stream was decoded
+ */
+bool huff_decompress_blocks(const unsigned char *in, size_t len, unsigned char *out, size_t out_cap, size_t *out_len)
+{
+    struct huff_block_ctx ctx;
+    if (!huff_block_ctx_init(&ctx, HUFF_BACKEND_AUTO, 0))
+        return false;
+    bool res = huff_decompress_blocks_ctx(&ctx, in, len, out, out_cap, out_len);
+    huff_block_ctx_free(&ctx);
+    return res;
+}
@@ -0,0 +1,272 @@
+/**
+ * @file block_utils.h
+ * @brief Block container: input is split into cache-sized blocks, each one
+ *        carrying its own table (or reusing the previous one)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include "codec_utils.h"
+#include "ans_utils.h"
+#include "sched_utils.h"
+
+#ifndef BLOCK_H
+# define BLOCK_H
+
+/* Default block size: histogram, table build and encoding run while the block is in L2 */
+#define HUFF_BLOCK_SIZE (256 * 1024)
+
+/* Block header: raw_len (4 bytes), coded_len (4 bytes), flags (1 byte), CRC32C of the raw bytes (4 bytes) */
+#define HUFF_BLOCK_HEADER 13
+
+/* Code lengths of a table, two per byte */
+#define HUFF_TABLE_BYTES (HUFF_BYTE_SYMBOLS / 2)
+
+/* Block flags */
+#define HUFF_BLOCK_TABLE 0x01 /* a new table follows the header, otherwise previous one is reused */
+#define HUFF_BLOCK_RAW 0x02   /* block is stored uncompressed */
+#define HUFF_BLOCK_ANS 0x04   /* block is coded with tANS, its normalized counts follow the header */
+#define HUFF_BLOCK_SHARED 0x08 /* block is coded with the table shared by every stream, kept out of the stream */
+
+/* Entropy backend of the blocks */
+enum huff_backend
+{
+    HUFF_BACKEND_AUTO,    /* smallest estimated size for each block */
+    HUFF_BACKEND_HUFFMAN, /* Huffman tables only */
+    HUFF_BACKEND_ANS      /* tANS only */
+};
+
+/* Per-thread encoder state. Keeps the table of the previous block */
+struct huff_block_encoder
+{
+    struct huff_table table;     /* table of the last emitted block */
+    struct huff_table candidate; /* scratch table built from the current block */
+    bool has_table;              /* true if 'table' can be reused */
+    enum huff_backend backend;   /* backends the blocks can be coded with */
+    struct ans_table *ans;       /* tANS table of the current block */
+    unsigned char *scratch;      /* tANS output, copied when smaller than the raw block */
+    size_t scratch_size;         /* allocated bytes of 'scratch' */
+    const struct huff_table *shared; /* table shared by every stream, NULL if none */
+};
+
+/* Per-thread decoder state */
+struct huff_block_decoder
+{
+    struct huff_table table; /* table of the last decoded block */
+    bool has_table;          /* true if a table was already read */
+    struct ans_table *ans;   /* tANS table of the current block */
+    const struct huff_table *shared; /* table shared by every stream, NULL if none */
+};
+
+/* Position of a block into a compressed stream */
+struct huff_block_info
+{
+    size_t offset;     /* offset of the block header */
+    size_t raw_offset; /* offset of the decoded bytes into the output */
+    size_t raw_len;    /* decoded size */
+    int table_block;   /* index of the block that carries the table */
+    uint32_t crc;      /* CRC32C of the decoded bytes */
+};
+
+/* Reusable state of the parallel calls: encoders, decoders, scheduler and block arrays
+ * are kept between messages, so that a warm context does not allocate */
+struct huff_block_ctx
+{
+    int nthreads;                     /* encoders and decoders allocated */
+    struct huff_block_encoder *enc;   /* one per thread */
+    struct huff_block_decoder *dec;   /* one per thread */
+    struct huff_sched sched;          /* scheduler of the blocks */
+    size_t *written;                  /* compressed size of every block */
+    struct huff_block_info *blocks;   /* positions of the blocks of a stream */
+    size_t capacity;                  /* entries of 'written' and 'blocks' */
+    uint32_t crc;                     /* CRC32C of the raw bytes of the last call */
+};
+
+/**
+ * @param enc encoder to initialize
+ * @param backend backends the blocks can be coded with
+ * @return true if allocation did not fail
+ */
+bool huff_block_encoder_init(struct huff_block_encoder *enc, enum huff_backend backend);
+void huff_block_encoder_free(struct huff_block_encoder *enc);
+
+/**
+ * @param dec decoder to initialize
+ * @return true if allocation did not fail
+ */
+bool huff_block_decoder_init(struct huff_block_decoder *dec);
+void huff_block_decoder_free(struct huff_block_decoder *dec);
+
+/**
+ * @brief Loads the table carried by a block into a decoder, so that blocks reusing it
+ * can be decoded without the block that carries it e.g out of order
+ *
+ * @param dec decoder state
+ * @param table the HUFF_TABLE_BYTES bytes that follow the header of a HUFF_BLOCK_TABLE block
+ * @return true if the table is valid
+ */
+bool huff_block_decoder_load_table(struct huff_block_decoder *dec, const unsigned char *table);
+
+/**
+ * @brief Worst case size of a compressed block
+ *
+ * @param raw_len size of the block
+ * @return max number of bytes written by huff_compress_block()
+ */
+size_t huff_block_bound(size_t raw_len);
+
+/**
+ * @brief Worst case size of a buffer compressed with huff_compress_fused()
+ *
+ * @param len input size
+ * @param block_size size of the blocks
+ * @return max number of bytes written
+ */
+size_t huff_fused_bound(size_t len, size_t block_size);
+
+/**
+ * @brief Lower bound of the coded size of a histogram e.g its entropy
+ *
+ * @param freq the 256 frequencies
+ * @param len sum of the frequencies
+ * @return estimated size in bits
+ */
+double huff_entropy_bits(const unsigned int *freq, size_t len);
+
+/**
+ * @brief Counts, builds (or reuses) the table and encodes one block in a single pass.
+ * With HUFF_BACKEND_AUTO the block is coded with tANS when its estimated size is smaller.
+ * Blocks whose coded size would not be smaller than the raw one are stored raw. The CRC32C
+ * of the raw bytes goes into the header, computed while the block is in cache.
+ *
+ * @param enc encoder state
+ * @param in block bytes
+ * @param len block size
+ * @param out output of at least huff_block_bound(len) bytes
+ * @return written bytes, 0 on error
+ */
+size_t huff_compress_block(struct huff_block_encoder *enc, const unsigned char *in, size_t len, unsigned char *out);
+
+/**
+ * @brief Decodes one block and checks the CRC32C of the decoded bytes
+ *
+ * @param dec decoder state
+ * @param in compressed stream, starting at a block header
+ * @param in_len available compressed bytes
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param raw_len location in which save the decoded size
+ * @return consumed bytes, 0 on error or checksum mismatch
+ */
+size_t huff_decompress_block(struct huff_block_decoder *dec, const unsigned char *in, size_t in_len,
+                             unsigned char *out, size_t out_cap, size_t *raw_len);
+
+/**
+ * @brief Allocates the per-thread encoders and decoders, the scheduler and the block arrays
+ *
+ * @param ctx context to initialize
+ * @param backend backends the blocks can be coded with
+ * @param nthreads max number of threads, 0 for omp_get_max_threads()
+ * @return true if allocation did not fail
+ */
+bool huff_block_ctx_init(struct huff_block_ctx *ctx, enum huff_backend backend, int nthreads);
+
+/**
+ * @brief Releases the context
+ *
+ * @param ctx the context
+ */
+void huff_block_ctx_free(struct huff_block_ctx *ctx);
+
+/**
+ * @brief Gives the encoders and decoders of the context a table shared by many streams,
+ * e.g files with similar histograms. Blocks for which it is the cheapest table are coded
+ * with it and carry no table; decoding them needs the same table
+ *
+ * @param ctx the context
+ * @param shared the table, NULL to stop sharing. Must outlive its use by the context
+ */
+void huff_block_ctx_share(struct huff_block_ctx *ctx, const struct huff_table *shared);
+
+/**
+ * @brief Compresses a buffer block by block with the encoders of the context. Threads start
+ * from contiguous ranges of blocks and steal blocks of slower threads, blocks are output in
+ * input order. No allocation once the context has seen as many blocks
+ *
+ * @param ctx the context
+ * @param in input buffer
+ * @param len input size
+ * @param block_size size of the blocks e.g HUFF_BLOCK_SIZE
+ * @param out output of at least huff_fused_bound() bytes
+ * @return written bytes, 0 on error
+ */
+size_t huff_compress_fused_ctx(struct huff_block_ctx *ctx, const unsigned char *in, size_t len, size_t block_size,
+                               unsigned char *out);
+
+/**
+ * @brief Compresses a buffer block by block, see huff_compress_fused_ctx(). Allocates
+ * a context for the call
+ *
+ * @param in input buffer
+ * @param len input size
+ * @param block_size size of the blocks e.g HUFF_BLOCK_SIZE
+ * @param backend backends the blocks can be coded with
+ * @param out output of at least huff_fused_bound() bytes
+ * @return written bytes, 0 on error
+ */
+size_t huff_compress_fused(const unsigned char *in, size_t len, size_t block_size, enum huff_backend backend,
+                           unsigned char *out);
+
+/**
+ * @brief Reads a block header, e.g to read a stream block by block
+ *
+ * @param in block header, HUFF_BLOCK_HEADER bytes
+ * @param raw_len location in which save the decoded size
+ * @param crc location in which save the CRC32C of the decoded bytes
+ * @return size of the whole block: header, table and coded bytes
+ */
+size_t huff_block_header(const unsigned char *in, size_t *raw_len, uint32_t *crc);
+
+/**
+ * @brief Walks the block headers of a compressed stream
+ *
+ * @param in compressed stream
+ * @param len stream size
+ * @param blocks location in which save block positions, NULL to only count
+ * @param max_blocks size of 'blocks'
+ * @return number of blocks, -1 on malformed stream
+ */
+int huff_index_blocks(const unsigned char *in, size_t len, struct huff_block_info *blocks, int max_blocks);
+
+/**
+ * @brief Decompresses a whole stream with the decoders of the context, blocks are
+ * decoded in parallel with work stealing. No allocation once the context has seen
+ * as many blocks
+ *
+ * @param ctx the context
+ * @param in compressed stream
+ * @param len stream size
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the stream was decoded
+ */
+bool huff_decompress_blocks_ctx(struct huff_block_ctx *ctx, const unsigned char *in, size_t len, unsigned char *out,
+                                size_t out_cap, size_t *out_len);
+
+/**
+ * @brief Decompresses a whole stream, see huff_decompress_blocks_ctx(). Allocates
+ * a context for the call
+ *
+ * @param in compressed stream
+ * @param len stream size
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the stream was decoded
+ */
+bool huff_decompress_blocks(const unsigned char *in, size_t len, unsigned char *out, size_t out_cap, size_t *out_len);
+
+#endif
@@ -0,0 +1,444 @@
+/**
+ * @file codec_utils.c
+ * @brief Implementation of canonical tables and bit-packed encoding/decoding
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "codec_utils.h"
+#include "tree_utils.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Width of the root decode table, see huff_set_lookup_bits() */
+static int lookup_bits = HUFF_LOOKUP_BITS;
+
+/**
+ * @brief Allocates a table for an alphabet of 'nsymbols' symbols
+ *
+ * @param t table to initialize
+ * @param nsymbols size of the alphabet
+ * @return true if allocation did not fail
+ */
+bool huff_table_init(struct huff_table *t, int nsymbols)
+{
+    memset(t, 0, sizeof(struct huff_table));
+    t->nsymbols = nsymbols;
+    t->capacity = nsymbols;
+    t->lengths = (unsigned char *)calloc(nsymbols, sizeof(unsigned char));
+    t->codes = (unsigned int *)calloc(nsymbols, sizeof(unsigned int));
+    t->decode_capacity = 1 << HUFF_LOOKUP_BITS;
+    t->decode = (struct huff_decode_entry *)calloc(t->decode_capacity, sizeof(struct huff_decode_entry));
+    if (t->lengths == NULL || t->codes == NULL || t->decode == NULL)
+    {
+        fprintf(stderr, "ERROR: table allocation failed!\n");
+        huff_table_free(t);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Releases memory owned by the table
+ *
+ * @param t the table
+ */
+void huff_table_free(struct huff_table *t)
+{
+    free(t->lengths);
+    free(t->codes);
+    free(t->decode);
+    free(t->scratch);
+    huff_tree_arena_free(&t->arena);
+    memset(t, 0, sizeof(struct huff_table));
+}
+
+/* Saves in 'lengths' the depth of every leaf */
+static void assign_depths(struct MinHeapNode *root, int depth, unsigned char *lengths)
+{
+    if (isLeaf(root))
+    {
+        lengths[root->data] = (depth > 255) ? 255 : depth;
+        return;
+    }
+    assign_depths(root->left, depth + 1, lengths);
+    assign_depths(root->right, depth + 1, lengths);
+}
+
+/**
+ * @brief Rewrites code lengths so that none exceeds 'max_bits'.
+ * Lengths of the deepest leaves are shortened and the Kraft sum is fixed
+ * by moving leaves down from the longest lengths that are still below the
+ * limit. Symbols keep their order e.g frequent symbols keep shorter codes.
+ * 'order' holds at least 'n' ints.
+ */
+static bool limit_lengths(unsigned char *lengths, int n, int max_bits, int *order)
+{
+    int num[256] = {0};
+    int i, l, used = 0, max_len = 0;
+    for (i = 0; i < n; i++)
+    {
+        if (lengths[i] == 0)
+            continue;
+        used++;
+        if (lengths[i] > max_len)
+            max_len = lengths[i];
+        num[(lengths[i] > max_bits) ? max_bits : lengths[i]]++;
+    }
+    if (max_len <= max_bits)
+        return true;
+    if (((uint64_t)1 << max_bits) < (uint64_t)used)
+    {
+        fprintf(stderr, "ERROR: %d symbols do not fit into %d bits codes!\n", used, max_bits);
+        return false;
+    }
+
+    uint64_t total = 0;
+    for (l = 1; l <= max_bits; l++)
+        total += (uint64_t)num[l] << (max_bits - l);
+    while (total > ((uint64_t)1 << max_bits))
+    {
+        num[max_bits]--;
+        for (l = max_bits - 1; l > 0; l--)
+        {
+            if (num[l])
+            {
+                num[l]--;
+                num[l + 1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    /* Symbols ordered by original length, shortest first. Ties by symbol value */
+    int k = 0;
+    for (l = 1; l <= max_len; l++)
+    {
+        for (i = 0; i < n; i++)
+        {
+            if (lengths[i] == l)
+                order[k++] = i;
+        }
+    }
+    k = 0;
+    for (l = 1; l <= max_bits; l++)
+    {
+        for (i = 0; i < num[l]; i++)
+            lengths[order[k++]] = l;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds a canonical table from frequencies. The tree is the one of HuffmanCodes()
+ *
+ * @param t table initialized with huff_table_init()
+ * @param freq frequency of each symbol, 0 if unused
+ * @param max_bits length limit e.g HUFF_DEFAULT_MAX_BITS
+ * @return true if table is valid
+ */
+bool huff_table_from_freq(struct huff_table *t, const unsigned int *freq, int max_bits)
+{
+    int i, count = 0, shift = 0, nsymbols = t->nsymbols;
+    uint64_t total = 0;
+
+    if (nsymbols <= 0)
+        return false;
+    if (max_bits > HUFF_MAX_BITS)
+        max_bits = HUFF_MAX_BITS;
+
+    /* Symbols, frequencies and length order of the tree: kept by the table, so that
+     * rebuilding a table of the same alphabet does not allocate */
+    if (t->scratch_capacity < t->nsymbols)
+    {
+        int *tmp = (int *)realloc(t->scratch, 3 * t->nsymbols * sizeof(int));
+        if (tmp == NULL)
+        {
+            fprintf(stderr, "ERROR: table allocation failed!\n");
+            return false;
+        }
+        t->scratch = tmp;
+        t->scratch_capacity = t->nsymbols;
+    }
+    int *data = t->scratch, *out_freq = t->scratch + t->nsymbols;
+
+    /* Tree frequencies are int: scale down big histograms */
+    for (i = 0; i < t->nsymbols; i++)
+        total += freq[i];
+    while ((total >> shift) > INT_MAX / 2)
+        shift++;
+
+    for (i = 0; i < t->nsymbols; i++)
+    {
+        if (freq[i] != 0)
+        {
+            data[count] = i;
+            out_freq[count] = (freq[i] >> shift) ? (freq[i] >> shift) : 1;
+            count++;
+        }
+    }
+
+    memset(t->lengths, 0, (size_t)nsymbols);
+    if (count == 1)
+    {
+        /* A single symbol still needs one bit */
+        t->lengths[data[0]] = 1;
+    }
+    else if (count > 1)
+    {
+        struct MinHeapNode *root = HuffmanCodesArena(&t->arena, data, out_freq, count);
+        if (root == NULL)
+            return false;
+        assign_depths(root, 0, t->lengths);
+    }
+
+    if (!limit_lengths(t->lengths, t->nsymbols, max_bits, t->scratch + 2 * t->nsymbols))
+        return false;
+    return huff_table_from_lengths(t, t->lengths);
+}
+
+/* Grows the decode table, keeping its content */
+static bool reserve_decode(struct huff_table *t, int entries)
+{
+    if (entries <= t->decode_capacity)
+        return true;
+    struct huff_decode_entry *tmp = (struct huff_decode_entry *)realloc(t->decode, entries * sizeof(struct huff_decode_entry));
+    if (tmp == NULL)
+    {
+        fprintf(stderr, "ERROR: decode table allocation failed!\n");
+        return false;
+    }
+    t->decode = tmp;
+    t->decode_capacity = entries;
+    return true;
+}
+
+/**
+ * @brief Builds a canonical table from code lengths e.g the ones stored in a block header
+ *
+ * @param t table initialized with huff_table_init()
+ * @param lengths code length of each symbol, 0 if unused
+ * @return true if lengths describe a valid prefix code
+ */
+bool huff_table_from_lengths(struct huff_table *t, const unsigned char *lengths)
+{
+    int bl_count[HUFF_MAX_BITS + 1] = {0};
+    unsigned int next_code[HUFF_MAX_BITS + 1];
+    int i, l, max_len = 0;
+    unsigned int code = 0;
+
+    if (lengths != t->lengths)
+        memcpy(t->lengths, lengths, (size_t)t->nsymbols);
+
+    for (i = 0; i < t->nsymbols; i++)
+    {
+        if (t->lengths[i] > HUFF_MAX_BITS)
+        {
+            fprintf(stderr, "ERROR: code length %d exceeds %d bits!\n", t->lengths[i], HUFF_MAX_BITS);
+            return false;
+        }
+        bl_count[t->lengths[i]]++;
+        if (t->lengths[i] > max_len)
+            max_len = t->lengths[i];
+    }
+
+    /* Kraft inequality: an oversubscribed code is not decodable */
+    uint64_t kraft = 0;
+    for (l = 1; l <= max_len; l++)
+        kraft += (uint64_t)bl_count[l] << (max_len - l);
+    if (kraft > ((uint64_t)1 << max_len))
+    {
+        fprintf(stderr, "ERROR: code lengths are oversubscribed!\n");
+        return false;
+    }
+
+    /* Canonical codes, same rule as deflate */
+    bl_count[0] = 0;
+    for (l = 1; l <= HUFF_MAX_BITS; l++)
+    {
+        code = (code + bl_count[l - 1]) << 1;
+        next_code[l] = code;
+    }
+    for (i = 0; i < t->nsymbols; i++)
+    {
+        if (t->lengths[i] != 0)
+            t->codes[i] = next_code[t->lengths[i]]++;
+    }
+
+    t->max_bits = max_len;
+    t->lookup_bits = (max_len < lookup_bits) ? ((max_len > 0) ? max_len : 1) : lookup_bits;
+    int root_size = 1 << t->lookup_bits;
+    if (!reserve_decode(t, root_size))
+        return false;
+    memset(t->decode, 0, root_size * sizeof(struct huff_decode_entry));
+
+    /* Short codes fill the root table, long codes record the needed sub-table width */
+    for (i = 0; i < t->nsymbols; i++)
+    {
+        int len = t->lengths[i];
+        if (len == 0)
+            continue;
+        if (len <= t->lookup_bits)
+        {
+            int first = t->codes[i] << (t->lookup_bits - len);
+            int k;
+            for (k = 0; k < (1 << (t->lookup_bits - len)); k++)
+            {
+                t->decode[first + k].symbol = i;
+                t->decode[first + k].len = len;
+            }
+        }
+        else
+        {
+            int prefix = t->codes[i] >> (len - t->lookup_bits);
+            if (len - t->lookup_bits > t->decode[prefix].sub_bits)
+                t->decode[prefix].sub_bits = len - t->lookup_bits;
+        }
+    }
+
+    int size = root_size;
+    for (i = 0; i < root_size; i++)
+    {
+        if (t->decode[i].sub_bits)
+        {
+            t->decode[i].symbol = size;
+            size += 1 << t->decode[i].sub_bits;
+        }
+    }
+    if (!reserve_decode(t, size))
+        return false;
+    memset(t->decode + root_size, 0, (size - root_size) * sizeof(struct huff_decode_entry));
+    t->decode_size = size;
+
+    for (i = 0; i < t->nsymbols; i++)
+    {
+        int len = t->lengths[i];
+        if (len <= t->lookup_bits)
+            continue;
+        int extra = len - t->lookup_bits;
+        struct huff_decode_entry *root_entry = &t->decode[t->codes[i] >> extra];
+        int rem = t->codes[i] & ((1u << extra) - 1);
+        int first = root_entry->symbol + (rem << (root_entry->sub_bits - extra));
+        int k;
+        for (k = 0; k < (1 << (root_entry->sub_bits - extra)); k++)
+        {
+            t->decode[first + k].symbol = i;
+            t->decode[first + k].len = len;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Sets the width of the root decode table of the tables built from now on.
+ * The coded stream does not depend on it. Not to be called within a parallel region
+ *
+ * @param bits width, clamped to HUFF_MIN_LOOKUP_BITS..HUFF_MAX_LOOKUP_BITS
+ */
+void huff_set_lookup_bits(int bits)
+{
+    if (bits < HUFF_MIN_LOOKUP_BITS)
+        bits = HUFF_MIN_LOOKUP_BITS;
+    if (bits > HUFF_MAX_LOOKUP_BITS)
+        bits = HUFF_MAX_LOOKUP_BITS;
+    lookup_bits = bits;
+}
+
+/**
+ * @return width of the root decode table, HUFF_LOOKUP_BITS by default
+ */
+int huff_get_lookup_bits(void)
+{
+    return lookup_bits;
+}
+
+/**
+ * @brief Byte histogram of a buffer. Caller must zero 'freq'
+ *
+ * @param in input buffer
+ * @param len input size
+ * @param freq location in which accumulate the 256 frequencies
+ */
+void huff_histogram(const unsigned char *in, size_t len, unsigned int *freq)
+{
+    /* Four partial histograms avoid store-to-load stalls on runs of equal bytes */
+    unsigned int partial[4][HUFF_BYTE_SYMBOLS];
+    size_t i;
+    int k;
+    memset(partial, 0, sizeof(partial));
+    for (i = 0; i + 4 <= len; i += 4)
+    {
+        partial[0][in[i]]++;
+        partial[1][in[i + 1]]++;
+        partial[2][in[i + 2]]++;
+        partial[3][in[i + 3]]++;
+    }
+    for (; i < len; i++)
+        partial[0][in[i]]++;
+    for (k = 0; k < HUFF_BYTE_SYMBOLS; k++)
+        freq[k] += partial[0][k] + partial[1][k] + partial[2][k] + partial[3][k];
+}
+
+/**
+ * @brief Exact size in bits of a buffer encoded with the table
+ *
+ * @param t byte table
+ * @param in input buffer
+ * @param len input size
+ * @return encoded size in bits
+ */
+size_t huff_encoded_bits(const struct huff_table *t, const unsigned char *in, size_t len)
+{
+    size_t i, bits = 0;
+    for (i = 0; i < len; i++)
+        bits += t->lengths[in[i]];
+    return bits;
+}
+
+/**
+ * @brief Encodes a buffer with a byte table. Every byte must have a code
+ *
+ * @param t byte table
+ * @param in input buffer
+ * @param len input size
+ * @param out output buffer of at least (huff_encoded_bits() + 7) / 8 bytes
+ * @return written bytes
+ */
+size_t huff_encode(const struct huff_table *t, const unsigned char *in, size_t len, unsigned char *out)
+{
+    struct bit_writer w;
+    size_t i;
+    bw_init(&w, out);
+    for (i = 0; i < len; i++)
+        bw_put(&w, t->codes[in[i]], t->lengths[in[i]]);
+    return bw_flush(&w);
+}
+
+/**
+ * @brief Decodes exactly 'out_len' bytes
+ *
+ * @param t byte table
+ * @param in encoded buffer
+ * @param in_len encoded size in bytes
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool huff_decode(const struct huff_table *t, const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len)
+{
+    struct bit_reader r;
+    size_t i;
+    br_init(&r, in, in_len);
+    for (i = 0; i < out_len; i++)
+    {
+        br_refill(&r);
+        int symbol = huff_decode_symbol(t, &r);
+        if (symbol < 0)
+            return false;
+        out[i] = (unsigned char)symbol;
+    }
+    return br_consumed(&r) <= in_len * 8;
+}
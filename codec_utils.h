@@ -0,0 +1,269 @@
+/**
+ * @file codec_utils.h
+ * @brief Canonical Huffman tables and bit-packed encoding/decoding of buffers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "tree_utils.h"
+
+#ifndef CODEC_H
+# define CODEC_H
+
+/* Hard upper bound of a code length (the bit reader peeks up to 32 bits) */
+#define HUFF_MAX_BITS 24
+
+/* Length limit used for byte alphabets */
+#define HUFF_DEFAULT_MAX_BITS 15
+
+/* Width of the root decode table. Longer codes go through a sub-table */
+#define HUFF_LOOKUP_BITS 10
+
+/* Range of widths accepted by huff_set_lookup_bits() */
+#define HUFF_MIN_LOOKUP_BITS 6
+#define HUFF_MAX_LOOKUP_BITS 14
+
+/* Size of a byte alphabet */
+#define HUFF_BYTE_SYMBOLS 256
+
+/* Entry of the two-level decode table */
+struct huff_decode_entry
+{
+    unsigned int symbol;    /* decoded symbol, or offset of the sub-table */
+    unsigned char len;      /* code length, 0 if the entry points to a sub-table */
+    unsigned char sub_bits; /* width of the pointed sub-table */
+};
+
+/* Canonical code table: can be rebuilt many times without new allocations */
+struct huff_table
+{
+    int nsymbols;                     /* size of the alphabet */
+    int capacity;                     /* symbols allocated */
+    int max_bits;                     /* longest code of the table */
+    int lookup_bits;                  /* width of the root decode table */
+    unsigned char *lengths;           /* code length of each symbol, 0 if unused */
+    unsigned int *codes;              /* canonical code of each symbol */
+    struct huff_decode_entry *decode; /* root table followed by sub-tables */
+    int decode_size;                  /* decode entries in use */
+    int decode_capacity;              /* decode entries allocated */
+    struct huff_tree_arena arena;     /* nodes of the tree, reused by every build */
+    int *scratch;                     /* symbols, frequencies and length order of a build */
+    int scratch_capacity;             /* symbols the scratch can hold */
+};
+
+/* MSB-first bit writer */
+struct bit_writer
+{
+    unsigned char *out; /* output buffer. Caller must allocate memory */
+    size_t pos;         /* bytes written */
+    uint64_t acc;       /* pending bits in the low part */
+    int nbits;          /* number of pending bits */
+};
+
+/* MSB-first bit reader. Reading past the end returns zeros */
+struct bit_reader
+{
+    const unsigned char *in; /* input buffer */
+    size_t len;              /* input size in bytes */
+    size_t pos;              /* next byte to load */
+    uint64_t acc;            /* loaded bits, left aligned */
+    int nbits;               /* number of loaded bits */
+};
+
+static inline void bw_init(struct bit_writer *w, unsigned char *out)
+{
+    w->out = out;
+    w->pos = 0;
+    w->acc = 0;
+    w->nbits = 0;
+}
+
+static inline void bw_put(struct bit_writer *w, unsigned int code, int len)
+{
+    w->acc = (w->acc << len) | code;
+    w->nbits += len;
+    while (w->nbits >= 8)
+    {
+        w->nbits -= 8;
+        w->out[w->pos++] = (unsigned char)(w->acc >> w->nbits);
+    }
+}
+
+/* Pads the last byte with zeros. Returns total written bytes */
+static inline size_t bw_flush(struct bit_writer *w)
+{
+    if (w->nbits > 0)
+        w->out[w->pos++] = (unsigned char)(w->acc << (8 - w->nbits));
+    w->nbits = 0;
+    return w->pos;
+}
+
+static inline void br_init(struct bit_reader *r, const unsigned char *in, size_t len)
+{
+    r->in = in;
+    r->len = len;
+    r->pos = 0;
+    r->acc = 0;
+    r->nbits = 0;
+}
+
+/* Loads bytes until at least 57 bits are available */
+static inline void br_refill(struct bit_reader *r)
+{
+    if (r->pos + 8 <= r->len)
+    {
+        /* Fast path: one big-endian load, partial bytes are loaded again next time */
+        uint64_t word;
+        memcpy(&word, r->in + r->pos, sizeof(word));
+        r->acc |= __builtin_bswap64(word) >> r->nbits;
+        r->pos += (63 - r->nbits) >> 3;
+        r->nbits |= 56;
+        return;
+    }
+    while (r->nbits <= 56)
+    {
+        uint64_t byte = (r->pos < r->len) ? r->in[r->pos] : 0;
+        r->acc |= byte << (56 - r->nbits);
+        r->pos++;
+        r->nbits += 8;
+    }
+}
+
+static inline unsigned int br_peek(struct bit_reader *r, int n)
+{
+    return (unsigned int)(r->acc >> (64 - n));
+}
+
+static inline void br_consume(struct bit_reader *r, int n)
+{
+    r->acc <<= n;
+    r->nbits -= n;
+}
+
+/* Bits consumed so far */
+static inline size_t br_consumed(struct bit_reader *r)
+{
+    return r->pos * 8 - r->nbits;
+}
+
+/**
+ * @brief Decodes one symbol. Reader must have been refilled
+ *
+ * @param t the table
+ * @param r the bit reader
+ * @return the symbol or -1 on invalid code
+ */
+static inline int huff_decode_symbol(const struct huff_table *t, struct bit_reader *r)
+{
+    struct huff_decode_entry e = t->decode[br_peek(r, t->lookup_bits)];
+    if (e.len == 0)
+    {
+        if (e.sub_bits == 0)
+            return -1;
+        br_consume(r, t->lookup_bits);
+        int len = t->lookup_bits;
+        e = t->decode[e.symbol + br_peek(r, e.sub_bits)];
+        if (e.len == 0)
+            return -1;
+        br_consume(r, e.len - len);
+        return e.symbol;
+    }
+    br_consume(r, e.len);
+    return e.symbol;
+}
+
+/**
+ * @brief Allocates a table for an alphabet of 'nsymbols' symbols
+ *
+ * @param t table to initialize
+ * @param nsymbols size of the alphabet
+ * @return true if allocation did not fail
+ */
+bool huff_table_init(struct huff_table *t, int nsymbols);
+
+/**
+ * @brief Releases memory owned by the table
+ *
+ * @param t the table
+ */
+void huff_table_free(struct huff_table *t);
+
+/**
+ * @brief Builds a canonical table from frequencies. The tree is the one of HuffmanCodes()
+ *
+ * @param t table initialized with huff_table_init()
+ * @param freq frequency of each symbol, 0 if unused
+ * @param max_bits length limit e.g HUFF_DEFAULT_MAX_BITS
+ * @return true if table is valid
+ */
+bool huff_table_from_freq(struct huff_table *t, const unsigned int *freq, int max_bits);
+
+/**
+ * @brief Builds a canonical table from code lengths e.g the ones stored in a block header
+ *
+ * @param t table initialized with huff_table_init()
+ * @param lengths code length of each symbol, 0 if unused
+ * @return true if lengths describe a valid prefix code
+ */
+bool huff_table_from_lengths(struct huff_table *t, const unsigned char *lengths);
+
+/**
+ * @brief Sets the width of the root decode table of the tables built from now on.
+ * The coded stream does not depend on it. Not to be called within a parallel region
+ *
+ * @param bits width, clamped to HUFF_MIN_LOOKUP_BITS..HUFF_MAX_LOOKUP_BITS
+ */
+void huff_set_lookup_bits(int bits);
+
+/**
+ * @return width of the root decode table, HUFF_LOOKUP_BITS by default
+ */
+int huff_get_lookup_bits(void);
+
+/**
+ * @brief Byte histogram of a buffer. Caller must zero 'freq'
+ *
+ * @param in input buffer
+ * @param len input size
+ * @param freq location in which accumulate the 256 frequencies
+ */
+void huff_histogram(const unsigned char *in, size_t len, unsigned int *freq);
+
+/**
+ * @brief Exact size in bits of a buffer encoded with the table
+ *
+ * @param t byte table
+ * @param in input buffer
+ * @param len input size
+ * @return encoded size in bits
+ */
+size_t huff_encoded_bits(const struct huff_table *t, const unsigned char *in, size_t len);
+
+/**
+ * @brief Encodes a buffer with a byte table. Every byte must have a code
+ *
+ * @param t byte table
+ * @param in input buffer
+ * @param len input size
+ * @param out output buffer of at least (huff_encoded_bits() + 7) / 8 bytes
+ * @return written bytes
+ */
+size_t huff_encode(const struct huff_table *t, const unsigned char *in, size_t len, unsigned char *out);
+
+/**
+ * @brief Decodes exactly 'out_len' bytes
+ *
+ * @param t byte table
+ * @param in encoded buffer
+ * @param in_len encoded size in bytes
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool huff_decode(const struct huff_table *t, const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len);
+
+#endif
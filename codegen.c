@@ -0,0 +1,62 @@
+/**
+ * Program that generates a static codec specialized to the Huffman table of a sample text.
+ * The generated '<name>_codec.c' is meant to be compiled together with the application
+ * that always uses the same (pre-trained) table.
+ * @file codegen.c
+ * @brief Usage: ./codegen <sample.txt> <name> [out_dir]
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tree_utils.h"
+#include "frequencies_utils.h"
+#include "codegen_utils.h"
+
+#define INPUT_SIZE 200000
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <sample.txt> <name> [out_dir]\n", argv[0]);
+        return 1;
+    }
+    char *out_dir = (argc > 3) ? argv[3] : ".";
+    char *input_string = (char *)calloc(sizeof(char), INPUT_SIZE + 1);
+    if (!read_input_string(input_string, INPUT_SIZE, argv[1]))
+        return 1;
+
+    /* Frequencies over byte values, so that the table is not bound to an alphabet */
+    int frequencies[256] = {0};
+    int i, len = strlen(input_string);
+    for (i = 0; i < len; i++)
+        frequencies[(unsigned char)input_string[i]]++;
+
+    char out_alphabet[256];
+    int out_freq[256], count = 0;
+    for (i = 0; i < 256; i++)
+    {
+        if (frequencies[i] != 0)
+        {
+            out_alphabet[count] = (char)i;
+            out_freq[count] = frequencies[i];
+            count++;
+        }
+    }
+    if (count == 0)
+    {
+        fprintf(stderr, "ERROR: empty sample!\n");
+        return 1;
+    }
+
+    struct MinHeapNode *root = HuffmanCodes(out_alphabet, out_freq, count);
+    if (!generate_static_codec(root, argv[2], out_dir))
+        return 1;
+
+    printf("Generated %s/%s_codec.c for %d symbols\n", out_dir, argv[2], count);
+    free(input_string);
+    return 0;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file codegen_utils.c
+ * @brief Implementation of static codec generator
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ */
+#include "codegen_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Node numbering used for the labels of the generated state machine */
+struct codegen_state
+{
+    struct MinHeapNode *nodes[512];            /* internal nodes in DFS order */
+    int count;                                 /* number of internal nodes */
+    char codes[256][CODEGEN_MAX_CODE_LEN + 1]; /* code-word of every byte */
+};
+
+/* Assigns a label to every internal node and collects the code-words */
+static bool collect_nodes(struct codegen_state *st, struct MinHeapNode *root, char arr[], int top)
+{
+    if (isLeaf(root))
+    {
+        arr[top] = '\0';
+        strcpy(st->codes[(unsigned char)root->data], arr);
+        return true;
+    }
+    if (top >= CODEGEN_MAX_CODE_LEN || st->count >= 512)
+    {
+        fprintf(stderr, "ERROR: tree too deep for code generation!\n");
+        return false;
+    }
+
+    st->nodes[st->count++] = root;
+    arr[top] = '0';
+    if (!collect_nodes(st, root->left, arr, top + 1))
+        return false;
+    arr[top] = '1';
+    return collect_nodes(st, root->right, arr, top + 1);
+}
+
+static int label_of(struct codegen_state *st, struct MinHeapNode *node)
+{
+    int i;
+    for (i = 0; i < st->count; i++)
+    {
+        if (st->nodes[i] == node)
+            return i;
+    }
+    return -1;
+}
+
+/* Writes the action taken when the walk reaches 'child' */
+static void emit_edge(FILE *fp, struct codegen_state *st, struct MinHeapNode *child)
+{
+    if (isLeaf(child))
+        fprintf(fp, "{ *o++ = (char)0x%02x; goto n0; }\n", (unsigned char)child->data);
+    else
+        fprintf(fp, "goto n%d;\n", label_of(st, child));
+}
+
+static bool emit_header(struct codegen_state *st, char *name, char *path)
+{
+    int i, max_len = 0;
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error writing file [%s].\n", path);
+        return false;
+    }
+    for (i = 0; i < 256; i++)
+    {
+        if ((int)strlen(st->codes[i]) > max_len)
+            max_len = strlen(st->codes[i]);
+    }
+
+    fprintf(fp, "/* Generated by codegen, do not edit. */\n");
+    fprintf(fp, "#ifndef %s_CODEC_H\n# define %s_CODEC_H\n\n", name, name);
+    fprintf(fp, "/* Longest code-word of the table */\n");
+    fprintf(fp, "#define %s_MAX_CODE_LEN %d\n\n", name, max_len);
+    fprintf(fp, "/* Encodes 'len' chars into '0'/'1' chars. Returns written chars or -1 on unknown symbol */\n");
+    fprintf(fp, "/* 'out' needs %s_MAX_CODE_LEN chars of slack: codes are copied with a fixed width */\n", name);
+    fprintf(fp, "int %s_encode(const char *in, int len, char *out);\n\n", name);
+    fprintf(fp, "/* Decodes 'len' '0'/'1' chars. Returns number of decoded chars */\n");
+    fprintf(fp, "int %s_decode(const char *in, int len, char *out);\n\n", name);
+    fprintf(fp, "#endif\n");
+    fclose(fp);
+    return true;
+}
+
+static bool emit_source(struct codegen_state *st, struct MinHeapNode *root, char *name, char *path)
+{
+    int i;
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error writing file [%s].\n", path);
+        return false;
+    }
+
+    fprintf(fp, "/* Generated by codegen, do not edit. */\n");
+    fprintf(fp, "#include <string.h>\n#include \"%s_codec.h\"\n\n", name);
+
+    /* Encode tables: lengths are compile time constants */
+    fprintf(fp, "static const unsigned char %s_code_len[256] = {", name);
+    for (i = 0; i < 256; i++)
+        fprintf(fp, "%s%d", (i == 0) ? "\n    " : (i % 16) ? ", " : ",\n    ", (int)strlen(st->codes[i]));
+    fprintf(fp, "\n};\n\n");
+    fprintf(fp, "static const char %s_codes[256][%s_MAX_CODE_LEN + 1] = {", name, name);
+    for (i = 0; i < 256; i++)
+        fprintf(fp, "%s\"%s\"", (i == 0) ? "\n    " : (i % 8) ? ", " : ",\n    ", st->codes[i]);
+    fprintf(fp, "\n};\n\n");
+
+    fprintf(fp, "int %s_encode(const char *in, int len, char *out)\n{\n", name);
+    fprintf(fp, "    char *o = out;\n    int i;\n");
+    fprintf(fp, "    for (i = 0; i < len; i++)\n    {\n");
+    fprintf(fp, "        unsigned char c = (unsigned char)in[i];\n");
+    fprintf(fp, "        if (%s_code_len[c] == 0)\n            return -1;\n", name);
+    fprintf(fp, "        memcpy(o, %s_codes[c], %s_MAX_CODE_LEN);\n", name, name);
+    fprintf(fp, "        o += %s_code_len[c];\n    }\n", name);
+    fprintf(fp, "    return o - out;\n}\n\n");
+
+    /* Decoder: one label per internal node, leaves are inlined */
+    fprintf(fp, "int %s_decode(const char *in, int len, char *out)\n{\n", name);
+    fprintf(fp, "    const char *p = in, *end = in + len;\n    char *o = out;\n");
+    if (isLeaf(root))
+    {
+        /* Degenerate tree: the only symbol is coded as a single char */
+        fprintf(fp, "    for (; p < end; p++)\n        *o++ = (char)0x%02x;\n", (unsigned char)root->data);
+        fprintf(fp, "    return o - out;\n}\n");
+        fclose(fp);
+        return true;
+    }
+    for (i = 0; i < st->count; i++)
+    {
+        fprintf(fp, "n%d:\n", i);
+        fprintf(fp, "    if (p == end)\n        goto done;\n");
+        fprintf(fp, "    if (*p++ == '0')\n        ");
+        emit_edge(fp, st, st->nodes[i]->left);
+        fprintf(fp, "    else\n        ");
+        emit_edge(fp, st, st->nodes[i]->right);
+    }
+    fprintf(fp, "done:\n    return o - out;\n}\n");
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief Emits '<name>_codec.c' and '<name>_codec.h' specialized to the given tree.
+ * 
+ * @param root root of Huff tree
+ * @param name prefix of generated symbols e.g "feed" produces feed_decode()
+ * @param out_dir directory in which save generated files e.g "." 
+ * @return true if both files were written
+ */
+bool generate_static_codec(struct MinHeapNode *root, char *name, char *out_dir)
+{
+    char arr[CODEGEN_MAX_CODE_LEN + 1];
+    char path[512];
+    bool res;
+    struct codegen_state *st = (struct codegen_state *)calloc(1, sizeof(struct codegen_state));
+
+    if (isLeaf(root))
+        strcpy(st->codes[(unsigned char)root->data], "0");
+    else if (!collect_nodes(st, root, arr, 0))
+    {
+        free(st);
+        return false;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s_codec.h", out_dir, name);
+    res = emit_header(st, name, path);
+    snprintf(path, sizeof(path), "%s/%s_codec.c", out_dir, name);
+    res = res && emit_source(st, root, name, path);
+    free(st);
+    return res;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file codegen_utils.h
+ * @brief Generator of C source code specialized to a fixed Huffman tree
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ */
+#include <stdbool.h>
+#include "tree_utils.h"
+
+#ifndef CODEGEN_H
+# define CODEGEN_H
+
+/* Longest code supported by the generated encode table */
+#define CODEGEN_MAX_CODE_LEN 64
+
+/**
+ * @brief Emits '<name>_codec.c' and '<name>_codec.h' specialized to the given tree.
+ * 
+ * The generated unit contains constant encode tables (codes and lengths indexed
+ * by byte value) and a decoder where the tree walk is unrolled into a goto
+ * state machine, one label per internal node. The decoder works on the same
+ * '0'/'1' encoded strings produced by calculate_huff_code().
+ * 
+ * @param root root of Huff tree
+ * @param name prefix of generated symbols e.g "feed" produces feed_decode()
+ * @param out_dir directory in which save generated files e.g "." 
+ * @return true if both files were written
+ */
+bool generate_static_codec(struct MinHeapNode *root, char *name, char *out_dir);
+
+#endif
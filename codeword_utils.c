@@ -0,0 +1,381 @@
+/**
+ * @file codeword_utils.c
+ * @brief Implementation of the code-word table, encoding and decoding of the string pipeline
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "codeword_utils.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+char alphabeth[sizeof(DEFAULT_ALPHABET)] = DEFAULT_ALPHABET;
+
+struct nlist codes_list[HASHSIZE];
+
+/* hash: returns the hash value for char s */
+unsigned hash(char s)
+{
+    char *ret;
+    int idx;
+    ret = strchr(alphabeth, s);
+    idx = strlen(alphabeth) - strlen(ret);
+    return idx;
+    
+}
+
+/* lookup: look for s in codes_list */
+bool lookup(char s)
+{
+    struct nlist np;
+    np = codes_list[hash(s)];
+    if (np.name == s)
+    {
+        return true; /* found */
+    }
+    else if (np.name != 0)
+    {
+        fprintf(stderr, "ERROR: Bad lookup. %c literal hash is already used by %c!\n", s, np.name);
+        exit(-1);
+    }
+    return false; /* not found */
+}
+
+/* install: put (name, code) in codes_list */
+bool install(char name, char *code)
+{
+    unsigned hashval;
+    if (!lookup(name))
+    { /* not found */
+        hashval = hash(name);
+        codes_list[hashval].name = name;
+        memcpy(codes_list[hashval].code, code, strlen(code));
+        return true;
+    }
+    return false;
+}
+
+/* Parallel function task based to create the code-word table
+ * This is another possible solution w.r.t the one used. More details
+ * can be found in the project report
+ */
+// void FillCodesList(struct MinHeapNode *root, char arr[], int top)
+// {
+//     // Assign 0 to left edge and recur
+//     if (root->left)
+//     {
+//         #pragma omp task firstprivate(root, arr, top) depend(out: top)
+//         {
+//             #pragma omp critical
+//                 arr[top] = '0';
+
+//             FillCodesList(root->left, arr, top + 1);
+//         }
+//     }
+
+//     // Assign 1 to right edge and recur
+//     if (root->right)
+//     {
+//         #pragma omp task firstprivate(root, arr, top) depend(in: top)
+//         {
+//             #pragma omp critical
+//                 arr[top] = '1';
+
+//             FillCodesList(root->right, arr, top + 1);
+//         }
+//     }
+
+//     // If this is a leaf node, then
+//     // it contains one of the input
+//     // characters, print the character
+//     // and its code from arr[]
+//     #pragma omp taskwait
+//     if (isLeaf(root))
+//     {
+//         arr[top] = '\0';
+//         bool res = install(root->data, arr);
+//         if (!res)
+//         {
+//             fprintf(stderr, "Bad install!\n");
+//             exit(-1);
+//         }
+//     }
+// }
+
+/* Serial function to create the code-word table */
+void FillCodesList(struct MinHeapNode *root, char arr[], int top)
+{
+    // Assign 0 to left edge and recur
+    if (root->left)
+    {
+        arr[top] = '0';
+        FillCodesList(root->left, arr, top + 1);
+    }
+
+    // Assign 1 to right edge and recur
+    if (root->right)
+    {
+        arr[top] = '1';
+        FillCodesList(root->right, arr, top + 1); 
+    }
+
+    // If this is a leaf node, then
+    // it contains one of the input
+    // characters, print the character
+    // and its code from arr[]
+    if (isLeaf(root))
+    {
+        arr[top] = '\0';
+        bool res = install(root->data, arr);
+        if (!res)
+        {
+            fprintf(stderr, "Bad install!\n");
+            exit(-1);
+        }
+    }
+}
+
+/**
+ * @brief Walks the code-table and returns the huffman code for a given string
+ *
+ * @param in_str 
+ * @return char* huff code
+ */
+char *calculate_huff_code(char *in_str)
+{
+    return calculate_huff_code_buf(in_str, NULL, NULL);
+}
+
+/**
+ * @brief Huffman code of a string into a buffer kept by the caller. The code length is
+ * summed first, so the buffer is allocated (or grown) once with the exact size
+ *
+ * @param in_str input string
+ * @param out buffer of a previous call, NULL for a new one
+ * @param capacity size of 'out', updated when it grows. NULL if 'out' is NULL
+ * @return char* huff code, NULL on allocation failure
+ */
+char *calculate_huff_code_buf(const char *in_str, char *out, size_t *capacity)
+{
+    const char *code[256] = {0};
+    size_t code_len[256] = {0}, total = 0, i, pos = 0;
+    size_t string_len = strlen(in_str);
+    const char *c;
+
+    /* Code of every literal of the alphabet, so the string is hashed once */
+    for (c = alphabeth; *c != '\0'; c++)
+    {
+        code[(unsigned char)*c] = codes_list[hash(*c)].code;
+        code_len[(unsigned char)*c] = strlen(code[(unsigned char)*c]);
+    }
+    for (i = 0; i < string_len; i++)
+        total += code_len[(unsigned char)in_str[i]];
+
+    if (out == NULL || capacity == NULL || *capacity < total + 1)
+    {
+        char *tmp = (char *)realloc(out, total + 1);
+        if (tmp == NULL)
+        {
+            fprintf(stderr, "ERROR: Huffman code allocation failed!\n");
+            return NULL;
+        }
+        out = tmp;
+        if (capacity != NULL)
+            *capacity = total + 1;
+    }
+    for (i = 0; i < string_len; i++)
+    {
+        memcpy(out + pos, code[(unsigned char)in_str[i]], code_len[(unsigned char)in_str[i]]);
+        pos += code_len[(unsigned char)in_str[i]];
+    }
+    out[pos] = '\0';
+    return out;
+}
+
+/**
+ * @brief Function to decode a piece of string. Called within parallel region.
+ * 
+ * @param root root of Huff tree
+ * @param in_string input string
+ * @param size_per_thread how much of the string to manage
+ * @param padding extra padding
+ * @param total_threads how many threads are available in total
+ * @param offset how much overlap between decoded strings of different threads
+ * @return struct decoded_node* 
+ */
+struct decoded_node *decode_string(struct MinHeapNode *root, char *in_string, int size_per_thread, int padding, int total_threads, int offset)
+{
+    return decode_slice(root, in_string, strlen(in_string), omp_get_thread_num(), size_per_thread, padding,
+                        total_threads, offset);
+}
+
+/* Decodes the candidates of a slice into 'd_node'. Candidate k is written at
+ * text + k * stride, or into its own allocation when 'text' is NULL */
+static bool decode_candidates(struct MinHeapNode *root, const char *in_string, int len, int slice, int size_per_slice,
+                              int padding, int last_slice, int offset, struct decoded_node *d_node, char *text,
+                              size_t stride)
+{
+    struct MinHeapNode *node = root;
+    char *local_string;
+    int initial_offset, end_offset, i, k, n, local_initial_offset;
+    initial_offset = slice * size_per_slice;
+    end_offset = initial_offset + size_per_slice;
+
+    /* Last slice will manage also padding */
+    if (last_slice == slice && padding > 0)
+        end_offset += padding;
+    if (end_offset > len)
+        end_offset = len;
+
+    /* Each slice will decode many candidate decode-strings. How many? up to 'offset' */
+    for (k = 0; k < offset; k++)
+    {
+        /* Those indices makes the ovelapping strategy for each slice */
+        local_initial_offset = initial_offset - k;
+        /* Every literal takes at least one bit */
+        local_string = (text != NULL) ? text + k * stride : (char *)malloc(end_offset - local_initial_offset + 1);
+        if (local_string == NULL)
+            return false;
+        int last_literal_index = 0;
+        n = 0;
+        node = root;
+        for (i = local_initial_offset; i < end_offset; i++)
+        {
+            if (in_string[i] == '0' && node->left != NULL)
+            {
+                node = node->left;
+            }
+            else if (node->right != NULL)
+            {
+                node = node->right;
+            }
+
+            if (isLeaf(node))
+            {
+                local_string[n++] = node->data;
+                node = root;
+                last_literal_index = i;
+            }
+        }
+        local_string[n] = '\0';
+        d_node[k].string = local_string;
+        d_node[k].padding_bits = (i - last_literal_index - 1);
+
+        /* Slice 0, since started from beginning produces only one string */
+        if (slice == 0)
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes slice 'slice' of the string, e.g a task of the work-stealing scheduler.
+ * Slice 0 produces one candidate, the others one for each of the 'offset' possible
+ * starting bits. Candidates are sized to the slice
+ * 
+ * @param root root of Huff tree
+ * @param in_string input string
+ * @param len length of the input string
+ * @param slice index of the slice
+ * @param size_per_slice how much of the string each slice manages
+ * @param padding extra padding, managed by the last slice
+ * @param last_slice index of the last slice
+ * @param offset how much overlap between decoded strings of different slices
+ * @return struct decoded_node* 
+ */
+struct decoded_node *decode_slice(struct MinHeapNode *root, const char *in_string, int len, int slice, int size_per_slice,
+                                  int padding, int last_slice, int offset)
+{
+    /* Pointer to different nodes. There are up to 'offset' nodes */
+    /* Each slice will have 'offset' number of different decoded strings */
+    struct decoded_node *d_node = (struct decoded_node *)malloc(sizeof(*d_node) * offset);
+    if (d_node != NULL)
+        decode_candidates(root, in_string, len, slice, size_per_slice, padding, last_slice, offset, d_node, NULL, 0);
+    return d_node;
+}
+
+/**
+ * @param dec decoder to initialize, it allocates on the first huff_string_decoder_reserve()
+ */
+void huff_string_decoder_init(struct huff_string_decoder *dec)
+{
+    memset(dec, 0, sizeof(struct huff_string_decoder));
+}
+
+/**
+ * @brief Makes room for the candidates of every slice of the next string. Buffers only
+ * grow, so a decoder that already decoded as large a string does not allocate
+ *
+ * @param dec the decoder
+ * @param nslices number of slices
+ * @param size_per_slice how much of the string each slice manages
+ * @param padding extra padding, managed by the last slice
+ * @param offset how much overlap between decoded strings of different slices
+ * @return true if allocation did not fail
+ */
+bool huff_string_decoder_reserve(struct huff_string_decoder *dec, int nslices, int size_per_slice, int padding,
+                                 int offset)
+{
+    /* A candidate starts up to 'offset' bits early, every literal takes at least one bit */
+    size_t stride = (size_t)size_per_slice + padding + offset + 1;
+    size_t text = (size_t)nslices * offset * stride;
+    if (nslices * offset > dec->nodes_capacity)
+    {
+        struct decoded_node *tmp = (struct decoded_node *)realloc(dec->nodes, nslices * offset * sizeof(*tmp));
+        if (tmp == NULL)
+            return false;
+        dec->nodes = tmp;
+        dec->nodes_capacity = nslices * offset;
+    }
+    if (text > dec->text_capacity)
+    {
+        char *tmp = (char *)realloc(dec->text, text);
+        if (tmp == NULL)
+            return false;
+        dec->text = tmp;
+        dec->text_capacity = text;
+    }
+    dec->stride = stride;
+    dec->offset = offset;
+    return true;
+}
+
+/**
+ * @brief Decodes slice 'slice' like decode_slice(), candidates are written into the decoder.
+ * Called within parallel region, after huff_string_decoder_reserve()
+ *
+ * @param dec the decoder
+ * @param root root of Huff tree
+ * @param in_string input string
+ * @param len length of the input string
+ * @param slice index of the slice
+ * @param size_per_slice how much of the string each slice manages
+ * @param padding extra padding, managed by the last slice
+ * @param last_slice index of the last slice
+ * @return struct decoded_node* candidates of the slice, owned by the decoder
+ */
+struct decoded_node *huff_string_decode_slice(struct huff_string_decoder *dec, struct MinHeapNode *root,
+                                              const char *in_string, int len, int slice, int size_per_slice,
+                                              int padding, int last_slice)
+{
+    struct decoded_node *d_node = dec->nodes + (size_t)slice * dec->offset;
+    decode_candidates(root, in_string, len, slice, size_per_slice, padding, last_slice, dec->offset, d_node,
+                      dec->text + (size_t)slice * dec->offset * dec->stride, dec->stride);
+    return d_node;
+}
+
+/**
+ * @brief Releases the decoder
+ *
+ * @param dec the decoder
+ */
+void huff_string_decoder_free(struct huff_string_decoder *dec)
+{
+    free(dec->nodes);
+    free(dec->text);
+    memset(dec, 0, sizeof(struct huff_string_decoder));
+}
@@ -0,0 +1,166 @@
+/**
+ * @file codeword_utils.h
+ * @brief Code-word table, encoding and decoding of the original string pipeline
+ *        (codes are strings of '0' and '1' chars). Shared by main and the kernel microbenchmark.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include "tree_utils.h"
+
+#ifndef CODEWORD_H
+# define CODEWORD_H
+
+/* This number should be calculated as "log2(length of alphabet)" */
+/* It is an upper-bound and represents  */
+
+#define SYMBOL_MAX_BITS 5
+
+/* Length of a single-code. Must be at least as SYMBOL_MAX_BITS */
+#define CODES_LEN 15
+
+
+/* Those constants comes from original Min-heap algorithm. */
+#define MAX_TREE_HT 100
+#define HASHSIZE 100
+
+/* This is the alphabet. If input-string contains additional characters, put them here */
+#define DEFAULT_ALPHABET "!#$&'()*+-.,/0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVZ[]^_abcdefghijklmnopqrstuvwxyz{|} "
+
+extern char alphabeth[sizeof(DEFAULT_ALPHABET)];
+
+struct nlist
+{                         /* table entry: */
+    char name;            /* defined char */
+    char code[CODES_LEN]; /* code */
+};
+extern struct nlist codes_list[HASHSIZE];
+
+/* This node is used into decoding phase. See 'decoded_node()' function */ 
+struct decoded_node
+{
+    char *string;     /* decoded string */
+    int padding_bits; /* bits needed to decode another valid literal */
+};
+
+/* Candidates of every slice of a string, kept between strings: a decoder reset with
+ * huff_string_decoder_reserve() does not allocate once it decoded as large a string */
+struct huff_string_decoder
+{
+    struct decoded_node *nodes; /* 'offset' candidates of every slice */
+    int nodes_capacity;         /* entries of 'nodes' */
+    char *text;                 /* decoded text of the candidates, 'stride' bytes each */
+    size_t text_capacity;       /* bytes of 'text' */
+    size_t stride;              /* bytes of a candidate */
+    int offset;                 /* candidates of a slice */
+};
+
+/* hash: returns the hash value for char s */
+unsigned hash(char s);
+
+/* lookup: look for s in codes_list */
+bool lookup(char s);
+
+/* install: put (name, code) in codes_list */
+bool install(char name, char *code);
+
+/* Serial function to create the code-word table */
+void FillCodesList(struct MinHeapNode *root, char arr[], int top);
+
+/**
+ * @brief Walks the code-table and returns the huffman code for a given string
+ *
+ * @param in_str 
+ * @return char* huff code
+ */
+char *calculate_huff_code(char *in_str);
+
+/**
+ * @brief Huffman code of a string into a buffer kept by the caller. The code length is
+ * summed first, so the buffer is allocated (or grown) once with the exact size
+ *
+ * @param in_str input string
+ * @param out buffer of a previous call, NULL for a new one
+ * @param capacity size of 'out', updated when it grows. NULL if 'out' is NULL
+ * @return char* huff code, NULL on allocation failure
+ */
+char *calculate_huff_code_buf(const char *in_str, char *out, size_t *capacity);
+
+/**
+ * @brief Function to decode a piece of string. Called within parallel region.
+ * 
+ * @param root root of Huff tree
+ * @param in_string input string
+ * @param size_per_thread how much of the string to manage
+ * @param padding extra padding
+ * @param total_threads how many threads are available in total
+ * @param offset how much overlap between decoded strings of different threads
+ * @return struct decoded_node* 
+ */
+struct decoded_node *decode_string(struct MinHeapNode *root, char *in_string, int size_per_thread, int padding, int total_threads, int offset);
+
+/**
+ * @brief Decodes slice 'slice' of the string, e.g a task of the work-stealing scheduler.
+ * Slice 0 produces one candidate, the others one for each of the 'offset' possible
+ * starting bits. Candidates are sized to the slice
+ * 
+ * @param root root of Huff tree
+ * @param in_string input string
+ * @param len length of the input string
+ * @param slice index of the slice
+ * @param size_per_slice how much of the string each slice manages
+ * @param padding extra padding, managed by the last slice
+ * @param last_slice index of the last slice
+ * @param offset how much overlap between decoded strings of different slices
+ * @return struct decoded_node* 
+ */
+struct decoded_node *decode_slice(struct MinHeapNode *root, const char *in_string, int len, int slice, int size_per_slice,
+                                  int padding, int last_slice, int offset);
+
+/**
+ * @param dec decoder to initialize, it allocates on the first huff_string_decoder_reserve()
+ */
+void huff_string_decoder_init(struct huff_string_decoder *dec);
+
+/**
+ * @brief Makes room for the candidates of every slice of the next string. Buffers only
+ * grow, so a decoder that already decoded as large a string does not allocate
+ *
+ * @param dec the decoder
+ * @param nslices number of slices
+ * @param size_per_slice how much of the string each slice manages
+ * @param padding extra padding, managed by the last slice
+ * @param offset how much overlap between decoded strings of different slices
+ * @return true if allocation did not fail
+ */
+bool huff_string_decoder_reserve(struct huff_string_decoder *dec, int nslices, int size_per_slice, int padding,
+                                 int offset);
+
+/**
+ * @brief Decodes slice 'slice' like decode_slice(), candidates are written into the decoder.
+ * Called within parallel region, after huff_string_decoder_reserve()
+ *
+ * @param dec the decoder
+ * @param root root of Huff tree
+ * @param in_string input string
+ * @param len length of the input string
+ * @param slice index of the slice
+ * @param size_per_slice how much of the string each slice manages
+ * @param padding extra padding, managed by the last slice
+ * @param last_slice index of the last slice
+ * @return struct decoded_node* candidates of the slice, owned by the decoder
+ */
+struct decoded_node *huff_string_decode_slice(struct huff_string_decoder *dec, struct MinHeapNode *root,
+                                              const char *in_string, int len, int slice, int size_per_slice,
+                                              int padding, int last_slice);
+
+/**
+ * @brief Releases the decoder
+ *
+ * @param dec the decoder
+ */
+void huff_string_decoder_free(struct huff_string_decoder *dec);
+
+#endif
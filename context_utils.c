@@ -0,0 +1,156 @@
+/**
+ * @file context_utils.c
+ * @brief Implementation of order-1 coding
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "context_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @param m model to initialize
+ * @param nclasses HUFF_CONTEXT_ORDER1, or fewer classes to hash previous bytes into
+ * @return true if allocation did not fail
+ */
+bool huff_context_init(struct huff_context_model *m, int nclasses)
+{
+    int i;
+    if (nclasses < 1 || nclasses > HUFF_CONTEXT_ORDER1)
+    {
+        fprintf(stderr, "ERROR: %d contexts out of range!\n", nclasses);
+        return false;
+    }
+    m->nclasses = nclasses;
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+        m->class_of[i] = (nclasses == HUFF_CONTEXT_ORDER1) ? i : ((i * 2654435761u) >> 24) % nclasses;
+
+    m->tables = (struct huff_table *)calloc(nclasses, sizeof(struct huff_table));
+    if (m->tables == NULL)
+        return false;
+    for (i = 0; i < nclasses; i++)
+    {
+        if (!huff_table_init(&m->tables[i], HUFF_BYTE_SYMBOLS))
+        {
+            huff_context_free(m);
+            return false;
+        }
+    }
+    return true;
+}
+
+void huff_context_free(struct huff_context_model *m)
+{
+    int i;
+    for (i = 0; m->tables != NULL && i < m->nclasses; i++)
+        huff_table_free(&m->tables[i]);
+    free(m->tables);
+    m->tables = NULL;
+}
+
+/**
+ * @brief 2D histogram: freq[context * 256 + byte]. The first byte has context of byte 0.
+ *
+ * @param m the model
+ * @param in input buffer
+ * @param len input size
+ * @param freq location in which accumulate nclasses * 256 frequencies
+ */
+void huff_context_histogram(const struct huff_context_model *m, const unsigned char *in, size_t len, unsigned int *freq)
+{
+    unsigned char prev = 0;
+    size_t i;
+    for (i = 0; i < len; i++)
+    {
+        freq[m->class_of[prev] * HUFF_BYTE_SYMBOLS + in[i]]++;
+        prev = in[i];
+    }
+}
+
+/**
+ * @brief Builds one table per context
+ *
+ * @param m the model
+ * @param freq 2D histogram e.g reduced over all processes
+ * @return true if all tables are valid
+ */
+bool huff_context_build(struct huff_context_model *m, const unsigned int *freq)
+{
+    int c, failed = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(+ : failed)
+    for (c = 0; c < m->nclasses; c++)
+    {
+        if (!huff_table_from_freq(&m->tables[c], freq + c * HUFF_BYTE_SYMBOLS, HUFF_DEFAULT_MAX_BITS))
+            failed++;
+    }
+    return failed == 0;
+}
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by huff_context_encode()
+ */
+size_t huff_context_bound(size_t len)
+{
+    return (len * HUFF_DEFAULT_MAX_BITS + 7) / 8;
+}
+
+/**
+ * @brief Encodes a buffer, each byte with the table of its context
+ *
+ * @param m the model
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least huff_context_bound(len) bytes
+ * @return written bytes, 0 if a byte has no code into its context
+ */
+size_t huff_context_encode(const struct huff_context_model *m, const unsigned char *in, size_t len, unsigned char *out)
+{
+    struct bit_writer w;
+    unsigned char prev = 0;
+    size_t i;
+    bw_init(&w, out);
+    for (i = 0; i < len; i++)
+    {
+        const struct huff_table *t = &m->tables[m->class_of[prev]];
+        if (t->lengths[in[i]] == 0)
+        {
+            fprintf(stderr, "ERROR: byte %d has no code after byte %d!\n", in[i], prev);
+            return 0;
+        }
+        bw_put(&w, t->codes[in[i]], t->lengths[in[i]]);
+        prev = in[i];
+    }
+    return bw_flush(&w);
+}
+
+/**
+ * @brief Decodes exactly 'out_len' bytes. Switching table costs one index per byte
+ *
+ * @param m the model
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool huff_context_decode(const struct huff_context_model *m, const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len)
+{
+    struct bit_reader r;
+    unsigned char prev = 0;
+    size_t i;
+    br_init(&r, in, in_len);
+    for (i = 0; i < out_len; i++)
+    {
+        br_refill(&r);
+        int symbol = huff_decode_symbol(&m->tables[m->class_of[prev]], &r);
+        if (symbol < 0)
+            return false;
+        out[i] = prev = symbol;
+    }
+    return br_consumed(&r) <= in_len * 8;
+}
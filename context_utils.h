@@ -0,0 +1,86 @@
+/**
+ * @file context_utils.h
+ * @brief Order-1 coding: the table of a byte is selected by the previous byte
+ *        (or by a hashed class of it)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include "codec_utils.h"
+
+#ifndef CONTEXT_H
+# define CONTEXT_H
+
+/* One context per previous byte */
+#define HUFF_CONTEXT_ORDER1 256
+
+/* Order-1 model: one canonical table per context */
+struct huff_context_model
+{
+    int nclasses;              /* number of contexts, HUFF_CONTEXT_ORDER1 or less */
+    unsigned char class_of[HUFF_BYTE_SYMBOLS]; /* context of each previous byte */
+    struct huff_table *tables; /* one table per context */
+};
+
+/**
+ * @param m model to initialize
+ * @param nclasses HUFF_CONTEXT_ORDER1, or fewer classes to hash previous bytes into
+ * @return true if allocation did not fail
+ */
+bool huff_context_init(struct huff_context_model *m, int nclasses);
+void huff_context_free(struct huff_context_model *m);
+
+/**
+ * @brief 2D histogram: freq[context * 256 + byte]. The first byte has context of byte 0.
+ * Caller must zero 'freq'
+ *
+ * @param m the model
+ * @param in input buffer
+ * @param len input size
+ * @param freq location in which accumulate nclasses * 256 frequencies
+ */
+void huff_context_histogram(const struct huff_context_model *m, const unsigned char *in, size_t len, unsigned int *freq);
+
+/**
+ * @brief Builds one table per context
+ *
+ * @param m the model
+ * @param freq 2D histogram e.g reduced over all processes
+ * @return true if all tables are valid
+ */
+bool huff_context_build(struct huff_context_model *m, const unsigned int *freq);
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by huff_context_encode()
+ */
+size_t huff_context_bound(size_t len);
+
+/**
+ * @brief Encodes a buffer, each byte with the table of its context
+ *
+ * @param m the model
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least huff_context_bound(len) bytes
+ * @return written bytes, 0 if a byte has no code into its context
+ */
+size_t huff_context_encode(const struct huff_context_model *m, const unsigned char *in, size_t len, unsigned char *out);
+
+/**
+ * @brief Decodes exactly 'out_len' bytes
+ *
+ * @param m the model
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param out output buffer of 'out_len' bytes
+ * @param out_len number of bytes to decode
+ * @return true if the input is a valid encoding
+ */
+bool huff_context_decode(const struct huff_context_model *m, const unsigned char *in, size_t in_len, unsigned char *out, size_t out_len);
+
+#endif
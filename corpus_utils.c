@@ -0,0 +1,257 @@
+/**
+ * @file corpus_utils.c
+ * @brief Implementation of the synthetic corpora
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "corpus_utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Most common English words, by decreasing frequency */
+static const char *english_words[] = {
+    "the", "of", "and", "to", "a", "in", "is", "it", "you", "that", "he", "was", "for", "on", "are",
+    "with", "as", "his", "they", "be", "at", "one", "have", "this", "from", "or", "had", "by", "not",
+    "word", "but", "what", "some", "we", "can", "out", "other", "were", "all", "there", "when", "up",
+    "use", "your", "how", "said", "an", "each", "she", "which", "do", "their", "time", "if", "will",
+    "way", "about", "many", "then", "them", "write", "would", "like", "so", "these", "her", "long",
+    "make", "thing", "see", "him", "two", "has", "look", "more", "day", "could", "go", "come", "did",
+    "number", "sound", "no", "most", "people", "my", "over", "know", "water", "than", "call", "first",
+    "who", "may", "down", "side", "been", "now", "find", "any", "new", "work", "part", "take", "get",
+    "place", "made", "live", "where", "after", "back", "little", "only", "round", "man", "year",
+    "came", "show", "every", "good", "me", "give", "our", "under", "name", "very", "through", "just",
+    "form", "sentence", "great", "think", "say", "help", "low", "line", "differ", "turn", "cause",
+    "much", "mean", "before", "move", "right", "boy", "old", "too", "same", "tell", "does", "set",
+    "three", "want", "air", "well", "also", "play", "small", "end", "put", "home", "read", "hand",
+    "port", "large", "spell", "add", "even", "land", "here", "must", "big", "high", "such", "follow",
+    "act", "why", "ask", "men", "change", "went", "light", "kind", "off", "need", "house", "picture",
+    "try", "us", "again", "animal", "point", "mother", "world", "near", "build", "self", "earth",
+    "father", "head", "stand", "own", "page", "should", "country", "found", "answer", "school",
+    "grow", "study", "still", "learn", "plant", "cover", "food", "sun", "four", "between", "state",
+    "keep", "eye", "never", "last", "let", "thought", "city", "tree", "cross", "farm", "hard",
+    "start", "might", "story", "saw", "far", "sea", "draw", "left", "late", "run", "while", "press",
+    "close", "night", "real", "life", "few", "north", "open", "seem", "together", "next", "white",
+    "children", "begin", "got", "walk", "example", "ease", "paper", "group", "always", "music",
+    "those", "both", "mark", "often", "letter", "until", "mile", "river", "car", "feet", "care",
+    "second", "book", "carry", "took", "science", "eat", "room", "friend", "began", "idea", "fish"};
+
+#define ENGLISH_WORDS (int)(sizeof(english_words) / sizeof(english_words[0]))
+
+/* xorshift64* */
+static uint64_t next_random(struct corpus_gen *g)
+{
+    g->state ^= g->state >> 12;
+    g->state ^= g->state << 25;
+    g->state ^= g->state >> 27;
+    return g->state * 2685821657736338717ULL;
+}
+
+/* Uniform double in [0, 1) */
+static double next_double(struct corpus_gen *g)
+{
+    return (next_random(g) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Index drawn from the cumulative probabilities */
+static int draw(struct corpus_gen *g)
+{
+    double u = next_double(g);
+    int lo = 0, hi = g->ncdf - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (g->cdf[mid] > u)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+/* Cumulative Zipf probabilities of 'n' ranks */
+static void zipf_cdf(struct corpus_gen *g, int n, double s)
+{
+    double sum = 0;
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        sum += 1.0 / pow(i + 1, s);
+        g->cdf[i] = sum;
+    }
+    for (i = 0; i < n; i++)
+        g->cdf[i] /= sum;
+    g->cdf[n - 1] = 1.0;
+    g->ncdf = n;
+}
+
+/**
+ * @brief Parses a corpus name: uniform, zipf, english, binary
+ *
+ * @param name the name
+ * @param kind location in which save the kind
+ * @return true if the name is known
+ */
+bool corpus_parse_kind(const char *name, enum corpus_kind *kind)
+{
+    enum corpus_kind k;
+    for (k = CORPUS_UNIFORM; k <= CORPUS_BINARY; k++)
+    {
+        if (strcmp(name, corpus_kind_name(k)) == 0)
+        {
+            *kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @param kind the kind
+ * @return name of the kind
+ */
+const char *corpus_kind_name(enum corpus_kind kind)
+{
+    switch (kind)
+    {
+    case CORPUS_UNIFORM:
+        return "uniform";
+    case CORPUS_ZIPF:
+        return "zipf";
+    case CORPUS_ENGLISH:
+        return "english";
+    default:
+        return "binary";
+    }
+}
+
+/**
+ * @brief Parses a size with an optional K, M or G suffix (powers of 1024)
+ *
+ * @param text the size
+ * @return size in bytes, 0 on error
+ */
+size_t corpus_parse_size(const char *text)
+{
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || value <= 0)
+        return 0;
+    switch (*end)
+    {
+    case 'G':
+    case 'g':
+        value *= 1024;
+        /* fall through */
+    case 'M':
+    case 'm':
+        value *= 1024;
+        /* fall through */
+    case 'K':
+    case 'k':
+        value *= 1024;
+        break;
+    case '\0':
+        break;
+    default:
+        return 0;
+    }
+    return (size_t)value;
+}
+
+/**
+ * @brief Initializes a generator. Same arguments give the same bytes
+ *
+ * @param g generator to initialize
+ * @param kind kind of corpus
+ * @param alphabet symbols of uniform and Zipf corpora, 2 to 256
+ * @param zipf_s exponent of Zipf corpora e.g 1.0
+ * @param seed random seed
+ * @return true if arguments are valid
+ */
+bool corpus_init(struct corpus_gen *g, enum corpus_kind kind, int alphabet, double zipf_s, uint64_t seed)
+{
+    if (alphabet < 2 || alphabet > 256)
+    {
+        fprintf(stderr, "ERROR: Alphabet must have 2 to 256 symbols!\n");
+        return false;
+    }
+    g->kind = kind;
+    g->alphabet = alphabet;
+    g->capital = true;
+    g->ncdf = 0;
+    /* splitmix64 of the seed, state must not be zero */
+    g->state = seed + 0x9E3779B97F4A7C15ULL;
+    g->state = (g->state ^ (g->state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    g->state = (g->state ^ (g->state >> 27)) * 0x94D049BB133111EBULL;
+    g->state ^= g->state >> 31;
+    if (g->state == 0)
+        g->state = 1;
+
+    if (kind == CORPUS_ZIPF)
+        zipf_cdf(g, alphabet, zipf_s);
+    else if (kind == CORPUS_ENGLISH)
+        zipf_cdf(g, ENGLISH_WORDS, 1.0);
+    return true;
+}
+
+/* Symbol 'i' of uniform and Zipf corpora: printable chars when they are enough */
+static unsigned char symbol_byte(const struct corpus_gen *g, int i)
+{
+    return (g->alphabet <= 94) ? (unsigned char)('!' + i) : (unsigned char)i;
+}
+
+/**
+ * @brief Writes the next 'len' bytes of the corpus
+ *
+ * @param g the generator
+ * @param out output buffer
+ * @param len number of bytes
+ */
+void corpus_fill(struct corpus_gen *g, unsigned char *out, size_t len)
+{
+    size_t pos = 0;
+    switch (g->kind)
+    {
+    case CORPUS_UNIFORM:
+        for (pos = 0; pos < len; pos++)
+            out[pos] = symbol_byte(g, next_random(g) % g->alphabet);
+        break;
+    case CORPUS_ZIPF:
+        for (pos = 0; pos < len; pos++)
+            out[pos] = symbol_byte(g, draw(g));
+        break;
+    case CORPUS_BINARY:
+        while (pos < len)
+        {
+            /* Mostly small counters, sometimes a full random word */
+            uint64_t r = next_random(g);
+            uint32_t value = ((r & 0xf) == 0) ? (uint32_t)(r >> 32) : (uint32_t)((r >> 8) & ((1u << (r >> 60)) - 1));
+            int i;
+            for (i = 0; i < 4 && pos < len; i++)
+                out[pos++] = (value >> (8 * i)) & 0xff;
+        }
+        break;
+    default:
+        while (pos < len)
+        {
+            const char *word = english_words[draw(g)];
+            size_t n = strlen(word);
+            uint64_t r = next_random(g);
+            char sep = (r % 13 == 0) ? '.' : (r % 7 == 0) ? ',' : ' ';
+            size_t i;
+            for (i = 0; i < n && pos < len; i++)
+                out[pos++] = (i == 0 && g->capital) ? word[i] - 'a' + 'A' : word[i];
+            g->capital = false;
+            if (sep != ' ' && pos < len)
+                out[pos++] = sep;
+            if (pos < len)
+                out[pos++] = ((r >> 32) % 11 == 0) ? '\n' : ' ';
+            if (sep == '.')
+                g->capital = true;
+        }
+        break;
+    }
+}
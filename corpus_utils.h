@@ -0,0 +1,82 @@
+/**
+ * @file corpus_utils.h
+ * @brief Deterministic synthetic corpora of controlled entropy for benchmarks
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CORPUS_H
+# define CORPUS_H
+
+/* Max number of ranks of a Zipf distribution: symbols or words */
+#define CORPUS_MAX_RANKS 512
+
+/* Kinds of corpus */
+enum corpus_kind
+{
+    CORPUS_UNIFORM, /* symbols of the alphabet with the same probability */
+    CORPUS_ZIPF,    /* symbol of rank k has probability proportional to 1 / k^s */
+    CORPUS_ENGLISH, /* words drawn with Zipf frequencies, punctuation and lines */
+    CORPUS_BINARY   /* little endian 32-bit records of small values, as in binary dumps */
+};
+
+/* Generator state */
+struct corpus_gen
+{
+    enum corpus_kind kind;        /* kind of corpus */
+    int alphabet;                 /* number of symbols of uniform and Zipf corpora */
+    uint64_t state;               /* random generator state */
+    double cdf[CORPUS_MAX_RANKS]; /* cumulative probabilities of symbols or words */
+    int ncdf;                     /* entries of 'cdf' */
+    bool capital;                 /* english: next word starts a sentence */
+};
+
+/**
+ * @brief Parses a corpus name: uniform, zipf, english, binary
+ *
+ * @param name the name
+ * @param kind location in which save the kind
+ * @return true if the name is known
+ */
+bool corpus_parse_kind(const char *name, enum corpus_kind *kind);
+
+/**
+ * @param kind the kind
+ * @return name of the kind
+ */
+const char *corpus_kind_name(enum corpus_kind kind);
+
+/**
+ * @brief Parses a size with an optional K, M or G suffix (powers of 1024)
+ *
+ * @param text the size
+ * @return size in bytes, 0 on error
+ */
+size_t corpus_parse_size(const char *text);
+
+/**
+ * @brief Initializes a generator. Same arguments give the same bytes
+ *
+ * @param g generator to initialize
+ * @param kind kind of corpus
+ * @param alphabet symbols of uniform and Zipf corpora, 2 to 256
+ * @param zipf_s exponent of Zipf corpora e.g 1.0
+ * @param seed random seed
+ * @return true if arguments are valid
+ */
+bool corpus_init(struct corpus_gen *g, enum corpus_kind kind, int alphabet, double zipf_s, uint64_t seed);
+
+/**
+ * @brief Writes the next 'len' bytes of the corpus
+ *
+ * @param g the generator
+ * @param out output buffer
+ * @param len number of bytes
+ */
+void corpus_fill(struct corpus_gen *g, unsigned char *out, size_t len);
+
+#endif
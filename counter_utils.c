@@ -0,0 +1,151 @@
+/**
+ * @file counter_utils.c
+ * @brief Implementation of the hardware performance counters
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "counter_utils.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+static const char *event_names[COUNTER_EVENTS] = {"cycles", "instructions", "branch_misses", "llc_misses"};
+
+/* Reason of the last failed open */
+static char last_error[128] = "";
+
+#ifdef __linux__
+static const uint64_t event_configs[COUNTER_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+#endif
+
+/**
+ * @brief Opens the counters of the calling thread (user space only)
+ *
+ * @param g group to initialize
+ * @return true if at least one event is available
+ */
+bool counters_open(struct counter_group *g)
+{
+    int e;
+    g->leader = -1;
+    g->nopen = 0;
+    for (e = 0; e < COUNTER_EVENTS; e++)
+    {
+        g->fd[e] = -1;
+        g->slot[e] = -1;
+    }
+#ifdef __linux__
+    for (e = 0; e < COUNTER_EVENTS; e++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = event_configs[e];
+        attr.disabled = (g->leader < 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+
+        /* Calling thread, any cpu. Events missing on this machine are skipped */
+        int fd = syscall(SYS_perf_event_open, &attr, 0, -1, g->leader, 0);
+        if (fd < 0)
+        {
+            snprintf(last_error, sizeof(last_error), "%s: %s", event_names[e], strerror(errno));
+            continue;
+        }
+        if (g->leader < 0)
+            g->leader = fd;
+        g->fd[e] = fd;
+        g->slot[e] = g->nopen++;
+    }
+    if (g->leader < 0)
+        return false;
+    ioctl(g->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(g->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    snprintf(last_error, sizeof(last_error), "perf_event_open needs Linux");
+    return false;
+#endif
+}
+
+/**
+ * @brief Reads the current values. Unavailable events read as 0
+ *
+ * @param g the group
+ * @param values location in which save COUNTER_EVENTS values
+ * @return true if the read succeeded
+ */
+bool counters_read(const struct counter_group *g, uint64_t *values)
+{
+    int e;
+    for (e = 0; e < COUNTER_EVENTS; e++)
+        values[e] = 0;
+#ifdef __linux__
+    /* Group read format: number of events, then their values */
+    uint64_t buf[1 + COUNTER_EVENTS];
+    if (g->leader < 0 || read(g->leader, buf, sizeof(buf)) < (ssize_t)((1 + g->nopen) * sizeof(uint64_t)))
+        return false;
+    for (e = 0; e < COUNTER_EVENTS; e++)
+    {
+        if (g->slot[e] >= 0)
+            values[e] = buf[1 + g->slot[e]];
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @param g the group
+ * @param event the event
+ * @return true if the event is counted
+ */
+bool counters_available(const struct counter_group *g, enum counter_event event)
+{
+    return g->fd[event] >= 0;
+}
+
+void counters_close(struct counter_group *g)
+{
+    int e;
+    for (e = COUNTER_EVENTS - 1; e >= 0; e--)
+    {
+#ifdef __linux__
+        if (g->fd[e] >= 0)
+            close(g->fd[e]);
+#endif
+        g->fd[e] = -1;
+        g->slot[e] = -1;
+    }
+    g->leader = -1;
+    g->nopen = 0;
+}
+
+/**
+ * @param event the event
+ * @return name of the event
+ */
+const char *counter_event_name(enum counter_event event)
+{
+    return event_names[event];
+}
+
+/**
+ * @return reason of the last failed open, empty if none
+ */
+const char *counters_error(void)
+{
+    return last_error;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file counter_utils.h
+ * @brief Hardware performance counters of the calling thread (Linux perf_event_open).
+ *        Events that can not be opened are reported as unavailable.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef COUNTER_H
+# define COUNTER_H
+
+/* Counted events */
+enum counter_event
+{
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_EVENTS
+};
+
+/* Counters of one thread, read together with a single system call */
+struct counter_group
+{
+    int leader;                    /* file descriptor of the group, -1 if no event is open */
+    int fd[COUNTER_EVENTS];        /* file descriptor of each event, -1 if unavailable */
+    int slot[COUNTER_EVENTS];      /* position of each event into the group read */
+    int nopen;                     /* number of open events */
+};
+
+/**
+ * @brief Opens the counters of the calling thread (user space only)
+ *
+ * @param g group to initialize
+ * @return true if at least one event is available
+ */
+bool counters_open(struct counter_group *g);
+
+/**
+ * @brief Reads the current values. Unavailable events read as 0
+ *
+ * @param g the group
+ * @param values location in which save COUNTER_EVENTS values
+ * @return true if the read succeeded
+ */
+bool counters_read(const struct counter_group *g, uint64_t *values);
+
+/**
+ * @param g the group
+ * @param event the event
+ * @return true if the event is counted
+ */
+bool counters_available(const struct counter_group *g, enum counter_event event);
+
+void counters_close(struct counter_group *g);
+
+/**
+ * @param event the event
+ * @return name of the event
+ */
+const char *counter_event_name(enum counter_event event);
+
+/**
+ * @return reason of the last failed open, empty if none
+ */
+const char *counters_error(void);
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file crc_utils.c
+ * @brief Implementation of the CRC32C checksums
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "crc_utils.h"
+#include <stdatomic.h>
+#include <string.h>
+#if defined(__x86_64__)
+# include <nmmintrin.h>
+#endif
+
+/* Slicing-by-8 tables: table[k][b] is the checksum of byte b followed by k zero bytes */
+static uint32_t crc_table[8][256];
+static atomic_int tables_ready;
+
+/* Fills the tables on first use, threads may call it concurrently */
+static void init_tables(void)
+{
+    int b, k;
+    if (atomic_load(&tables_ready))
+        return;
+    #pragma omp critical(huff_crc_tables)
+    if (!atomic_load(&tables_ready))
+    {
+        for (b = 0; b < 256; b++)
+        {
+            uint32_t crc = b;
+            for (k = 0; k < 8; k++)
+                crc = (crc & 1) ? (crc >> 1) ^ HUFF_CRC32C_POLY : crc >> 1;
+            crc_table[0][b] = crc;
+        }
+        for (b = 0; b < 256; b++)
+        {
+            for (k = 1; k < 8; k++)
+                crc_table[k][b] = (crc_table[k - 1][b] >> 8) ^ crc_table[0][crc_table[k - 1][b] & 0xFF];
+        }
+        atomic_store(&tables_ready, 1);
+    }
+}
+
+/* Eight bytes per step with the tables */
+static uint32_t crc_software(uint32_t crc, const unsigned char *p, size_t len)
+{
+    init_tables();
+    while (len >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        word ^= crc;
+        crc = crc_table[7][word & 0xFF] ^ crc_table[6][(word >> 8) & 0xFF] ^
+              crc_table[5][(word >> 16) & 0xFF] ^ crc_table[4][(word >> 24) & 0xFF] ^
+              crc_table[3][(word >> 32) & 0xFF] ^ crc_table[2][(word >> 40) & 0xFF] ^
+              crc_table[1][(word >> 48) & 0xFF] ^ crc_table[0][word >> 56];
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0)
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(__x86_64__)
+/* Eight bytes per crc32 instruction */
+__attribute__((target("sse4.2"))) static uint32_t crc_hardware(uint32_t crc, const unsigned char *p, size_t len)
+{
+    uint64_t c = crc;
+    while (len >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        c = _mm_crc32_u64(c, word);
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0)
+        c = _mm_crc32_u8((uint32_t)c, *p++);
+    return (uint32_t)c;
+}
+#endif
+
+/**
+ * @return 1 if the crc32 instruction is used, 0 for the tables
+ */
+int huff_crc32c_hardware(void)
+{
+#if defined(__x86_64__)
+    return __builtin_cpu_supports("sse4.2") != 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Extends a CRC32C with the bytes of a buffer
+ *
+ * @param crc checksum of the previous bytes, 0 for the first buffer
+ * @param buf the buffer
+ * @param len buffer size
+ * @return checksum of the previous bytes followed by the buffer
+ */
+uint32_t huff_crc32c(uint32_t crc, const void *buf, size_t len)
+{
+    crc = ~crc;
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2"))
+        return ~crc_hardware(crc, (const unsigned char *)buf, len);
+#endif
+    return ~crc_software(crc, (const unsigned char *)buf, len);
+}
+
+/* Product of two polynomials modulo the CRC polynomial, bit 31 is x^0 */
+static uint32_t multmodp(uint32_t a, uint32_t b)
+{
+    uint32_t m = 1u << 31, p = 0;
+    while (m != 0)
+    {
+        if (a & m)
+            p ^= b;
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ HUFF_CRC32C_POLY : b >> 1;
+    }
+    return p;
+}
+
+/**
+ * @brief Checksum of two consecutive buffers from their checksums, without their bytes
+ *
+ * @param crc1 checksum of the first buffer
+ * @param crc2 checksum of the second buffer
+ * @param len2 size of the second buffer
+ * @return checksum of the concatenation
+ */
+uint32_t huff_crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2)
+{
+    /* crc1 shifted by len2 zero bytes, i.e multiplied by x^(8 * len2) */
+    uint32_t power = 1u << 31, square = 1u << 23;
+    while (len2 != 0)
+    {
+        if (len2 & 1)
+            power = multmodp(square, power);
+        square = multmodp(square, square);
+        len2 >>= 1;
+    }
+    return multmodp(power, crc1) ^ crc2;
+}
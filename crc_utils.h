@@ -0,0 +1,44 @@
+/**
+ * @file crc_utils.h
+ * @brief CRC32C (Castagnoli) checksums of blocks: SSE4.2 crc32 instruction when the cpu
+ *        has it, slicing-by-8 tables otherwise, and combination of the checksums of
+ *        consecutive buffers into the checksum of their concatenation
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CRC_H
+# define CRC_H
+
+/* Reflected CRC32C polynomial */
+#define HUFF_CRC32C_POLY 0x82F63B78u
+
+/**
+ * @brief Extends a CRC32C with the bytes of a buffer
+ *
+ * @param crc checksum of the previous bytes, 0 for the first buffer
+ * @param buf the buffer
+ * @param len buffer size
+ * @return checksum of the previous bytes followed by the buffer
+ */
+uint32_t huff_crc32c(uint32_t crc, const void *buf, size_t len);
+
+/**
+ * @brief Checksum of two consecutive buffers from their checksums, without their bytes
+ *
+ * @param crc1 checksum of the first buffer
+ * @param crc2 checksum of the second buffer
+ * @param len2 size of the second buffer
+ * @return checksum of the concatenation
+ */
+uint32_t huff_crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+/**
+ * @return 1 if the crc32 instruction is used, 0 for the tables
+ */
+int huff_crc32c_hardware(void);
+
+#endif
@@ -20,6 +20,7 @@
 #include <stddef.h>
 #include "tree_utils.h"
 #include "frequencies_utils.h"
+#include "wide_utils.h"
 
 #define INPUT_SIZE 2000
 #define REALLOC_OFFSET 5
@@ -31,14 +32,6 @@
 #define CODES_LEN 15
 
 
-// A Huffman tree node
-struct MinHeapNode
-{
-    char data;                          /* defined char */
-    unsigned freq;                      /* frequency */
-    struct MinHeapNode *left, *right;   /* pointers to left and right nodes */
-};
-
 struct nlist
 {                         
     char name;            /* defined char */
@@ -151,9 +144,73 @@ char *calculate_huff_code(char *in_str)
 }
 
 
+/**
+ * @brief Codes the whole text by UTF-8 code points, so that characters such
+ * as 'ìèéòàù' are single symbols instead of being split into bytes
+ *
+ * @param filename text to code
+ * @return 0 if decoded text equals the input
+ */
+int run_utf8_mode(char *filename)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error reading textfile [%s].\n", filename);
+        return 1;
+    }
+    /* The whole file: a fixed size read would cut the last code point */
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    unsigned char *input = (size >= 0) ? (unsigned char *)malloc(size + 1) : NULL;
+    size_t len = (input != NULL) ? fread(input, 1, size, fp) : 0;
+    fclose(fp);
+    if (input == NULL || len != (size_t)size)
+    {
+        fprintf(stderr, "Error reading textfile [%s].\n", filename);
+        free(input);
+        return 1;
+    }
+    printf("Read %zu bytes from [%s]\n", len, filename);
+
+    struct huff_wide_codec codec;
+    size_t nsymbols, decoded_len;
+    if (!huff_wide_init(&codec, HUFF_SYMBOLS_UTF8))
+    {
+        free(input);
+        return 1;
+    }
+    if (!huff_wide_build(&codec, input, len))
+    {
+        huff_wide_free(&codec);
+        free(input);
+        return 1;
+    }
+
+    unsigned char *coded = (unsigned char *)malloc(huff_wide_bound(len) + 1);
+    unsigned char *decoded = (unsigned char *)malloc(len + 1);
+    size_t coded_len = huff_wide_encode(&codec, input, len, coded, &nsymbols);
+    bool ok = huff_wide_decode(&codec, coded, coded_len, nsymbols, decoded, len, &decoded_len);
+
+    printf("Distinct code points: %d, max code length: %d\n", codec.nsymbols, codec.table.max_bits);
+    printf("Input %zu bytes, %zu symbols, coded %zu bytes\n", len, nsymbols, coded_len);
+    int res = (ok && decoded_len == len) ? memcmp(input, decoded, len) : -1;
+    printf("res: [%d]\n", res);
+
+    huff_wide_free(&codec);
+    free(coded);
+    free(decoded);
+    free(input);
+    return res != 0;
+}
+
 // Driver code
-int main()
+int main(int argc, char **argv)
 {
+    if (argc > 1 && strcmp(argv[1], "--utf8") == 0)
+        return run_utf8_mode((argc > 2) ? argv[2] : "myText.txt");
+
     size = strlen(alphabeth);
     char *input_string;
     int frequencies[sizeof(alphabeth) / sizeof(char)] = {0};
@@ -220,7 +277,8 @@ int main()
         }
 
         if(isLeaf(node)){
-            strncat(decoded_string, &node->data, 1);
+            char literal = node->data;
+            strncat(decoded_string, &literal, 1);
             node = root;
         }
     }
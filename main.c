@@ -17,7 +17,20 @@
 #include <string.h>
 #include <stddef.h>
 #include "tree_utils.h"
+#include "codeword_utils.h"
 #include "frequencies_utils.h"
+#include "block_utils.h"
+#include "token_utils.h"
+#include "context_utils.h"
+#include "adaptive_utils.h"
+#include "timer_utils.h"
+#include "tune_utils.h"
+#include "sched_utils.h"
+#include "numa_utils.h"
+#include "crc_utils.h"
+#include "manifest_utils.h"
+#include "pool_utils.h"
+#include "stream_utils.h"
 
 /* Configuration of constants */
 
@@ -26,262 +39,1545 @@
 #define RECV_SIZE 200000
 #define INPUT_SIZE 200000
 
-/* This number should be calculated as "log2(length of alphabet)" */
-/* It is an upper-bound and represents  */
+/* Adaptive mode: size of the pieces a producer hands to the encoder */
+#define ADAPTIVE_PIECE 4096
 
-#define SYMBOL_MAX_BITS 5
+/* Pipelined mode: default number of sub-chunks of the piece of every process */
+#define PIPELINE_CHUNKS 4
 
-/* Length of a single-code. Must be at least as SYMBOL_MAX_BITS */
-#define CODES_LEN 15
+/* Decoding: default number of slices of every thread, slower slices are stolen by idle threads */
+#define DECODE_SLICES 4
 
+/* Weighted partitioning: size of the calibration sample and minimum calibration time */
+#define PARTITION_SAMPLE (16 * 1024)
+#define PARTITION_MIN_TIME 0.02
 
-/* Those constants comes from original Min-heap algorithm. */
-#define MAX_TREE_HT 100
-#define HASHSIZE 100
+/* Dynamic mode: default size of the chunks processes take */
+#define DYNAMIC_CHUNK (16 * 1024)
 
-/* This is the alphabet. If input-string contains additional characters, put them here */
-char alphabeth[] = "!#$&'()*+-.,/0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVZ[]^_abcdefghijklmnopqrstuvwxyz{|} ";
+/* Batch mode: small files a process claims at once, per thread */
+#define BATCH_GROUP 4
 
-/* A Huffman tree node */
-struct MinHeapNode
+int size;
+
+/**
+ * @brief Checksum of the whole input on process 0, combined from the checksums of the
+ * pieces of every process in rank order
+ *
+ * @param crc CRC32C of the piece of this process
+ * @param len size of the piece
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @return CRC32C of the input, only on process 0
+ */
+uint32_t gather_crc(uint32_t crc, size_t len, int myrank, int world_size)
 {
-    char data;                        /* defined char */
-    unsigned freq;                    /* frequency */
-    struct MinHeapNode *left, *right; /* pointers to left and right nodes */
-};
+    uint32_t crcs[world_size];
+    unsigned long long lens[world_size], mine = len;
+    int i;
+    MPI_Gather(&crc, 1, MPI_UINT32_T, crcs, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+    MPI_Gather(&mine, 1, MPI_UNSIGNED_LONG_LONG, lens, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (myrank != 0)
+        return 0;
+    crc = 0;
+    for (i = 0; i < world_size; i++)
+        crc = huff_crc32c_combine(crc, crcs[i], lens[i]);
+    return crc;
+}
+
+/**
+ * @brief Process 0 decodes the collected blocks in parallel, verifies the result
+ * and releases the blocks. Every block is checked against its CRC32C by the thread
+ * that decodes it; the combination of the block checksums must then match the
+ * checksum the encoders computed on the input
+ *
+ * @param final_blocks the blocks of every process, in input order
+ * @param total size of the blocks
+ * @param input_string whole input string
+ * @param start time the encoding started
+ * @param expected_crc CRC32C of the input, combined from the encoders
+ */
+void decode_verify_blocks(unsigned char *final_blocks, int total, char *input_string, double start,
+                          uint32_t expected_crc)
+{
+    double finish = MPI_Wtime();
+    printf("Encoding execution time: %e\n", finish - start);
+    printf("Compressed size: %d bytes\n", total);
+
+    size_t input_size = strlen(input_string), decoded_len;
+    char *final_decoded_string = (char *)huff_numa_calloc(input_size + 1, sizeof(char));
+    struct huff_block_ctx ctx;
+    if (!huff_block_ctx_init(&ctx, HUFF_BACKEND_AUTO, 0))
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    double tstart = omp_get_wtime();
+    timer_begin(PHASE_DECODE);
+    bool ok = huff_decompress_blocks_ctx(&ctx, final_blocks, total, (unsigned char *)final_decoded_string, input_size,
+                                         &decoded_len);
+    timer_end(PHASE_DECODE);
+    timer_add_bytes(PHASE_DECODE, input_size);
+    double tstop = omp_get_wtime();
+    printf("Decoding execution time: %f\n", tstop - tstart);
+
+    /* Verify of correctness: blocks were checked while decoding, no second pass over the data */
+    timer_begin(PHASE_VERIFY);
+    int res = (ok && decoded_len == input_size && ctx.crc == expected_crc) ? 0 : -1;
+    timer_end(PHASE_VERIFY);
+    printf("Checksum: %08x, expected %08x\n", ctx.crc, expected_crc);
+    printf("res: [%d]\n", res);
+    huff_block_ctx_free(&ctx);
+    if (huff_numa_get_policy() != HUFF_NUMA_DEFAULT)
+    {
+        huff_numa_report("input_string", input_string, input_size);
+        huff_numa_report("final_decoded_string", final_decoded_string, input_size);
+    }
+    free(final_decoded_string);
+    free(final_blocks);
+}
+
+/**
+ * @brief Fused mode: every process compresses its piece of string block by block
+ * (histogram, table and encoding while the block is in cache) without the
+ * global frequencies reduction and code-table broadcast.
+ * Process 0 collects the blocks, decodes them in parallel and verifies the result.
+ * 
+ * @param recv_buff piece of string of this process
+ * @param input_string whole input string, only on process 0
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @param start time the encoding started, only on process 0
+ * @param backend entropy backend of the blocks
+ * @param block_size size of the blocks e.g HUFF_BLOCK_SIZE
+ */
+void fused_encode_decode(char *recv_buff, char *input_string, int myrank, int world_size, double start,
+                         enum huff_backend backend, size_t block_size)
+{
+    size_t len = strlen(recv_buff);
+    unsigned char *out = (unsigned char *)malloc(huff_fused_bound(len, block_size) + 1);
+    struct huff_block_ctx ctx;
+    if (!huff_block_ctx_init(&ctx, backend, 0))
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    timer_begin(PHASE_ENCODE);
+    int nelem = huff_compress_fused_ctx(&ctx, (unsigned char *)recv_buff, len, block_size, out);
+    timer_end(PHASE_ENCODE);
+    timer_add_bytes(PHASE_ENCODE, len);
+    uint32_t crc = gather_crc(ctx.crc, len, myrank, world_size);
+    huff_block_ctx_free(&ctx);
+    int counts[world_size], gather_disps[world_size], i;
+    unsigned char *final_blocks = NULL;
+
+    timer_begin(PHASE_GATHER);
+    MPI_Gather(&nelem, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (myrank == 0)
+    {
+        for (i = 0; i < world_size; i++)
+            gather_disps[i] = (i > 0) ? (gather_disps[i - 1] + counts[i - 1]) : 0;
+        final_blocks = (unsigned char *)malloc(gather_disps[world_size - 1] + counts[world_size - 1] + 1);
+    }
+    MPI_Gatherv(out, nelem, MPI_CHAR, final_blocks, counts, gather_disps, MPI_CHAR, 0, MPI_COMM_WORLD);
+    timer_end(PHASE_GATHER);
+    free(out);
+
+    if (myrank == 0)
+        decode_verify_blocks(final_blocks, gather_disps[world_size - 1] + counts[world_size - 1], input_string, start,
+                             crc);
+}
 
-struct nlist
-{                         /* table entry: */
-    char name;            /* defined char */
-    char code[CODES_LEN]; /* code */
+/* Sizes of the coded piece of a process, see gather_coded_pieces() */
+struct piece_sizes
+{
+    int coded;      /* coded bytes */
+    int symbols;    /* coded symbols */
+    int raw;        /* decoded bytes */
+    int coded_disp; /* offset of the coded piece, set on process 0 */
+    int raw_disp;   /* offset of the decoded piece, set on process 0 */
 };
-int size;
-struct nlist codes_list[HASHSIZE];
 
-/* hash: returns the hash value for char s */
-unsigned hash(char s)
+/**
+ * @brief Collects on process 0 the coded pieces of every process
+ * 
+ * @param out coded piece of this process
+ * @param mine sizes of the piece of this process
+ * @param pieces location in which save the sizes of every piece, only on process 0
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @return all the coded pieces, only on process 0
+ */
+unsigned char *gather_coded_pieces(unsigned char *out, struct piece_sizes *mine, struct piece_sizes *pieces, int myrank, int world_size)
 {
-    char *ret;
-    int idx;
-    ret = strchr(alphabeth, s);
-    idx = strlen(alphabeth) - strlen(ret);
-    return idx;
-    
+    int counts[world_size], gather_disps[world_size], i;
+    unsigned char *final_coded = NULL;
+    int nitems = sizeof(struct piece_sizes) / sizeof(int);
+
+    timer_begin(PHASE_GATHER);
+    MPI_Gather(mine, nitems, MPI_INT, pieces, nitems, MPI_INT, 0, MPI_COMM_WORLD);
+    if (myrank == 0)
+    {
+        for (i = 0; i < world_size; i++)
+        {
+            pieces[i].coded_disp = (i > 0) ? (pieces[i - 1].coded_disp + pieces[i - 1].coded) : 0;
+            pieces[i].raw_disp = (i > 0) ? (pieces[i - 1].raw_disp + pieces[i - 1].raw) : 0;
+            counts[i] = pieces[i].coded;
+            gather_disps[i] = pieces[i].coded_disp;
+        }
+        final_coded = (unsigned char *)malloc(gather_disps[world_size - 1] + counts[world_size - 1] + 1);
+    }
+    MPI_Gatherv(out, mine->coded, MPI_UNSIGNED_CHAR, final_coded, counts, gather_disps, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+    timer_end(PHASE_GATHER);
+    return final_coded;
 }
 
-/* lookup: look for s in codes_list */
-bool lookup(char s)
+/**
+ * @brief Process 0 checks the decoded pieces without a second pass over the data: the
+ * checksums of the pieces, computed by the threads that decoded them, are combined in
+ * piece order and compared with the checksum the encoders computed on the input
+ *
+ * @param crcs CRC32C of every decoded piece
+ * @param pieces sizes of every piece
+ * @param world_size number of pieces
+ * @param input_size size of the input
+ * @param expected_crc CRC32C of the input, combined from the encoders
+ * @param failed number of pieces that could not be decoded
+ * @return 0 if the output matches the input, -1 otherwise
+ */
+int verify_pieces(const uint32_t *crcs, const struct piece_sizes *pieces, int world_size, size_t input_size,
+                  uint32_t expected_crc, int failed)
 {
-    struct nlist np;
-    np = codes_list[hash(s)];
-    if (np.name == s)
+    uint32_t crc = 0;
+    int i;
+    if (failed)
+        return -1;
+    for (i = 0; i < world_size; i++)
+        crc = huff_crc32c_combine(crc, crcs[i], pieces[i].raw);
+    printf("Checksum: %08x, expected %08x\n", crc, expected_crc);
+    return (crc == expected_crc && (size_t)(pieces[world_size - 1].raw_disp + pieces[world_size - 1].raw) == input_size)
+               ? 0 : -1;
+}
+
+/**
+ * @brief Token mode: symbols are words and separators instead of single chars.
+ * Every process counts the tokens of its piece of string, vocabularies are
+ * merged in rank order on all processes and counts are summed with an
+ * MPI_Allreduce, so every process builds the same table.
+ * Process 0 collects the coded pieces, decodes them in parallel and verifies the result.
+ * 
+ * @param recv_buff piece of string of this process
+ * @param input_string whole input string, only on process 0
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @param start time the encoding started, only on process 0
+ */
+void token_encode_decode(char *recv_buff, char *input_string, int myrank, int world_size, double start)
+{
+    struct huff_token_codec local, global;
+    size_t len = strlen(recv_buff);
+    int i;
+
+    huff_token_init(&local);
+    timer_begin(PHASE_HISTOGRAM);
+    huff_token_count(&local, (unsigned char *)recv_buff, len);
+    timer_end(PHASE_HISTOGRAM);
+
+    /* Every process receives the vocabularies of all the others */
+    timer_begin(PHASE_REDUCE);
+    int vocab_size = huff_token_write_vocab(&local, NULL);
+    unsigned char *vocab = (unsigned char *)malloc(vocab_size + 1);
+    huff_token_write_vocab(&local, vocab);
+    int vocab_sizes[world_size], vocab_disps[world_size];
+    MPI_Allgather(&vocab_size, 1, MPI_INT, vocab_sizes, 1, MPI_INT, MPI_COMM_WORLD);
+    for (i = 0; i < world_size; i++)
+        vocab_disps[i] = (i > 0) ? (vocab_disps[i - 1] + vocab_sizes[i - 1]) : 0;
+    int all_size = vocab_disps[world_size - 1] + vocab_sizes[world_size - 1];
+    unsigned char *all_vocab = (unsigned char *)malloc(all_size + 1);
+    MPI_Allgatherv(vocab, vocab_size, MPI_UNSIGNED_CHAR, all_vocab, vocab_sizes, vocab_disps, MPI_UNSIGNED_CHAR, MPI_COMM_WORLD);
+
+    /* Merged in rank order: ids are the same on every process */
+    huff_token_init(&global);
+    huff_token_read_vocab(&global, all_vocab, all_size);
+    for (i = 0; i < local.vocab.ntokens; i++)
     {
-        return true; /* found */
+        int id = huff_token_find(&global, local.vocab.pool + local.vocab.offsets[i], local.vocab.lens[i]);
+        if (id < 0)
+        {
+            fprintf(stderr, "ERROR: Token missing from the merged vocabulary!\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        global.vocab.counts[id] = local.vocab.counts[i];
     }
-    else if (np.name != 0)
+    MPI_Allreduce(MPI_IN_PLACE, global.vocab.counts, global.vocab.ntokens, MPI_UNSIGNED, MPI_SUM, MPI_COMM_WORLD);
+    timer_end(PHASE_REDUCE);
+    timer_begin(PHASE_TREE);
+    if (!huff_token_finish(&global))
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    timer_end(PHASE_TREE);
+    free(vocab);
+    free(all_vocab);
+    huff_token_free(&local);
+
+    /* Encoding of the local piece */
+    size_t nsymbols;
+    unsigned char *out = (unsigned char *)malloc(huff_token_bound(len) + 1);
+    struct piece_sizes mine, pieces[world_size];
+    timer_begin(PHASE_ENCODE);
+    mine.coded = huff_token_encode(&global, (unsigned char *)recv_buff, len, out, &nsymbols);
+    if (mine.coded == 0 && len > 0)
     {
-        fprintf(stderr, "ERROR: Bad lookup. %c literal hash is already used by %c!\n", s, np.name);
-        exit(-1);
+        fprintf(stderr, "ERROR: Token encoding failed!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
     }
-    return false; /* not found */
+    uint32_t piece_crc = huff_crc32c(0, recv_buff, len);
+    timer_end(PHASE_ENCODE);
+    mine.symbols = nsymbols;
+    mine.raw = len;
+    unsigned char *final_coded = gather_coded_pieces(out, &mine, pieces, myrank, world_size);
+    uint32_t input_crc = gather_crc(piece_crc, len, myrank, world_size);
+    free(out);
+
+    if (myrank == 0)
+    {
+        double finish = MPI_Wtime();
+        printf("Encoding execution time: %e\n", finish - start);
+        printf("Vocabulary: %d tokens, coded size: %d bytes\n", global.vocab.ntokens,
+               pieces[world_size - 1].coded_disp + pieces[world_size - 1].coded);
+
+        size_t input_size = strlen(input_string);
+        char *final_decoded_string = (char *)huff_numa_calloc(input_size + 1, sizeof(char));
+        uint32_t crcs[world_size];
+        int failed = 0;
+
+        /* Every piece is byte aligned: pieces are decoded in parallel */
+        double tstart = omp_get_wtime();
+        timer_begin(PHASE_DECODE);
+        #pragma omp parallel for reduction(+ : failed)
+        for (i = 0; i < world_size; i++)
+        {
+            size_t decoded_len;
+            if (!huff_token_decode(&global, final_coded + pieces[i].coded_disp, pieces[i].coded, pieces[i].symbols,
+                                   (unsigned char *)final_decoded_string + pieces[i].raw_disp, pieces[i].raw, &decoded_len) ||
+                decoded_len != (size_t)pieces[i].raw)
+                failed++;
+            else
+                crcs[i] = huff_crc32c(0, final_decoded_string + pieces[i].raw_disp, pieces[i].raw);
+        }
+        timer_end(PHASE_DECODE);
+        double tstop = omp_get_wtime();
+        printf("Decoding execution time: %f\n", tstop - tstart);
+
+        /* Verify of correctness: pieces were checksummed while decoding */
+        timer_begin(PHASE_VERIFY);
+        int res = verify_pieces(crcs, pieces, world_size, input_size, input_crc, failed);
+        timer_end(PHASE_VERIFY);
+        printf("res: [%d]\n", res);
+        free(final_decoded_string);
+        free(final_coded);
+    }
+    huff_token_free(&global);
 }
 
-/* install: put (name, code) in codes_list */
-bool install(char name, char *code)
+/**
+ * @brief Order-1 mode: the table of a char is selected by the previous char
+ * (or by a hashed class of it). The 2D histogram is summed over all
+ * processes with an MPI_Allreduce, so every process builds the same tables.
+ * Process 0 collects the coded pieces, decodes them in parallel and verifies the result.
+ * 
+ * @param recv_buff piece of string of this process
+ * @param input_string whole input string, only on process 0
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @param start time the encoding started, only on process 0
+ * @param nclasses number of contexts, HUFF_CONTEXT_ORDER1 for one per previous char
+ */
+void context_encode_decode(char *recv_buff, char *input_string, int myrank, int world_size, double start, int nclasses)
 {
-    unsigned hashval;
-    if (!lookup(name))
-    { /* not found */
-        hashval = hash(name);
-        codes_list[hashval].name = name;
-        memcpy(codes_list[hashval].code, code, strlen(code));
-        return true;
-    }
-    return false;
+    struct huff_context_model model;
+    size_t len = strlen(recv_buff);
+    int i;
+
+    if (!huff_context_init(&model, nclasses))
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    unsigned int *freq = (unsigned int *)calloc(nclasses * HUFF_BYTE_SYMBOLS, sizeof(unsigned int));
+    timer_begin(PHASE_HISTOGRAM);
+    huff_context_histogram(&model, (unsigned char *)recv_buff, len, freq);
+    timer_end(PHASE_HISTOGRAM);
+    timer_begin(PHASE_REDUCE);
+    MPI_Allreduce(MPI_IN_PLACE, freq, nclasses * HUFF_BYTE_SYMBOLS, MPI_UNSIGNED, MPI_SUM, MPI_COMM_WORLD);
+    timer_end(PHASE_REDUCE);
+    timer_begin(PHASE_TREE);
+    if (!huff_context_build(&model, freq))
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    timer_end(PHASE_TREE);
+    free(freq);
+
+    unsigned char *out = (unsigned char *)malloc(huff_context_bound(len) + 1);
+    struct piece_sizes mine, pieces[world_size];
+    timer_begin(PHASE_ENCODE);
+    mine.coded = huff_context_encode(&model, (unsigned char *)recv_buff, len, out);
+    if (mine.coded == 0 && len > 0)
+    {
+        fprintf(stderr, "ERROR: A byte has no code into its context!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    uint32_t piece_crc = huff_crc32c(0, recv_buff, len);
+    timer_end(PHASE_ENCODE);
+    mine.symbols = len;
+    mine.raw = len;
+    unsigned char *final_coded = gather_coded_pieces(out, &mine, pieces, myrank, world_size);
+    uint32_t input_crc = gather_crc(piece_crc, len, myrank, world_size);
+    free(out);
+
+    if (myrank == 0)
+    {
+        double finish = MPI_Wtime();
+        printf("Encoding execution time: %e\n", finish - start);
+        printf("Contexts: %d, coded size: %d bytes\n", nclasses,
+               pieces[world_size - 1].coded_disp + pieces[world_size - 1].coded);
+
+        size_t input_size = strlen(input_string);
+        char *final_decoded_string = (char *)huff_numa_calloc(input_size + 1, sizeof(char));
+        uint32_t crcs[world_size];
+        int failed = 0;
+
+        /* Every piece starts from context of char 0: pieces are decoded in parallel */
+        double tstart = omp_get_wtime();
+        timer_begin(PHASE_DECODE);
+        #pragma omp parallel for reduction(+ : failed)
+        for (i = 0; i < world_size; i++)
+        {
+            if (!huff_context_decode(&model, final_coded + pieces[i].coded_disp, pieces[i].coded,
+                                     (unsigned char *)final_decoded_string + pieces[i].raw_disp, pieces[i].raw))
+                failed++;
+            else
+                crcs[i] = huff_crc32c(0, final_decoded_string + pieces[i].raw_disp, pieces[i].raw);
+        }
+        timer_end(PHASE_DECODE);
+        double tstop = omp_get_wtime();
+        printf("Decoding execution time: %f\n", tstop - tstart);
+
+        /* Verify of correctness: pieces were checksummed while decoding */
+        timer_begin(PHASE_VERIFY);
+        int res = verify_pieces(crcs, pieces, world_size, input_size, input_crc, failed);
+        timer_end(PHASE_VERIFY);
+        printf("res: [%d]\n", res);
+        free(final_decoded_string);
+        free(final_coded);
+    }
+    huff_context_free(&model);
 }
 
-/* This node is used into decoding phase. See 'decoded_node()' function */ 
-struct decoded_node
+/* Main code */
+/**
+ * @brief Adaptive mode: no frequency pass and no table broadcast. Every process
+ * feeds its piece of string to the encoder in ADAPTIVE_PIECE sized pieces, as a
+ * producer would, and bytes are output from the first piece on. Tables are rebuilt
+ * from running counts every 'interval' chars on both sides.
+ * Process 0 collects the coded pieces, decodes them in parallel and verifies the result.
+ * 
+ * @param recv_buff piece of string of this process
+ * @param input_string whole input string, only on process 0
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @param start time the encoding started, only on process 0
+ * @param interval chars between two table rebuilds
+ */
+void adaptive_encode_decode(char *recv_buff, char *input_string, int myrank, int world_size, double start, size_t interval)
 {
-    char *string;     /* decoded string */
-    int padding_bits; /* bits needed to decode another valid literal */
-};
+    struct huff_adaptive_coder coder;
+    size_t len = strlen(recv_buff), pos, nbytes = 0;
+    double first_output = -1;
+    int i;
 
-/* Parallel function task based to create the code-word table
- * This is another possible solution w.r.t the one used. More details
- * can be found in the project report
+    if (!huff_adaptive_init(&coder, interval))
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    unsigned char *out = (unsigned char *)malloc(huff_adaptive_bound(len) + 1);
+    double tstart = MPI_Wtime();
+    timer_begin(PHASE_ENCODE);
+    for (pos = 0; pos < len; pos += ADAPTIVE_PIECE)
+    {
+        size_t n = (len - pos < ADAPTIVE_PIECE) ? len - pos : ADAPTIVE_PIECE;
+        nbytes += huff_adaptive_encode(&coder, (unsigned char *)recv_buff + pos, n, out + nbytes);
+        if (first_output < 0 && nbytes > 0)
+            first_output = MPI_Wtime() - tstart;
+    }
+    nbytes += huff_adaptive_finish(&coder, out + nbytes);
+    uint32_t piece_crc = huff_crc32c(0, recv_buff, len);
+    timer_end(PHASE_ENCODE);
+    huff_adaptive_free(&coder);
+
+    struct piece_sizes mine, pieces[world_size];
+    mine.coded = nbytes;
+    mine.symbols = len;
+    mine.raw = len;
+    unsigned char *final_coded = gather_coded_pieces(out, &mine, pieces, myrank, world_size);
+    uint32_t input_crc = gather_crc(piece_crc, len, myrank, world_size);
+    free(out);
+
+    if (myrank == 0)
+    {
+        double finish = MPI_Wtime();
+        printf("Encoding execution time: %e\n", finish - start);
+        printf("First output after: %e\n", first_output);
+        printf("Rebuild interval: %zu, coded size: %d bytes\n", interval,
+               pieces[world_size - 1].coded_disp + pieces[world_size - 1].coded);
+
+        size_t input_size = strlen(input_string);
+        char *final_decoded_string = (char *)huff_numa_calloc(input_size + 1, sizeof(char));
+        uint32_t crcs[world_size];
+        int failed = 0;
+
+        /* Every piece is an independent stream: pieces are decoded in parallel */
+        double dstart = omp_get_wtime();
+        timer_begin(PHASE_DECODE);
+        #pragma omp parallel for reduction(+ : failed)
+        for (i = 0; i < world_size; i++)
+        {
+            struct huff_adaptive_coder decoder;
+            if (!huff_adaptive_init(&decoder, interval))
+            {
+                failed++;
+                continue;
+            }
+            if (!huff_adaptive_decode(&decoder, final_coded + pieces[i].coded_disp, pieces[i].coded,
+                                      (unsigned char *)final_decoded_string + pieces[i].raw_disp, pieces[i].raw))
+                failed++;
+            else
+                crcs[i] = huff_crc32c(0, final_decoded_string + pieces[i].raw_disp, pieces[i].raw);
+            huff_adaptive_free(&decoder);
+        }
+        timer_end(PHASE_DECODE);
+        double dstop = omp_get_wtime();
+        printf("Decoding execution time: %f\n", dstop - dstart);
+
+        /* Verify of correctness: pieces were checksummed while decoding */
+        timer_begin(PHASE_VERIFY);
+        int res = verify_pieces(crcs, pieces, world_size, input_size, input_crc, failed);
+        timer_end(PHASE_VERIFY);
+        printf("res: [%d]\n", res);
+        free(final_decoded_string);
+        free(final_coded);
+    }
+}
+
+/* Offset of sub-chunk 'k' of 'nchunks' into a piece of 'len' chars */
+int chunk_offset(int len, int k, int nchunks)
+{
+    return (int)((long long)len * k / nchunks);
+}
+
+/**
+ * @brief Pipelined scatter and frequencies: the piece of every process is scattered in
+ * 'nchunks' sub-chunks with MPI_Iscatterv, so chunk k+1 is received while chunk k is counted.
+ * The frequencies of each chunk are summed with MPI_Iallreduce while the next one is counted,
+ * so every process ends with the global frequencies.
+ * 
+ * @param input_string whole input string, only on process 0
+ * @param sendcount size of the piece of every process, only on process 0
+ * @param displs offset of the piece of every process, only on process 0
+ * @param recv_buff location in which save the piece of this process
+ * @param reduce_buff location in which save the global frequencies
+ * @param nfreq number of frequencies
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @param nchunks number of sub-chunks
+ */
+void pipelined_scatter_count(char *input_string, int *sendcount, int *displs, char *recv_buff, int *reduce_buff,
+                             int nfreq, int myrank, int world_size, int nchunks)
+{
+    int mine, k, i;
+    int *chunk_counts = NULL, *chunk_displs = NULL, *sums = NULL;
+    MPI_Request scatter_reqs[nchunks], reduce_reqs[nchunks];
+
+    /* Every process needs the size of its piece to post its receives */
+    timer_begin(PHASE_SCATTER);
+    MPI_Scatter(sendcount, 1, MPI_INT, &mine, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (myrank == 0)
+    {
+        chunk_counts = (int *)malloc(nchunks * world_size * sizeof(int));
+        chunk_displs = (int *)malloc(nchunks * world_size * sizeof(int));
+        for (k = 0; k < nchunks; k++)
+        {
+            for (i = 0; i < world_size; i++)
+            {
+                int first = chunk_offset(sendcount[i], k, nchunks);
+                chunk_counts[k * world_size + i] = chunk_offset(sendcount[i], k + 1, nchunks) - first;
+                chunk_displs[k * world_size + i] = displs[i] + first;
+            }
+        }
+    }
+    for (k = 0; k < nchunks; k++)
+    {
+        int first = chunk_offset(mine, k, nchunks), n = chunk_offset(mine, k + 1, nchunks) - first;
+        MPI_Iscatterv(input_string, (myrank == 0) ? chunk_counts + k * world_size : NULL,
+                      (myrank == 0) ? chunk_displs + k * world_size : NULL, MPI_CHAR, recv_buff + first, n, MPI_CHAR,
+                      0, MPI_COMM_WORLD, &scatter_reqs[k]);
+    }
+    timer_end(PHASE_SCATTER);
+
+    int *partial = (int *)calloc(nchunks * nfreq, sizeof(int));
+    sums = (int *)calloc(nchunks * nfreq, sizeof(int));
+    char *chunk = (char *)malloc(mine / nchunks + 2);
+    for (k = 0; k < nchunks; k++)
+    {
+        int first = chunk_offset(mine, k, nchunks), n = chunk_offset(mine, k + 1, nchunks) - first;
+        timer_begin(PHASE_SCATTER);
+        MPI_Wait(&scatter_reqs[k], MPI_STATUS_IGNORE);
+        timer_end(PHASE_SCATTER);
+
+        timer_begin(PHASE_HISTOGRAM);
+        memcpy(chunk, recv_buff + first, n);
+        chunk[n] = '\0';
+        calculate_frequencies(alphabeth, chunk, partial + k * nfreq);
+        timer_end(PHASE_HISTOGRAM);
+        timer_add_bytes(PHASE_HISTOGRAM, n);
+        MPI_Iallreduce(partial + k * nfreq, sums + k * nfreq, nfreq, MPI_INT, MPI_SUM, MPI_COMM_WORLD,
+                       &reduce_reqs[k]);
+    }
+    recv_buff[mine] = '\0';
+
+    timer_begin(PHASE_REDUCE);
+    MPI_Waitall(nchunks, reduce_reqs, MPI_STATUSES_IGNORE);
+    for (k = 0; k < nchunks; k++)
+    {
+        for (i = 0; i < nfreq; i++)
+            reduce_buff[i] += sums[k * nfreq + i];
+    }
+    timer_end(PHASE_REDUCE);
+    free(chunk);
+    free(partial);
+    free(sums);
+    free(chunk_counts);
+    free(chunk_displs);
+}
+
+/**
+ * @brief Pipelined encoding and gather: the piece is encoded in 'nchunks' sub-chunks and
+ * the coded sub-chunk k is collected with MPI_Igatherv while chunk k+1 is encoded.
+ * Process 0 puts the sub-chunks back in input order.
+ * 
+ * @param recv_buff piece of string of this process
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @param nchunks number of sub-chunks
+ * @return char* whole encoded string on process 0, NULL on the others
  */
-// void FillCodesList(struct MinHeapNode *root, char arr[], int top)
-// {
-//     // Assign 0 to left edge and recur
-//     if (root->left)
-//     {
-//         #pragma omp task firstprivate(root, arr, top) depend(out: top)
-//         {
-//             #pragma omp critical
-//                 arr[top] = '0';
-
-//             FillCodesList(root->left, arr, top + 1);
-//         }
-//     }
-
-//     // Assign 1 to right edge and recur
-//     if (root->right)
-//     {
-//         #pragma omp task firstprivate(root, arr, top) depend(in: top)
-//         {
-//             #pragma omp critical
-//                 arr[top] = '1';
-
-//             FillCodesList(root->right, arr, top + 1);
-//         }
-//     }
-
-//     // If this is a leaf node, then
-//     // it contains one of the input
-//     // characters, print the character
-//     // and its code from arr[]
-//     #pragma omp taskwait
-//     if (isLeaf(root))
-//     {
-//         arr[top] = '\0';
-//         bool res = install(root->data, arr);
-//         if (!res)
-//         {
-//             fprintf(stderr, "Bad install!\n");
-//             exit(-1);
-//         }
-//     }
-// }
-
-/* Serial function to create the code-word table */
-void FillCodesList(struct MinHeapNode *root, char arr[], int top)
+char *pipelined_encode_gather(char *recv_buff, int myrank, int world_size, int nchunks)
 {
-    // Assign 0 to left edge and recur
-    if (root->left)
+    int len = strlen(recv_buff), k, i;
+    char *outs[nchunks], *stage[nchunks];
+    int lens[nchunks];
+    int *all_lens = NULL, *disps = NULL;
+    MPI_Request len_reqs[nchunks], data_reqs[nchunks];
+    if (myrank == 0)
     {
-        arr[top] = '0';
-        FillCodesList(root->left, arr, top + 1);
+        all_lens = (int *)malloc(nchunks * world_size * sizeof(int));
+        disps = (int *)malloc(nchunks * world_size * sizeof(int));
     }
 
-    // Assign 1 to right edge and recur
-    if (root->right)
+    /* Iteration k encodes chunk k and sends chunk k-1, whose size is known by now */
+    for (k = 0; k <= nchunks; k++)
     {
-        arr[top] = '1';
-        FillCodesList(root->right, arr, top + 1); 
+        if (k < nchunks)
+        {
+            int first = chunk_offset(len, k, nchunks), last = chunk_offset(len, k + 1, nchunks);
+            char saved = recv_buff[last];
+            timer_begin(PHASE_ENCODE);
+            recv_buff[last] = '\0';
+            outs[k] = calculate_huff_code(recv_buff + first);
+            recv_buff[last] = saved;
+            lens[k] = strlen(outs[k]);
+            timer_end(PHASE_ENCODE);
+            timer_add_bytes(PHASE_ENCODE, last - first);
+            MPI_Igather(&lens[k], 1, MPI_INT, (myrank == 0) ? all_lens + k * world_size : NULL, 1, MPI_INT, 0,
+                        MPI_COMM_WORLD, &len_reqs[k]);
+        }
+        if (k > 0)
+        {
+            int j = k - 1;
+            timer_begin(PHASE_GATHER);
+            MPI_Wait(&len_reqs[j], MPI_STATUS_IGNORE);
+            stage[j] = NULL;
+            if (myrank == 0)
+            {
+                int total = 0;
+                for (i = 0; i < world_size; i++)
+                {
+                    disps[j * world_size + i] = total;
+                    total += all_lens[j * world_size + i];
+                }
+                stage[j] = (char *)malloc(total + 1);
+            }
+            MPI_Igatherv(outs[j], lens[j], MPI_CHAR, stage[j], (myrank == 0) ? all_lens + j * world_size : NULL,
+                         (myrank == 0) ? disps + j * world_size : NULL, MPI_CHAR, 0, MPI_COMM_WORLD, &data_reqs[j]);
+            timer_end(PHASE_GATHER);
+        }
     }
 
-    // If this is a leaf node, then
-    // it contains one of the input
-    // characters, print the character
-    // and its code from arr[]
-    if (isLeaf(root))
+    timer_begin(PHASE_GATHER);
+    MPI_Waitall(nchunks, data_reqs, MPI_STATUSES_IGNORE);
+    char *final_string = NULL;
+    if (myrank == 0)
     {
-        arr[top] = '\0';
-        bool res = install(root->data, arr);
-        if (!res)
+        int total = 0, pos = 0;
+        for (i = 0; i < nchunks * world_size; i++)
+            total += all_lens[i];
+        final_string = (char *)calloc(total + 1, sizeof(char));
+        for (i = 0; i < world_size; i++)
         {
-            fprintf(stderr, "Bad install!\n");
-            exit(-1);
+            for (k = 0; k < nchunks; k++)
+            {
+                memcpy(final_string + pos, stage[k] + disps[k * world_size + i], all_lens[k * world_size + i]);
+                pos += all_lens[k * world_size + i];
+            }
         }
     }
+    timer_end(PHASE_GATHER);
+    for (k = 0; k < nchunks; k++)
+    {
+        free(outs[k]);
+        free(stage[k]);
+    }
+    free(all_lens);
+    free(disps);
+    return final_string;
+}
+
+/* Processes of the same node, see topology_init() */
+struct node_topology
+{
+    MPI_Comm node_comm;    /* processes sharing memory with this one */
+    MPI_Comm leaders_comm; /* first process of every node, MPI_COMM_NULL on the others */
+    int node_rank;         /* rank into 'node_comm' */
+    int node_size;         /* processes of this node */
+    int nnodes;            /* number of nodes */
+    int *node_of;          /* node of every process */
+    MPI_Win input_win;     /* pieces of the input of this node */
+};
+
+/**
+ * @brief Groups the processes by node. Into a node, processes are ordered by rank
+ *
+ * @param topo location in which save the topology
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ */
+void topology_init(struct node_topology *topo, int myrank, int world_size)
+{
+    int node, i;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myrank, MPI_INFO_NULL, &topo->node_comm);
+    MPI_Comm_rank(topo->node_comm, &topo->node_rank);
+    MPI_Comm_size(topo->node_comm, &topo->node_size);
+    MPI_Comm_split(MPI_COMM_WORLD, (topo->node_rank == 0) ? 0 : MPI_UNDEFINED, myrank, &topo->leaders_comm);
+    if (topo->node_rank == 0)
+        MPI_Comm_rank(topo->leaders_comm, &node);
+    MPI_Bcast(&node, 1, MPI_INT, 0, topo->node_comm);
+    topo->node_of = (int *)malloc(world_size * sizeof(int));
+    MPI_Allgather(&node, 1, MPI_INT, topo->node_of, 1, MPI_INT, MPI_COMM_WORLD);
+    topo->nnodes = 0;
+    for (i = 0; i < world_size; i++)
+    {
+        if (topo->node_of[i] + 1 > topo->nnodes)
+            topo->nnodes = topo->node_of[i] + 1;
+    }
+    topo->input_win = MPI_WIN_NULL;
+}
+
+void topology_free(struct node_topology *topo)
+{
+    if (topo->input_win != MPI_WIN_NULL)
+        MPI_Win_free(&topo->input_win);
+    if (topo->leaders_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&topo->leaders_comm);
+    MPI_Comm_free(&topo->node_comm);
+    free(topo->node_of);
 }
 
 /**
- * @brief Walks the code-table and returns the huffman code for a given string
+ * @brief Layout of the pieces of node 'n': each piece followed by a '\0'
  *
- * @param in_str 
- * @return char* huff code
+ * @param topo the topology
+ * @param n the node
+ * @param world_size number of processes
+ * @param lens size of the piece of every process
+ * @param members location in which save the processes of the node
+ * @param offsets location in which save the offset of each piece into the node buffer
+ * @return number of processes of the node
  */
-char *calculate_huff_code(char *in_str)
+int node_layout(struct node_topology *topo, int n, int world_size, const int *lens, int *members, int *offsets)
 {
-    int i = 0, code_len = 0, buff_len = 10, string_len = strlen(in_str);
-    char *code;
-    char *out_string = (char *)calloc(buff_len, sizeof(char));
-    for (i = 0; i < string_len; i++)
+    int r, count = 0, pos = 0;
+    for (r = 0; r < world_size; r++)
     {
-        code = codes_list[hash(in_str[i])].code;
-        code_len = strlen(code);
-        if ((buff_len - strlen(out_string)) <= code_len)
+        if (topo->node_of[r] != n)
+            continue;
+        members[count] = r;
+        offsets[count] = pos;
+        pos += lens[r] + 1;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Node-local shared-memory scatter and frequencies. Every node keeps the pieces of
+ * its processes in one shared window: process 0 sends each node leader the pieces of its
+ * node as one message (an indexed datatype over the input, no packing), processes read
+ * their piece in place. Frequencies are reduced into the node, then across node leaders.
+ * 
+ * @param topo the topology
+ * @param input_string whole input string, only on process 0
+ * @param lens size of the piece of every process
+ * @param disps offset of the piece of every process
+ * @param frequencies location in which save the frequencies of the piece
+ * @param reduce_buff location in which save the global frequencies
+ * @param nfreq number of frequencies
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @return char* piece of this process, into the shared window
+ */
+char *shared_scatter_count(struct node_topology *topo, char *input_string, int *lens, int *disps, int *frequencies,
+                           int *reduce_buff, int nfreq, int myrank, int world_size)
+{
+    int members[world_size], offsets[world_size];
+    int n, i, count, disp_unit;
+    MPI_Aint size, qsize;
+    char *base, *node_base;
+
+    timer_begin(PHASE_SCATTER);
+    count = node_layout(topo, topo->node_of[myrank], world_size, lens, members, offsets);
+    size = (topo->node_rank == 0) ? offsets[count - 1] + lens[members[count - 1]] + 1 : 0;
+    MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, topo->node_comm, &base, &topo->input_win);
+    MPI_Win_shared_query(topo->input_win, 0, &qsize, &disp_unit, &node_base);
+
+    MPI_Win_fence(0, topo->input_win);
+    if (myrank == 0)
+    {
+        /* Other nodes: one message per node leader */
+        MPI_Request reqs[topo->nnodes];
+        MPI_Datatype types[topo->nnodes];
+        int nreqs = 0;
+        for (n = 0; n < topo->nnodes; n++)
         {
-            buff_len += (code_len * SYMBOL_MAX_BITS);
-            out_string = (char *)realloc(out_string, buff_len);
+            int node_members[world_size], node_offsets[world_size], blocks[world_size], starts[world_size];
+            int c = node_layout(topo, n, world_size, lens, node_members, node_offsets);
+            if (n == topo->node_of[0])
+                continue;
+            for (i = 0; i < c; i++)
+            {
+                blocks[i] = lens[node_members[i]];
+                starts[i] = disps[node_members[i]];
+            }
+            MPI_Type_indexed(c, blocks, starts, MPI_CHAR, &types[nreqs]);
+            MPI_Type_commit(&types[nreqs]);
+            MPI_Isend(input_string, 1, types[nreqs], node_members[0], 0, MPI_COMM_WORLD, &reqs[nreqs]);
+            nreqs++;
         }
-        strcat(out_string, code);
+        /* Own node: a single copy into the shared window */
+        for (i = 0; i < count; i++)
+            memcpy(node_base + offsets[i], input_string + disps[members[i]], lens[members[i]]);
+        MPI_Waitall(nreqs, reqs, MPI_STATUSES_IGNORE);
+        for (i = 0; i < nreqs; i++)
+            MPI_Type_free(&types[i]);
+    }
+    else if (topo->node_rank == 0)
+    {
+        int blocks[world_size];
+        MPI_Datatype type;
+        for (i = 0; i < count; i++)
+            blocks[i] = lens[members[i]];
+        MPI_Type_indexed(count, blocks, offsets, MPI_CHAR, &type);
+        MPI_Type_commit(&type);
+        MPI_Recv(node_base, 1, type, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Type_free(&type);
     }
-    return out_string;
+    if (topo->node_rank == 0)
+    {
+        for (i = 0; i < count; i++)
+            node_base[offsets[i] + lens[members[i]]] = '\0';
+    }
+    MPI_Win_fence(0, topo->input_win);
+    char *piece = node_base + offsets[topo->node_rank];
+    timer_end(PHASE_SCATTER);
+
+    timer_begin(PHASE_HISTOGRAM);
+    calculate_frequencies(alphabeth, piece, frequencies);
+    timer_end(PHASE_HISTOGRAM);
+    timer_add_bytes(PHASE_HISTOGRAM, lens[myrank]);
+
+    /* Hierarchical reduction: into the node, across node leaders, then back into the nodes */
+    timer_begin(PHASE_REDUCE);
+    int node_freq[nfreq];
+    MPI_Reduce(frequencies, node_freq, nfreq, MPI_INT, MPI_SUM, 0, topo->node_comm);
+    if (topo->leaders_comm != MPI_COMM_NULL)
+        MPI_Allreduce(node_freq, reduce_buff, nfreq, MPI_INT, MPI_SUM, topo->leaders_comm);
+    MPI_Bcast(reduce_buff, nfreq, MPI_INT, 0, topo->node_comm);
+    timer_end(PHASE_REDUCE);
+    return piece;
 }
 
 /**
- * @brief Function to decode a piece of string. Called within parallel region.
- * 
- * @param root root of Huff tree
- * @param in_string input string
- * @param size_per_thread how much of the string to manage
- * @param padding extra padding
- * @param total_threads how many threads are available in total
- * @param offset how much overlap between decoded strings of different threads
- * @return struct decoded_node* 
+ * @brief Node-local shared-memory gather: processes write their encoded piece into a window
+ * of the node, node leaders send it to process 0 as one message that lands in input order
+ *
+ * @param topo the topology
+ * @param out encoded piece of this process
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @return char* whole encoded string on process 0, NULL on the others
  */
-struct decoded_node *decode_string(struct MinHeapNode *root, char *in_string, int size_per_thread, int padding, int total_threads, int offset)
+char *shared_gather(struct node_topology *topo, char *out, int myrank, int world_size)
 {
-    /* Myrank */
-    int thread_rank = omp_get_thread_num();
-    struct MinHeapNode *node = root;
-    int len = strlen(in_string);
-    /* Pointer to different nodes. There are up to 'offset' nodes */
-    /* Each thread will have 'offset' number of different decoded strings */
-    struct decoded_node *d_node = (struct decoded_node *)malloc(sizeof(d_node) * offset);
-    char *local_string;
-    int initial_offset, end_offset, i, k, local_initial_offset;
-    initial_offset = thread_rank * size_per_thread;
-    end_offset = initial_offset + size_per_thread;
-
-    /* Last thread will manage also padding */
-    if (total_threads == thread_rank && padding > 0)
-        end_offset += padding;
-
-    /* Each thread will decode many candidate decode-strings. How many? up to 'offset' */
-    for (k = 0; k < offset; k++)
-    {
-        /* Those indices makes the ovelapping strategy for each thread */
-        local_initial_offset = initial_offset - k;
-        local_string = calloc(len, sizeof(char));
-        int last_literal_index = 0;
-        node = root;
-        for (i = local_initial_offset; i < end_offset; i++)
-        {
-            if (in_string[i] == '0' && node->left != NULL)
+    int len = strlen(out), i, n, count, disp_unit;
+    int lens[world_size], members[world_size], offsets[world_size], final_disps[world_size];
+    MPI_Aint size, qsize;
+    MPI_Win win;
+    char *base, *node_base, *final_string = NULL;
+
+    /* Every process knows the encoded sizes, process 0 places the pieces */
+    MPI_Allgather(&len, 1, MPI_INT, lens, 1, MPI_INT, MPI_COMM_WORLD);
+    count = node_layout(topo, topo->node_of[myrank], world_size, lens, members, offsets);
+    size = (topo->node_rank == 0) ? offsets[count - 1] + lens[members[count - 1]] + 1 : 0;
+    MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, topo->node_comm, &base, &win);
+    MPI_Win_shared_query(win, 0, &qsize, &disp_unit, &node_base);
+
+    MPI_Win_fence(0, win);
+    memcpy(node_base + offsets[topo->node_rank], out, len);
+    MPI_Win_fence(0, win);
+
+    if (myrank == 0)
+    {
+        int total = 0;
+        for (i = 0; i < world_size; i++)
+        {
+            final_disps[i] = total;
+            total += lens[i];
+        }
+        final_string = (char *)calloc(total + 1, sizeof(char));
+        for (i = 0; i < count; i++)
+            memcpy(final_string + final_disps[members[i]], node_base + offsets[i], lens[members[i]]);
+        for (n = 0; n < topo->nnodes; n++)
+        {
+            int node_members[world_size], node_offsets[world_size], blocks[world_size], starts[world_size];
+            int c = node_layout(topo, n, world_size, lens, node_members, node_offsets);
+            MPI_Datatype type;
+            if (n == topo->node_of[0])
+                continue;
+            for (i = 0; i < c; i++)
             {
-                node = node->left;
+                blocks[i] = lens[node_members[i]];
+                starts[i] = final_disps[node_members[i]];
             }
-            else if (node->right != NULL)
+            MPI_Type_indexed(c, blocks, starts, MPI_CHAR, &type);
+            MPI_Type_commit(&type);
+            MPI_Recv(final_string, 1, type, node_members[0], 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Type_free(&type);
+        }
+    }
+    else if (topo->node_rank == 0)
+    {
+        int blocks[world_size];
+        MPI_Datatype type;
+        for (i = 0; i < count; i++)
+            blocks[i] = lens[members[i]];
+        MPI_Type_indexed(count, blocks, offsets, MPI_CHAR, &type);
+        MPI_Type_commit(&type);
+        MPI_Send(node_base, 1, type, 0, 0, MPI_COMM_WORLD);
+        MPI_Type_free(&type);
+    }
+    MPI_Win_free(&win);
+    return final_string;
+}
+
+/**
+ * @brief Throughput of this process on the calibration sample, with the kernel of the
+ * selected pipeline. Repeated for at least PARTITION_MIN_TIME seconds, the mean is kept
+ * so that the load of the node counts
+ *
+ * @param sample the sample, null terminated
+ * @param len size of the sample
+ * @param block_mode true to time block compression, otherwise the frequencies
+ * @param backend entropy backend of the blocks
+ * @param block_size size of the blocks
+ * @return MB/s
+ */
+double calibrate_mbps(char *sample, int len, bool block_mode, enum huff_backend backend, size_t block_size)
+{
+    unsigned char *out = NULL;
+    int freq[sizeof(alphabeth) / sizeof(char)];
+    int reps = 0;
+    double spent = 0;
+    if (block_mode)
+        out = (unsigned char *)malloc(huff_fused_bound(len, block_size) + 1);
+    while (reps < 3 || spent < PARTITION_MIN_TIME)
+    {
+        double t0 = MPI_Wtime();
+        if (block_mode)
+            huff_compress_fused((unsigned char *)sample, len, block_size, backend, out);
+        else
+        {
+            memset(freq, 0, sizeof(freq));
+            calculate_frequencies(alphabeth, sample, freq);
+        }
+        spent += MPI_Wtime() - t0;
+        reps++;
+    }
+    free(out);
+    return (spent > 0) ? (double)len * reps / 1e6 / spent : 1;
+}
+
+/**
+ * @brief Throughput-weighted partitioning: every process reports its throughput (given, e.g
+ * from a profile, or measured on a sample of the input) and process 0 gives each process a
+ * piece proportional to it, so that pieces take about the same time on every node
+ *
+ * @param input_string whole input string, only on process 0
+ * @param input_size size of the input, only on process 0
+ * @param sendcount location in which save the size of every piece, only on process 0
+ * @param displs location in which save the offset of every piece, only on process 0
+ * @param mbps throughput of this process, 0 to measure it
+ * @param block_mode true for the block modes
+ * @param backend entropy backend of the blocks
+ * @param block_size size of the blocks
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ */
+void weighted_partition(char *input_string, int input_size, int *sendcount, int *displs, double mbps,
+                        bool block_mode, enum huff_backend backend, size_t block_size, int myrank, int world_size)
+{
+    int sample_len = 0, i, k = 0;
+    double all_mbps[world_size], total = 0;
+
+    /* Very short inputs are not scattered */
+    if (myrank == 0 && input_size > world_size)
+        sample_len = (input_size < PARTITION_SAMPLE) ? input_size : PARTITION_SAMPLE;
+    MPI_Bcast(&sample_len, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (sample_len == 0)
+        return;
+
+    /* Processes without a given throughput measure it on the head of the input */
+    char *sample = (char *)malloc(sample_len + 1);
+    if (myrank == 0)
+        memcpy(sample, input_string, sample_len);
+    MPI_Bcast(sample, sample_len, MPI_CHAR, 0, MPI_COMM_WORLD);
+    sample[sample_len] = '\0';
+    if (mbps <= 0)
+        mbps = calibrate_mbps(sample, sample_len, block_mode, backend, block_size);
+    free(sample);
+    MPI_Gather(&mbps, 1, MPI_DOUBLE, all_mbps, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (myrank == 0)
+    {
+        for (i = 0; i < world_size; i++)
+            total += all_mbps[i];
+        /* Every process gets at least one byte, the rest is split rounding down and the last
+         * process also gets the remainder. Inputs are longer than world_size here */
+        for (i = 0; i < world_size; i++)
+        {
+            sendcount[i] = (i < world_size - 1) ? 1 + (int)((input_size - world_size) * (all_mbps[i] / total))
+                                                : input_size - k;
+            displs[i] = k;
+            k += sendcount[i];
+            printf("Partition: process %d %d bytes (%.1f MB/s)\n", i, sendcount[i], all_mbps[i]);
+        }
+    }
+}
+
+/**
+ * @brief Dynamic mode: no partitioning, processes take chunks of the input while there are
+ * some left, so faster processes take more. The next chunk is a counter on process 0
+ * (MPI_Fetch_and_op) and chunks are read from a window over the input (MPI_Get).
+ * Each chunk is compressed with its own tables, process 0 puts chunks back in input
+ * order, decodes them and verifies the result.
+ *
+ * @param input_string whole input string, only on process 0
+ * @param input_size size of the input, only on process 0
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ * @param start time the encoding started, only on process 0
+ * @param backend entropy backend of the blocks
+ * @param block_size size of the blocks
+ * @param chunk size of the chunks
+ */
+void dynamic_encode_decode(char *input_string, int input_size, int myrank, int world_size, double start,
+                           enum huff_backend backend, size_t block_size, int chunk)
+{
+    int nchunks, next, one = 1, taken = 0, capacity = 16, used = 0, i, k;
+    int *counter;
+    char *window;
+    MPI_Win input_win, counter_win;
+
+    MPI_Bcast(&input_size, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    nchunks = (input_size + chunk - 1) / chunk;
+    /* Memory allocated by MPI, which may register it for remote access */
+    MPI_Win_allocate((myrank == 0) ? input_size : 0, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &window, &input_win);
+    MPI_Win_allocate((myrank == 0) ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &counter,
+                     &counter_win);
+    if (myrank == 0)
+    {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, input_win);
+        memcpy(window, input_string, input_size);
+        MPI_Win_unlock(0, input_win);
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, counter_win);
+        *counter = 0;
+        MPI_Win_unlock(0, counter_win);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    size_t bound = huff_fused_bound(chunk, block_size);
+    int *indices = (int *)malloc(capacity * sizeof(int));
+    int *sizes = (int *)malloc(capacity * sizeof(int));
+    uint32_t *crcs = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    unsigned char *coded = (unsigned char *)malloc(capacity * bound);
+    char *buf = (char *)malloc(chunk);
+    /* Encoders and scheduler are reused by every chunk */
+    struct huff_block_ctx ctx;
+    if (!huff_block_ctx_init(&ctx, backend, 0))
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    MPI_Win_lock_all(0, counter_win);
+    MPI_Win_lock_all(0, input_win);
+    for (;;)
+    {
+        timer_begin(PHASE_SCATTER);
+        MPI_Fetch_and_op(&one, &next, MPI_INT, 0, 0, MPI_SUM, counter_win);
+        MPI_Win_flush(0, counter_win);
+        if (next >= nchunks)
+        {
+            timer_end(PHASE_SCATTER);
+            break;
+        }
+        int n = (input_size - next * chunk < chunk) ? input_size - next * chunk : chunk;
+        MPI_Get(buf, n, MPI_CHAR, 0, (MPI_Aint)next * chunk, n, MPI_CHAR, input_win);
+        MPI_Win_flush(0, input_win);
+        timer_end(PHASE_SCATTER);
+
+        if (taken == capacity)
+        {
+            capacity *= 2;
+            indices = (int *)realloc(indices, capacity * sizeof(int));
+            sizes = (int *)realloc(sizes, capacity * sizeof(int));
+            crcs = (uint32_t *)realloc(crcs, capacity * sizeof(uint32_t));
+            coded = (unsigned char *)realloc(coded, capacity * bound);
+        }
+        timer_begin(PHASE_ENCODE);
+        indices[taken] = next;
+        sizes[taken] = huff_compress_fused_ctx(&ctx, (unsigned char *)buf, n, block_size, coded + used);
+        crcs[taken] = ctx.crc;
+        timer_end(PHASE_ENCODE);
+        timer_add_bytes(PHASE_ENCODE, n);
+        used += sizes[taken];
+        taken++;
+    }
+    MPI_Win_unlock_all(input_win);
+    MPI_Win_unlock_all(counter_win);
+    huff_block_ctx_free(&ctx);
+    free(buf);
+
+    /* Chunk indices and sizes, then the coded chunks, in the order processes took them */
+    int takens[world_size], useds[world_size], disps[world_size], coded_disps[world_size];
+    int *all_indices = NULL, *all_sizes = NULL;
+    uint32_t *all_crcs = NULL;
+    unsigned char *all_coded = NULL;
+    timer_begin(PHASE_GATHER);
+    MPI_Gather(&taken, 1, MPI_INT, takens, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Gather(&used, 1, MPI_INT, useds, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (myrank == 0)
+    {
+        for (i = 0; i < world_size; i++)
+        {
+            disps[i] = (i > 0) ? disps[i - 1] + takens[i - 1] : 0;
+            coded_disps[i] = (i > 0) ? coded_disps[i - 1] + useds[i - 1] : 0;
+        }
+        all_indices = (int *)malloc((nchunks + 1) * sizeof(int));
+        all_sizes = (int *)malloc((nchunks + 1) * sizeof(int));
+        all_crcs = (uint32_t *)malloc((nchunks + 1) * sizeof(uint32_t));
+        all_coded = (unsigned char *)malloc(coded_disps[world_size - 1] + useds[world_size - 1] + 1);
+    }
+    MPI_Gatherv(indices, taken, MPI_INT, all_indices, takens, disps, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Gatherv(sizes, taken, MPI_INT, all_sizes, takens, disps, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Gatherv(crcs, taken, MPI_UINT32_T, all_crcs, takens, disps, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+    MPI_Gatherv(coded, used, MPI_CHAR, all_coded, useds, coded_disps, MPI_CHAR, 0, MPI_COMM_WORLD);
+    timer_end(PHASE_GATHER);
+    free(indices);
+    free(sizes);
+    free(crcs);
+    free(coded);
+    MPI_Win_free(&input_win);
+    MPI_Win_free(&counter_win);
+
+    if (myrank == 0)
+    {
+        /* Position of every chunk into the gathered buffer, then chunks in input order */
+        int pos[nchunks + 1], len[nchunks + 1], total = 0;
+        uint32_t chunk_crc[nchunks + 1], crc = 0;
+        for (i = 0; i < world_size; i++)
+        {
+            int p = coded_disps[i];
+            printf("Dynamic: process %d took %d chunks\n", i, takens[i]);
+            for (k = disps[i]; k < disps[i] + takens[i]; k++)
             {
-                node = node->right;
+                pos[all_indices[k]] = p;
+                len[all_indices[k]] = all_sizes[k];
+                chunk_crc[all_indices[k]] = all_crcs[k];
+                p += all_sizes[k];
             }
+        }
+        unsigned char *final_blocks = (unsigned char *)malloc(coded_disps[world_size - 1] + useds[world_size - 1] + 1);
+        for (i = 0; i < nchunks; i++)
+        {
+            memcpy(final_blocks + total, all_coded + pos[i], len[i]);
+            total += len[i];
+            crc = huff_crc32c_combine(crc, chunk_crc[i], (input_size - i * chunk < chunk) ? input_size - i * chunk : chunk);
+        }
+        free(all_indices);
+        free(all_sizes);
+        free(all_crcs);
+        free(all_coded);
+        decode_verify_blocks(final_blocks, total, input_string, start, crc);
+    }
+}
+
+/**
+ * @brief Compresses one task of the batch into its output, or into a part file when the
+ * file has several chunks. No MPI call, so that threads can run it
+ *
+ * @param ctx encoders of the task, with as many threads as the caller gives it
+ * @param pool buffers of the tasks
+ * @param m the manifest
+ * @param t the task
+ * @param block_size size of the blocks
+ * @param verify true to decode the output and compare it with the input
+ * @param out_len location in which save the compressed size
+ * @return true if the output was written
+ */
+bool batch_task(struct huff_block_ctx *ctx, struct huff_pool *pool, struct huff_manifest *m,
+                const struct huff_manifest_task *t, size_t block_size, bool verify, size_t *out_len)
+{
+    char part[4096];
+    const char *output = m->outputs[t->file];
+    bool ok = false;
+    size_t bound = huff_fused_bound(t->len, block_size);
+    unsigned char *in = (unsigned char *)huff_pool_get(pool, t->len + 1);
+    unsigned char *out = (unsigned char *)huff_pool_get(pool, bound + 1);
+    unsigned char *check = verify ? (unsigned char *)huff_pool_get(pool, t->len + 1) : NULL;
 
-            if (isLeaf(node))
+    if (m->nparts[t->file] > 1)
+        output = huff_manifest_part_path(output, t->part, part, sizeof(part));
+    *out_len = 0;
+    if (in == NULL || out == NULL || (verify && check == NULL))
+        fprintf(stderr, "ERROR: Allocation failed!\n");
+    else if (!huff_manifest_read(m->inputs[t->file], t->offset, t->len, in))
+        fprintf(stderr, "ERROR: Can not read [%s]!\n", m->inputs[t->file]);
+    else
+    {
+        /* An empty file is an empty stream */
+        *out_len = (t->len > 0) ? huff_compress_fused_ctx(ctx, in, t->len, block_size, out) : 0;
+        ok = *out_len > 0 || t->len == 0;
+        if (ok && verify && t->len > 0)
+        {
+            size_t check_len = 0;
+            ok = huff_decompress_blocks_ctx(ctx, out, *out_len, check, t->len, &check_len) &&
+                 check_len == t->len && memcmp(check, in, t->len) == 0;
+            if (!ok)
+                fprintf(stderr, "ERROR: Verification of [%s] failed!\n", output);
+        }
+        ok = ok && huff_manifest_write(output, out, *out_len);
+    }
+    huff_pool_put(pool, in);
+    huff_pool_put(pool, out);
+    huff_pool_put(pool, check);
+    return ok;
+}
+
+/**
+ * @brief Batch mode: compresses the files of a manifest in one run, so that MPI startup,
+ * encoders, buffers and optionally the table are paid once for all the files. Processes
+ * claim tasks from a counter on process 0, largest first: a chunk of a large file is
+ * compressed by all the threads of the process, small files are claimed in groups and
+ * compressed by one thread each. The last process done with a chunk of a large file joins
+ * its part files
+ *
+ * @param manifest_file the manifest, read by process 0
+ * @param table_file table shared by the files: loaded if it exists, otherwise built from the
+ *        heads of the files and saved. NULL to give every stream its own tables
+ * @param verify true to decode every output and compare it with its input
+ * @param backend backends the blocks can be coded with
+ * @param block_size size of the blocks
+ * @param myrank rank of the process
+ * @param world_size number of processes
+ */
+void batch_compress(const char *manifest_file, const char *table_file, bool verify, enum huff_backend backend,
+                    size_t block_size, int myrank, int world_size)
+{
+    struct huff_manifest m;
+    struct huff_table table;
+    struct huff_pool pool;
+    char *text = NULL;
+    size_t text_len = 0;
+    unsigned long long text_size, stats[4] = {0}, totals[4] = {0}; /* files, bytes in, bytes out, failures */
+    int ok = 1, missing = 0, nthreads = omp_get_max_threads(), one = 1, i;
+    double start = MPI_Wtime();
+
+    /* Manifest and sizes come from process 0, every process plans the same tasks */
+    timer_begin(PHASE_READ);
+    if (myrank == 0)
+    {
+        text = huff_manifest_load(manifest_file, &text_len);
+        ok = text != NULL;
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!ok)
+    {
+        if (myrank == 0)
+            printf("res: [-1]\n");
+        return;
+    }
+    text_size = text_len;
+    MPI_Bcast(&text_size, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (myrank != 0)
+        text = (char *)malloc(text_size + 1);
+    MPI_Bcast(text, text_size + 1, MPI_CHAR, 0, MPI_COMM_WORLD);
+    if (!huff_manifest_parse(&m, text))
+    {
+        huff_manifest_free(&m);
+        if (myrank == 0)
+            printf("res: [-1]\n");
+        return;
+    }
+    if (myrank == 0)
+        missing = huff_manifest_stat(&m);
+    MPI_Bcast(m.sizes, m.count, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (!huff_manifest_plan(&m, HUFF_MANIFEST_CHUNK))
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    timer_end(PHASE_READ);
+
+    /* Shared table: every process counts the heads of some files, then builds the same table */
+    if (table_file != NULL)
+    {
+        int loaded = 0;
+        huff_table_init(&table, HUFF_BYTE_SYMBOLS);
+        timer_begin(PHASE_TREE);
+        if (myrank == 0)
+            loaded = huff_manifest_load_table(table_file, &table);
+        MPI_Bcast(&loaded, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        timer_end(PHASE_TREE);
+        if (loaded)
+        {
+            timer_begin(PHASE_BCAST);
+            MPI_Bcast(table.lengths, HUFF_BYTE_SYMBOLS, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+            if (myrank != 0)
+                huff_table_from_lengths(&table, table.lengths);
+            timer_end(PHASE_BCAST);
+        }
+        else
+        {
+            unsigned int freq[HUFF_BYTE_SYMBOLS] = {0}, total[HUFF_BYTE_SYMBOLS];
+            timer_begin(PHASE_HISTOGRAM);
+            for (i = myrank; i < m.count; i += world_size)
             {
-                strncat(local_string, &node->data, 1);
-                node = root;
-                last_literal_index = i;
+                if (m.nparts[i] > 0)
+                    huff_manifest_sample(m.inputs[i], HUFF_MANIFEST_SAMPLE, freq);
             }
+            timer_end(PHASE_HISTOGRAM);
+            timer_begin(PHASE_REDUCE);
+            MPI_Allreduce(freq, total, HUFF_BYTE_SYMBOLS, MPI_UNSIGNED, MPI_SUM, MPI_COMM_WORLD);
+            timer_end(PHASE_REDUCE);
+            /* Every symbol gets a code, so that the table can code blocks the heads missed */
+            timer_begin(PHASE_TREE);
+            for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+                total[i]++;
+            huff_table_from_freq(&table, total, HUFF_DEFAULT_MAX_BITS);
+            if (myrank == 0)
+                huff_manifest_save_table(table_file, &table);
+            timer_end(PHASE_TREE);
         }
-        d_node[k].string = (char *)calloc(sizeof(char), len);
-        strncpy(d_node[k].string, local_string, len);
-        d_node[k].padding_bits = (i - last_literal_index - 1);
+    }
+
+    /* Counter of the next task, then the number of chunks done and failed of every file */
+    int *state;
+    MPI_Win win;
+    MPI_Win_allocate((myrank == 0) ? (2 * m.count + 1) * sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD,
+                     &state, &win);
+    if (myrank == 0)
+    {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, win);
+        memset(state, 0, (2 * m.count + 1) * sizeof(int));
+        MPI_Win_unlock(0, win);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
 
-        /* Thread 0, since started from beginning produces only one string */
-        if (thread_rank == 0)
+    /* One context for the tasks of the whole process, one per thread for small files */
+    struct huff_block_ctx team, *single = (struct huff_block_ctx *)malloc(nthreads * sizeof(struct huff_block_ctx));
+    if (single == NULL || !huff_block_ctx_init(&team, backend, nthreads))
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    for (i = 0; i < nthreads; i++)
+    {
+        if (!huff_block_ctx_init(&single[i], backend, 1))
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (table_file != NULL)
+    {
+        huff_block_ctx_share(&team, &table);
+        for (i = 0; i < nthreads; i++)
+            huff_block_ctx_share(&single[i], &table);
+    }
+    huff_pool_init(&pool, 3 * huff_fused_bound(HUFF_MANIFEST_CHUNK, block_size) +
+                              3 * nthreads * huff_fused_bound(HUFF_MANIFEST_SMALL, block_size));
+    bool part_ok[BATCH_GROUP * nthreads];
+
+    MPI_Win_lock_all(0, win);
+    for (;;)
+    {
+        int first, got, next, count = 1, k;
+
+        /* Small tasks are claimed in groups: the claim fails if another process moved the counter */
+        timer_begin(PHASE_SCATTER);
+        MPI_Fetch_and_op(NULL, &first, MPI_INT, 0, 0, MPI_NO_OP, win);
+        MPI_Win_flush(0, win);
+        while (first < m.ntasks)
         {
+            count = 1;
+            while (m.tasks[first].len <= HUFF_MANIFEST_SMALL && count < BATCH_GROUP * nthreads &&
+                   first + count < m.ntasks)
+                count++;
+            next = first + count;
+            MPI_Compare_and_swap(&next, &first, &got, MPI_INT, 0, 0, win);
+            MPI_Win_flush(0, win);
+            if (got == first)
+                break;
+            first = got;
+        }
+        timer_end(PHASE_SCATTER);
+        if (first >= m.ntasks)
             break;
+
+        timer_begin(PHASE_ENCODE);
+        if (count == 1)
+        {
+            size_t out_len;
+            part_ok[0] = batch_task(&team, &pool, &m, &m.tasks[first], block_size, verify, &out_len);
+            stats[1] += part_ok[0] ? m.tasks[first].len : 0;
+            stats[2] += out_len;
+        }
+        else
+        {
+            unsigned long long bytes_in = 0, bytes_out = 0;
+            #pragma omp parallel for schedule(dynamic) reduction(+ : bytes_in, bytes_out)
+            for (k = 0; k < count; k++)
+            {
+                size_t out_len;
+                part_ok[k] = batch_task(&single[omp_get_thread_num()], &pool, &m, &m.tasks[first + k], block_size,
+                                        verify, &out_len);
+                bytes_in += part_ok[k] ? m.tasks[first + k].len : 0;
+                bytes_out += out_len;
+            }
+            stats[1] += bytes_in;
+            stats[2] += bytes_out;
+        }
+        timer_end(PHASE_ENCODE);
+
+        /* A file is done with its only task, or once its last chunk is done */
+        for (k = 0; k < count; k++)
+        {
+            const struct huff_manifest_task *t = &m.tasks[first + k];
+            int done = 0;
+            stats[3] += !part_ok[k];
+            if (m.nparts[t->file] == 1)
+            {
+                stats[0] += part_ok[k];
+                continue;
+            }
+            /* Failures are counted before the chunk is done, so the last process sees all of them */
+            if (!part_ok[k])
+            {
+                MPI_Fetch_and_op(&one, &done, MPI_INT, 0, 1 + m.count + t->file, MPI_SUM, win);
+                MPI_Win_flush(0, win);
+            }
+            MPI_Fetch_and_op(&one, &done, MPI_INT, 0, 1 + t->file, MPI_SUM, win);
+            MPI_Win_flush(0, win);
+            if (done == m.nparts[t->file] - 1)
+            {
+                int failed_parts;
+                MPI_Fetch_and_op(NULL, &failed_parts, MPI_INT, 0, 1 + m.count + t->file, MPI_NO_OP, win);
+                MPI_Win_flush(0, win);
+                /* A failed chunk wrote no part: the join could pick up a stale one */
+                bool joined = failed_parts == 0 && huff_manifest_join(m.outputs[t->file], m.nparts[t->file]);
+                if (failed_parts > 0)
+                    huff_manifest_remove_parts(m.outputs[t->file], m.nparts[t->file], true);
+                stats[0] += joined;
+                stats[3] += !joined;
+            }
         }
     }
+    MPI_Win_unlock_all(win);
+    timer_add_bytes(PHASE_ENCODE, stats[1]);
 
-    return d_node;
+    MPI_Reduce(stats, totals, 4, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (myrank == 0)
+    {
+        double elapsed = MPI_Wtime() - start;
+        int files = m.count - missing;
+        totals[3] += missing;
+        printf("Batch: %d files, %.2f MB in, %.2f MB out, %d tasks, %.3f s, %.1f us per file\n", files,
+               totals[1] / 1e6, totals[2] / 1e6, m.ntasks, elapsed, (files > 0) ? elapsed * 1e6 / files : 0.0);
+        if (totals[3] > 0)
+            fprintf(stderr, "ERROR: %llu batch tasks failed!\n", totals[3]);
+        printf("res: [%d]\n", (totals[3] == 0 && totals[0] == (unsigned long long)files) ? 0 : -1);
+    }
+
+    MPI_Win_free(&win);
+    huff_pool_free(&pool);
+    for (i = 0; i < nthreads; i++)
+        huff_block_ctx_free(&single[i]);
+    free(single);
+    huff_block_ctx_free(&team);
+    if (table_file != NULL)
+        huff_table_free(&table);
+    huff_manifest_free(&m);
+}
+
+/**
+ * @brief Decompresses a file of blocks (e.g an output of the batch mode) to disk on process 0
+ * with huff_decompress_stream(): memory is bounded by the ring of slots whatever the size
+ * of the file, and the first bytes are written after the first block is decoded
+ *
+ * @param in_path compressed file
+ * @param out_path decoded file
+ * @param table_file shared table of the batch mode, NULL if none
+ * @param slots slots of the ring, 0 for the default
+ * @param myrank rank of the process
+ */
+void stream_decompress(const char *in_path, const char *out_path, const char *table_file, int slots, int myrank)
+{
+    struct huff_block_ctx ctx;
+    struct huff_table table;
+    struct huff_stream_stats stats;
+    bool ok = true;
+
+    if (myrank != 0)
+        return;
+    if (!huff_block_ctx_init(&ctx, HUFF_BACKEND_AUTO, 0))
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    huff_table_init(&table, HUFF_BYTE_SYMBOLS);
+    if (table_file != NULL)
+    {
+        ok = huff_manifest_load_table(table_file, &table);
+        if (!ok)
+            fprintf(stderr, "ERROR: Can not read table [%s]!\n", table_file);
+        huff_block_ctx_share(&ctx, &table);
+    }
+    timer_begin(PHASE_DECODE);
+    ok = ok && huff_decompress_stream(&ctx, in_path, out_path, slots, &stats);
+    timer_end(PHASE_DECODE);
+    if (ok)
+    {
+        timer_add_bytes(PHASE_DECODE, stats.raw_bytes);
+        printf("Stream: %zu blocks, %.2f MB, first byte after %.3f ms, %.3f s, at most %d blocks in flight, "
+               "ring %zu KB\n", stats.blocks, stats.raw_bytes / 1e6, stats.first_byte * 1e3, stats.seconds,
+               stats.max_inflight, stats.ring_bytes / 1024);
+        printf("Checksum: %08x\n", stats.crc);
+    }
+    printf("res: [%d]\n", ok ? 0 : -1);
+    huff_table_free(&table);
+    huff_block_ctx_free(&ctx);
 }
 
-/* Main code */
 int main(int argc, char **argv)
 {
     // Initialize the MPI environment
@@ -297,32 +1593,159 @@ int main(int argc, char **argv)
 
     // Reading number of threads    
     int thread_count = atoi(argv[1]);
-    char *input_string, *out_alphabet;
+
+    /* Optional modes */
+    bool fused_mode = false, token_mode = false;
+    enum huff_backend backend = HUFF_BACKEND_AUTO;
+    int context_classes = 0; /* 0 means order-0 */
+    size_t adaptive_interval = 0; /* 0 means two-pass coding */
+    int pipeline_chunks = 0; /* 0 means bulk-synchronous collectives */
+    int decode_slices = DECODE_SLICES; /* 1 means one static slice per thread */
+    bool weighted = false, weighted_profile = false;
+    int dynamic_chunk = 0; /* 0 means a piece for every process */
+    bool shared = false;
+    enum timer_format timers = TIMER_OFF;
+    bool counters = false, autotune = false;
+    char *profile_file = HUFF_PROFILE_FILE;
+    enum huff_numa_policy numa_policy = HUFF_NUMA_DEFAULT;
+    char *bind_layout = NULL;
+    char *batch_manifest = NULL, *batch_table = NULL; /* NULL means the single input file */
+    bool batch_verify = false;
+    char *stream_in = NULL, *stream_out = NULL; /* NULL means no streaming decompression */
+    int stream_slots = 0;
+    int arg;
+    for (arg = 2; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--fused") == 0)
+            fused_mode = true;
+        else if (strncmp(argv[arg], "--backend=", 10) == 0)
+        {
+            /* Backend selection implies the fused mode */
+            fused_mode = true;
+            if (strcmp(argv[arg] + 10, "huffman") == 0)
+                backend = HUFF_BACKEND_HUFFMAN;
+            else if (strcmp(argv[arg] + 10, "ans") == 0)
+                backend = HUFF_BACKEND_ANS;
+            else if (strcmp(argv[arg] + 10, "auto") == 0)
+                backend = HUFF_BACKEND_AUTO;
+            else
+            {
+                if (myrank == 0)
+                    fprintf(stderr, "Usage: %s <threads> [--backend=auto|huffman|ans] ...\n", argv[0]);
+                MPI_Finalize();
+                return 1;
+            }
+        }
+        else if (strcmp(argv[arg], "--tokens") == 0)
+            token_mode = true;
+        else if (strcmp(argv[arg], "--order1") == 0)
+            context_classes = HUFF_CONTEXT_ORDER1;
+        else if (strncmp(argv[arg], "--order1=", 9) == 0)
+            context_classes = atoi(argv[arg] + 9);
+        else if (strcmp(argv[arg], "--adaptive") == 0)
+            adaptive_interval = HUFF_ADAPTIVE_INTERVAL;
+        else if (strncmp(argv[arg], "--adaptive=", 11) == 0)
+            adaptive_interval = (size_t)atoi(argv[arg] + 11) * 1024;
+        else if (strcmp(argv[arg], "--timers") == 0)
+            timers = TIMER_TEXT;
+        else if (strcmp(argv[arg], "--timers=json") == 0)
+            timers = TIMER_JSON;
+        else if (strcmp(argv[arg], "--counters") == 0)
+            counters = true;
+        else if (strcmp(argv[arg], "--pipelined") == 0)
+            pipeline_chunks = PIPELINE_CHUNKS;
+        else if (strncmp(argv[arg], "--pipelined=", 12) == 0)
+            pipeline_chunks = atoi(argv[arg] + 12);
+        else if (strcmp(argv[arg], "--shared") == 0)
+            shared = true;
+        else if (strcmp(argv[arg], "--weighted") == 0)
+            weighted = true;
+        else if (strcmp(argv[arg], "--weighted=profile") == 0)
+            weighted = weighted_profile = true;
+        else if (strcmp(argv[arg], "--dynamic") == 0)
+            dynamic_chunk = DYNAMIC_CHUNK;
+        else if (strncmp(argv[arg], "--dynamic=", 10) == 0)
+            dynamic_chunk = ((atoi(argv[arg] + 10) > 0) ? atoi(argv[arg] + 10) : 1) * 1024;
+        else if (strcmp(argv[arg], "--numa") == 0 || strcmp(argv[arg], "--numa=first-touch") == 0)
+            numa_policy = HUFF_NUMA_FIRST_TOUCH;
+        else if (strcmp(argv[arg], "--numa=interleave") == 0)
+            numa_policy = HUFF_NUMA_INTERLEAVE;
+        else if (strncmp(argv[arg], "--bind=", 7) == 0)
+            bind_layout = argv[arg] + 7;
+        else if (strncmp(argv[arg], "--slices=", 9) == 0)
+            decode_slices = (atoi(argv[arg] + 9) > 0) ? atoi(argv[arg] + 9) : 1;
+        else if (strcmp(argv[arg], "--autotune") == 0)
+            autotune = true;
+        else if (strncmp(argv[arg], "--profile=", 10) == 0)
+            profile_file = argv[arg] + 10;
+        else if (strncmp(argv[arg], "--batch=", 8) == 0)
+            batch_manifest = argv[arg] + 8;
+        else if (strncmp(argv[arg], "--batch-table=", 14) == 0)
+            batch_table = argv[arg] + 14;
+        else if (strcmp(argv[arg], "--verify") == 0)
+            batch_verify = true;
+        else if (strncmp(argv[arg], "--decompress=", 13) == 0)
+            stream_in = argv[arg] + 13;
+        else if (strncmp(argv[arg], "--output=", 9) == 0)
+            stream_out = argv[arg] + 9;
+        else if (strncmp(argv[arg], "--ring=", 7) == 0)
+            stream_slots = atoi(argv[arg] + 7);
+    }
+    /* Counters are reported with the timers */
+    if (counters && timers == TIMER_OFF)
+        timers = TIMER_TEXT;
+    timers_init(timers, counters);
+
+    /* Placement of the large buffers of process 0 and pinning of the threads of every process */
+    huff_numa_set_policy(numa_policy);
+    if (bind_layout != NULL)
+        huff_bind_threads(bind_layout);
+    if (myrank == 0 && (bind_layout != NULL || numa_policy != HUFF_NUMA_DEFAULT))
+        huff_numa_report_threads();
+    bool block_mode = fused_mode || token_mode || context_classes > 0 || adaptive_interval > 0 || dynamic_chunk > 0;
+    /* Shared-memory or pipelined collectives replace the ones of the two-pass pipeline */
+    shared = shared && !block_mode;
+    bool pipelined = pipeline_chunks > 0 && !block_mode && !shared;
+    struct node_topology topo;
+    if (shared)
+        topology_init(&topo, myrank, world_size);
+
+    /* Block modes use the profile of a previous --autotune run, if any */
+    struct huff_profile profile;
+    huff_profile_defaults(&profile);
+    bool use_profile = block_mode && !autotune && huff_profile_load(&profile, profile_file);
+
+    /* Batch and streaming modes replace the whole pipeline, files are read by the tasks */
+    if (batch_manifest != NULL || stream_in != NULL)
+    {
+        if (huff_profile_load(&profile, profile_file))
+            huff_profile_apply(&profile);
+        if (batch_manifest != NULL)
+            batch_compress(batch_manifest, batch_table, batch_verify, backend, profile.block_size, myrank,
+                           world_size);
+        else
+        {
+            char default_out[4096];
+            snprintf(default_out, sizeof(default_out), "%s.out", stream_in);
+            stream_decompress(stream_in, (stream_out != NULL) ? stream_out : default_out, batch_table,
+                              stream_slots, myrank);
+        }
+        timers_report(MPI_COMM_WORLD);
+        MPI_Finalize();
+        return 0;
+    }
+    char *input_string = NULL, *out_alphabet;
     int frequencies[sizeof(alphabeth) / sizeof(char)] = {0};
     int reduce_buff[sizeof(alphabeth) / sizeof(char)] = {0};
     char recv_buff[RECV_SIZE] = {""};
-    int *out_freq, *displs, *sendcount;
+    char *piece = recv_buff; /* piece of this process, into the node window with --shared */
+    int input_size = 0;
+    int *out_freq, *displs = NULL, *sendcount = NULL;
     char start_scatter = '0';
     size = strlen(alphabeth);
 
     /* Timing data */
     double start, finish;
-    /* Derived datatype for struct 'mpi_codeblock' */
-    /* This is needed in order to be able to send 
-    * decoded candidate nodes to a collector (Process 0)
-    */
-    const int nitems = 2;
-    int blocklengths[2] = {1, CODES_LEN};
-    MPI_Datatype types[2] = {MPI_CHAR, MPI_CHAR};
-    MPI_Aint offsets[2];
-    MPI_Datatype mpi_codeblock;
-    MPI_Datatype mpi_codelist;
-    offsets[0] = offsetof(struct nlist, name);
-    offsets[1] = offsetof(struct nlist, code);
-    MPI_Type_create_struct(nitems, blocklengths, offsets, types, &mpi_codeblock);
-    MPI_Type_commit(&mpi_codeblock);
-    MPI_Type_contiguous(HASHSIZE, mpi_codeblock, &mpi_codelist);
-    MPI_Type_commit(&mpi_codelist);
     
     /* Here actual program starts. The MPI process 0 will:
     *   1) Read the input from file.
@@ -334,12 +1757,15 @@ int main(int argc, char **argv)
     if (myrank == 0)
     {
         /* Reading string from default file */
-        input_string = (char*)calloc(sizeof(char), INPUT_SIZE);
+        timer_begin(PHASE_READ);
+        input_string = (char*)huff_numa_calloc(sizeof(char), INPUT_SIZE);
         char default_textfile[] = "input.txt";
-        read_input_string(input_string, INPUT_SIZE, default_textfile);
+        /* Room for the terminator, also in the RECV_SIZE piece of a single process */
+        read_input_string(input_string, INPUT_SIZE - 1, default_textfile);
+        timer_end(PHASE_READ);
 
         /* Calculating substing per process */
-        int input_size = strlen(input_string);
+        input_size = strlen(input_string);
         int padding = input_size % world_size;
         int size_per_process = floor(input_size / world_size);
         int k = 0, i = 0;
@@ -361,37 +1787,132 @@ int main(int argc, char **argv)
                 k += size_per_process;
             }
         }
-        
+
+        /* Calibration on a piece of the size of one process */
+        if (autotune && block_mode)
+        {
+            int sample_len = (size_per_process > 0) ? size_per_process : input_size;
+            if (huff_autotune((unsigned char *)input_string, sample_len, backend, &profile))
+            {
+                huff_profile_save(&profile, profile_file);
+                use_profile = true;
+            }
+        }
+    }
+    if (autotune && block_mode)
+        MPI_Bcast(&use_profile, sizeof(bool), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    /* Pieces proportional to the throughput of every process, from its profile if asked */
+    if (weighted && dynamic_chunk == 0)
+    {
+        struct huff_profile own;
+        huff_profile_defaults(&own);
+        double mbps = (weighted_profile && huff_profile_load(&own, profile_file)) ? own.enc_mbps : 0;
+        weighted_partition(input_string, input_size, sendcount, displs, mbps, block_mode, backend,
+                           profile.block_size, myrank, world_size);
+    }
+    if (use_profile)
+    {
+        if (autotune)
+            MPI_Bcast(&profile, sizeof(profile), MPI_BYTE, 0, MPI_COMM_WORLD);
+        huff_profile_apply(&profile);
+        if (myrank == 0)
+            printf("Profile: block %zu bytes, lookup %d bits, %d threads, %d ranks per node suggested\n",
+                   profile.block_size, profile.lookup_bits, profile.threads, profile.ranks_per_node);
     }
 
     /* Process 0 starts timer for measuring encoding time */
     if (myrank == 0)
         start = MPI_Wtime();
 
+    timer_begin(PHASE_SCATTER);
     MPI_Bcast(&start_scatter, 1, MPI_CHAR, 0, MPI_COMM_WORLD);
     /*MPI_Scatterv and MPI_Reduce are done only if the input can be divided into processes */
-    if (start_scatter == '1')
+    if (start_scatter == '1' && shared)
+    {
+        /* Every process lays out the pieces of its node */
+        if (myrank != 0)
+        {
+            sendcount = malloc(world_size * sizeof(int));
+            displs = malloc(world_size * sizeof(int));
+        }
+        MPI_Bcast(sendcount, world_size, MPI_INT, 0, MPI_COMM_WORLD);
+        MPI_Bcast(displs, world_size, MPI_INT, 0, MPI_COMM_WORLD);
+        timer_end(PHASE_SCATTER);
+        piece = shared_scatter_count(&topo, input_string, sendcount, displs, frequencies, reduce_buff,
+                                     sizeof(frequencies) / sizeof(int), myrank, world_size);
+    }
+    else if (start_scatter == '1' && pipelined)
     {
-        
-	MPI_Scatterv(input_string, sendcount, displs, MPI_CHAR, recv_buff, RECV_SIZE, MPI_CHAR, 0, MPI_COMM_WORLD);
-	calculate_frequencies(alphabeth, recv_buff, frequencies);
-	MPI_Reduce(frequencies, reduce_buff, sizeof(frequencies) / sizeof(int), MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+        timer_end(PHASE_SCATTER);
+        pipelined_scatter_count(input_string, sendcount, displs, recv_buff, reduce_buff,
+                                sizeof(frequencies) / sizeof(int), myrank, world_size, pipeline_chunks);
+    }
+    else if (dynamic_chunk > 0)
+    {
+        /* Processes take chunks themselves */
+        timer_end(PHASE_SCATTER);
+    }
+    else if (start_scatter == '1')
+    {
+        /* Exact size of the piece of this process, as the pieces may be unequal */
+        int mine;
+        MPI_Scatter(sendcount, 1, MPI_INT, &mine, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        MPI_Scatterv(input_string, sendcount, displs, MPI_CHAR, recv_buff, mine, MPI_CHAR, 0, MPI_COMM_WORLD);
+        timer_end(PHASE_SCATTER);
+        if (!block_mode)
+        {
+            timer_begin(PHASE_HISTOGRAM);
+            calculate_frequencies(alphabeth, recv_buff, frequencies);
+            timer_end(PHASE_HISTOGRAM);
+            timer_add_bytes(PHASE_HISTOGRAM, strlen(recv_buff));
+            timer_begin(PHASE_REDUCE);
+            MPI_Allreduce(frequencies, reduce_buff, sizeof(frequencies) / sizeof(int), MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+            timer_end(PHASE_REDUCE);
+        }
 
     }else if (myrank == 0){
         /* Otherwise only process 0 calculates the frequences for the entire string */
         /* This situation may happen when the input string is very short */
-        calculate_frequencies(alphabeth, input_string, reduce_buff);
+        timer_end(PHASE_SCATTER);
+        timer_begin(PHASE_HISTOGRAM);
+        if (!block_mode)
+            calculate_frequencies(alphabeth, input_string, reduce_buff);
         strncpy(recv_buff, input_string, strlen(input_string));
+        timer_end(PHASE_HISTOGRAM);
     }
 
+    /* Fused, token, order-1 and adaptive modes replace the rest of the pipeline */
+    if (block_mode)
+    {
+        if (dynamic_chunk > 0)
+            dynamic_encode_decode(input_string, input_size, myrank, world_size, start, backend, profile.block_size,
+                                  dynamic_chunk);
+        else if (fused_mode)
+            fused_encode_decode(recv_buff, input_string, myrank, world_size, start, backend, profile.block_size);
+        else if (token_mode)
+            token_encode_decode(recv_buff, input_string, myrank, world_size, start);
+        else if (adaptive_interval > 0)
+            adaptive_encode_decode(recv_buff, input_string, myrank, world_size, start, adaptive_interval);
+        else
+            context_encode_decode(recv_buff, input_string, myrank, world_size, start, context_classes);
+        if (myrank == 0)
+            free(input_string);
+        free(sendcount);
+        free(displs);
+        timers_report(MPI_COMM_WORLD);
+        MPI_Finalize();
+        return 0;
+    }
 
-    /* Waiting every process to complete frequencies calculation */
-    MPI_Barrier(MPI_COMM_WORLD);
 
-    struct MinHeapNode *root;
-    /* Process 0 takes care of preparing alphabet and frequencies output arrays */
-    if (myrank == 0)
+    struct MinHeapNode *root = NULL;
+    /* Every process got the global frequencies from the Allreduce and builds the same tree */
+    /* (ties are broken by creation order), so the code-word table needs no broadcast. */
+    /* Very short inputs are only counted by process 0 */
+    if (start_scatter == '1' || myrank == 0)
     {
+        timer_begin(PHASE_TREE);
         int len = strlen(alphabeth);
         out_alphabet = (char *)calloc(len, sizeof(char));
         out_freq = (int *)calloc(len, sizeof(int));
@@ -410,10 +1931,12 @@ int main(int argc, char **argv)
 
         /* Build Huff-tree */
         root = HuffmanCodes(out_alphabet, out_freq, count);
+        timer_end(PHASE_TREE);
 
         char arr[MAX_TREE_HT];
         int top = 0;
 
+        timer_begin(PHASE_CODE_TABLE);
         if (thread_count == 1)
         {
             FillCodesList(root, arr, top);
@@ -434,6 +1957,7 @@ int main(int argc, char **argv)
                 }
             }
         }
+        timer_end(PHASE_CODE_TABLE);
         // for (i = 0; i < count; i++)
         // {
         //     /* Only for debug, comment in production */
@@ -443,33 +1967,56 @@ int main(int argc, char **argv)
         free(out_alphabet);
     }
 
-    /* Sending code-word table to all processes */
-    /* In this way each process can encode a piece of the intial input-string */
-    MPI_Bcast(codes_list, 1, mpi_codelist, 0, MPI_COMM_WORLD);
-    
+    /* Checksum of the piece, combined on process 0 into the one the decoder must match */
+    timer_begin(PHASE_ENCODE);
+    uint32_t input_crc = huff_crc32c(0, piece, strlen(piece));
+    timer_end(PHASE_ENCODE);
+    if (start_scatter == '1')
+        input_crc = gather_crc(input_crc, strlen(piece), myrank, world_size);
 
     char *out, *final_string;
-    out = calculate_huff_code(recv_buff);
-
-    /* When scatter equals to 1 process 0 collect with a MPO_Gatherv all the encoded string from the other processes. */
-    if (start_scatter == '1')
+    if (start_scatter == '1' && pipelined)
     {
-        int counts[world_size], gather_disps[world_size], i;
-        int nelem = strlen(out);
-        MPI_Gather(&nelem, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
-        for (i = 0; i < world_size; i++)
-            gather_disps[i] = (i > 0) ? (gather_disps[i - 1] + counts[i - 1]) : 0;
+        /* Encoding overlaps the gather, process 0 gets the whole encoded string */
+        final_string = pipelined_encode_gather(recv_buff, myrank, world_size, pipeline_chunks);
+    }
+    else
+    {
+        timer_begin(PHASE_ENCODE);
+        out = calculate_huff_code(piece);
+        timer_end(PHASE_ENCODE);
+        timer_add_bytes(PHASE_ENCODE, strlen(piece));
+        if (out == NULL)
+            MPI_Abort(MPI_COMM_WORLD, 1);
 
-        if (myrank == 0)
-            final_string = (char *)calloc(gather_disps[world_size - 1] + counts[world_size - 1], sizeof(char));
+        /* When scatter equals to 1 process 0 collect with a MPO_Gatherv all the encoded string from the other processes. */
+        timer_begin(PHASE_GATHER);
+        if (start_scatter == '1' && shared)
+        {
+            final_string = shared_gather(&topo, out, myrank, world_size);
+            topology_free(&topo);
+        }
+        else if (start_scatter == '1')
+        {
+            int counts[world_size], gather_disps[world_size], i;
+            int nelem = strlen(out);
+            MPI_Gather(&nelem, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+            for (i = 0; i < world_size; i++)
+                gather_disps[i] = (i > 0) ? (gather_disps[i - 1] + counts[i - 1]) : 0;
+
+            if (myrank == 0)
+                final_string = (char *)huff_numa_calloc(gather_disps[world_size - 1] + counts[world_size - 1] + 1, sizeof(char));
 
-        MPI_Gatherv(out, nelem, MPI_CHAR, final_string, counts, gather_disps, MPI_CHAR, 0, MPI_COMM_WORLD);
-        MPI_Barrier(MPI_COMM_WORLD);
-    }else if(myrank == 0){
-        /*Otherwise the process 0 don't collect anything from other process and set final_string variable with
-         the content of out */
-        final_string = (char *)calloc(strlen(out), sizeof(char));
-        strncpy(final_string, out, strlen(out));
+            MPI_Gatherv(out, nelem, MPI_CHAR, final_string, counts, gather_disps, MPI_CHAR, 0, MPI_COMM_WORLD);
+            MPI_Barrier(MPI_COMM_WORLD);
+        }else if(myrank == 0){
+            /*Otherwise the process 0 don't collect anything from other process and set final_string variable with
+             the content of out */
+            final_string = (char *)huff_numa_calloc(strlen(out) + 1, sizeof(char));
+            strncpy(final_string, out, strlen(out));
+        }
+        timer_end(PHASE_GATHER);
+        free(out);
     }
     
     
@@ -485,58 +2032,118 @@ int main(int argc, char **argv)
     if(myrank == 0){
         int len, i; 
 	    len = strlen(final_string);
-        int padding = len % thread_count;
-        int size_per_process = floor(len / thread_count);
+        /* The string is split into more slices than threads, scheduled with work stealing */
+        int nslices = thread_count * decode_slices;
+        int padding = len % nslices;
+        int size_per_process = floor(len / nslices);
         double tstart, tstop;
         int offset = 5;
         if (size_per_process < offset)
         {
             thread_count = 1;
             omp_set_num_threads(1);
+            nslices = 1;
             size_per_process = len;
             padding = 0;
         }
-        struct decoded_node **decoded_list = (struct decoded_node **)malloc(sizeof(decoded_list) * thread_count);
-        char *final_decoded_string = (char *)calloc(len, sizeof(char));
+        /* Candidates of every slice live in the decoder, one allocation for all of them */
+        struct decoded_node **decoded_list = (struct decoded_node **)malloc(sizeof(decoded_list) * nslices);
+        char *final_decoded_string = (char *)huff_numa_calloc(len + 1, sizeof(char));
+        struct huff_string_decoder decoder;
+        struct huff_sched sched;
+        huff_string_decoder_init(&decoder);
+        if (!huff_string_decoder_reserve(&decoder, nslices, size_per_process, padding, offset))
+        {
+            fprintf(stderr, "ERROR: Decoder allocation failed!\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        huff_sched_init(&sched, nslices, omp_get_max_threads());
 
-        /* Parallel decoding */
+        /* Parallel decoding, candidates are placed by slice index */
         tstart = omp_get_wtime();
         #pragma omp parallel 
         {
 	    printf("Thread num %d\n", omp_get_thread_num());
-            decoded_list[omp_get_thread_num()] = decode_string(root, final_string, size_per_process, padding, thread_count - 1, offset);
+            size_t slice;
+            timer_begin(PHASE_DECODE);
+            while (huff_sched_next(&sched, omp_get_thread_num(), &slice))
+            {
+                decoded_list[slice] = huff_string_decode_slice(&decoder, root, final_string, len, slice, size_per_process,
+                                                               padding, nslices - 1);
+                timer_add_bytes(PHASE_DECODE, size_per_process);
+            }
+            timer_end(PHASE_DECODE);
         }
+        huff_sched_free(&sched);
         int bits;
         tstop = omp_get_wtime();
-        char *temp_string;
+        char *chosen[nslices];
+        size_t chosen_len[nslices], chosen_pos[nslices];
+        uint32_t chosen_crc[nslices], crc = 0;
         printf("Merging of decoded contributions\n");
+        timer_begin(PHASE_MERGE);
 
-        /* Thread 0 token is special, getting bits */
-        temp_string = decoded_list[0][0].string;
+        /* Thread 0 token is special, getting bits. Other slices follow the chain of bits */
+        int merged = nslices;
+        chosen[0] = decoded_list[0][0].string;
         bits = decoded_list[0][0].padding_bits;
-        strncat(final_decoded_string, temp_string, strlen(temp_string));
-    
-        /* Other threads tokens */
-        for (i = 1; i < thread_count; i++)
+        for (i = 1; i < nslices; i++)
         {
-            temp_string = decoded_list[i][bits].string;
+            /* Every slice has one candidate per start bit below 'offset', a longer code overruns them */
+            if (bits < 0 || bits >= offset)
+            {
+                fprintf(stderr, "ERROR: Slice %d starts %d bits into a code, only %d candidates!\n", i, bits, offset);
+                merged = i;
+                break;
+            }
+            chosen[i] = decoded_list[i][bits].string;
             bits = decoded_list[i][bits].padding_bits;
-            strncat(final_decoded_string, temp_string, strlen(temp_string));
         }
 
+        /* Checksums of the chosen candidates while they are copied, slices in parallel */
+        #pragma omp parallel for schedule(dynamic)
+        for (i = 0; i < merged; i++)
+        {
+            chosen_len[i] = strlen(chosen[i]);
+            chosen_crc[i] = huff_crc32c(0, chosen[i], chosen_len[i]);
+        }
+        for (i = 0; i < merged; i++)
+        {
+            chosen_pos[i] = (i > 0) ? chosen_pos[i - 1] + chosen_len[i - 1] : 0;
+            crc = huff_crc32c_combine(crc, chosen_crc[i], chosen_len[i]);
+        }
+        #pragma omp parallel for schedule(dynamic)
+        for (i = 0; i < merged; i++)
+            memcpy(final_decoded_string + chosen_pos[i], chosen[i], chosen_len[i]);
+        timer_end(PHASE_MERGE);
+
         tstop = omp_get_wtime();
         printf("Decoding execution time: %f\n", tstop - tstart);
-	    /* Verify of correctness */
-        int res = strcmp(input_string, final_decoded_string);
+	    /* Verify of correctness: checksums of the decoded slices against the one of the encoders */
+        timer_begin(PHASE_VERIFY);
+        int res = (merged == nslices && crc == input_crc) ? 0 : -1;
+        timer_end(PHASE_VERIFY);
+        printf("Checksum: %08x, expected %08x\n", crc, input_crc);
         printf("res: [%d]\n", res);
+        if (huff_numa_get_policy() != HUFF_NUMA_DEFAULT)
+        {
+            huff_numa_report("input_string", input_string, INPUT_SIZE);
+            huff_numa_report("final_string", final_string, len);
+            huff_numa_report("final_decoded_string", final_decoded_string, len);
+        }
         free(decoded_list);
+        huff_string_decoder_free(&decoder);
+        free(final_decoded_string);
         free(final_string);
         free(input_string);
     }
+    freeTree(root);
+    free(sendcount);
+    free(displs);
+
+    timers_report(MPI_COMM_WORLD);
 
     // Finalize the MPI environment.
-    MPI_Type_free(&mpi_codelist);
-    MPI_Type_free(&mpi_codeblock);
     MPI_Finalize();
     return 0;
 }
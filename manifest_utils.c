@@ -0,0 +1,361 @@
+/**
+ * @file manifest_utils.c
+ * @brief Implementation of the manifest and file helpers of the batch mode
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "manifest_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* Copies are done through a buffer of this size */
+#define HUFF_MANIFEST_COPY (1024 * 1024)
+
+/**
+ * @brief Reads a whole text file
+ *
+ * @param filename the file
+ * @param len location in which save the size
+ * @return the text, NUL terminated, NULL on failure
+ */
+char *huff_manifest_load(const char *filename, size_t *len)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not read manifest [%s]!\n", filename);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *text = (size >= 0) ? (char *)malloc(size + 1) : NULL;
+    if (text == NULL || fread(text, 1, size, fp) != (size_t)size)
+    {
+        fprintf(stderr, "ERROR: Can not read manifest [%s]!\n", filename);
+        free(text);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    text[size] = '\0';
+    *len = size;
+    return text;
+}
+
+/**
+ * @brief Splits a manifest into files: one "input output" pair per line, separated by
+ * spaces or tabs. Empty lines and lines starting with '#' are skipped
+ *
+ * @param m manifest to initialize
+ * @param text manifest text, owned by the manifest afterwards
+ * @return true if every line is a pair
+ */
+bool huff_manifest_parse(struct huff_manifest *m, char *text)
+{
+    char *line, *next;
+    int lines = 1, number = 0, n = 0;
+    memset(m, 0, sizeof(struct huff_manifest));
+    m->text = text;
+    for (line = text; *line != '\0'; line++)
+        lines += (*line == '\n');
+    m->inputs = (char **)malloc(lines * sizeof(char *));
+    m->outputs = (char **)malloc(lines * sizeof(char *));
+    m->sizes = (unsigned long long *)calloc(lines, sizeof(unsigned long long));
+    m->nparts = (int *)calloc(lines, sizeof(int));
+    if (m->inputs == NULL || m->outputs == NULL || m->sizes == NULL || m->nparts == NULL)
+        return false;
+
+    for (line = text; line != NULL; line = next)
+    {
+        char *in, *out, *extra;
+        number++;
+        next = strchr(line, '\n');
+        if (next != NULL)
+            *next++ = '\0';
+        in = strtok(line, " \t\r");
+        if (in == NULL || in[0] == '#')
+            continue;
+        out = strtok(NULL, " \t\r");
+        extra = strtok(NULL, " \t\r");
+        if (out == NULL || extra != NULL)
+        {
+            fprintf(stderr, "ERROR: Manifest line %d is not an \"input output\" pair!\n", number);
+            return false;
+        }
+        m->inputs[n] = in;
+        m->outputs[n] = out;
+        n++;
+    }
+    m->count = n;
+    return true;
+}
+
+/**
+ * @brief Sizes of the input files
+ *
+ * @param m the manifest
+ * @return number of unreadable files
+ */
+int huff_manifest_stat(struct huff_manifest *m)
+{
+    struct stat st;
+    int i, missing = 0;
+    for (i = 0; i < m->count; i++)
+    {
+        if (stat(m->inputs[i], &st) == 0 && S_ISREG(st.st_mode))
+            m->sizes[i] = st.st_size;
+        else
+        {
+            fprintf(stderr, "ERROR: Can not read [%s]!\n", m->inputs[i]);
+            m->sizes[i] = (unsigned long long)-1;
+            missing++;
+        }
+    }
+    return missing;
+}
+
+/* Largest tasks first, chunks of a file in order */
+static int task_order(const void *a, const void *b)
+{
+    const struct huff_manifest_task *x = (const struct huff_manifest_task *)a, *y = (const struct huff_manifest_task *)b;
+    if (x->len != y->len)
+        return (x->len < y->len) ? 1 : -1;
+    if (x->file != y->file)
+        return (x->file < y->file) ? -1 : 1;
+    return x->part - y->part;
+}
+
+/**
+ * @brief Splits the files into tasks of at most 'chunk' bytes, largest first so that small
+ * tasks balance the end of the run. Unreadable files get no task
+ *
+ * @param m the manifest, with its sizes
+ * @param chunk max size of a task e.g HUFF_MANIFEST_CHUNK
+ * @return true if allocation did not fail
+ */
+bool huff_manifest_plan(struct huff_manifest *m, size_t chunk)
+{
+    int i, k, n = 0;
+    for (i = 0; i < m->count; i++)
+    {
+        m->nparts[i] = 0;
+        if (m->sizes[i] != (unsigned long long)-1)
+            m->nparts[i] = (m->sizes[i] > chunk) ? (m->sizes[i] + chunk - 1) / chunk : 1;
+        n += m->nparts[i];
+    }
+    m->tasks = (struct huff_manifest_task *)malloc((n + 1) * sizeof(struct huff_manifest_task));
+    if (m->tasks == NULL)
+        return false;
+    m->ntasks = 0;
+    for (i = 0; i < m->count; i++)
+    {
+        for (k = 0; k < m->nparts[i]; k++)
+        {
+            struct huff_manifest_task *t = &m->tasks[m->ntasks++];
+            t->file = i;
+            t->part = k;
+            t->offset = (size_t)k * chunk;
+            t->len = (m->sizes[i] - t->offset < chunk) ? m->sizes[i] - t->offset : chunk;
+        }
+    }
+    qsort(m->tasks, m->ntasks, sizeof(struct huff_manifest_task), task_order);
+    return true;
+}
+
+/**
+ * @brief Releases the manifest
+ *
+ * @param m the manifest
+ */
+void huff_manifest_free(struct huff_manifest *m)
+{
+    free(m->text);
+    free(m->inputs);
+    free(m->outputs);
+    free(m->sizes);
+    free(m->nparts);
+    free(m->tasks);
+    memset(m, 0, sizeof(struct huff_manifest));
+}
+
+/**
+ * @brief Reads a chunk of a file
+ *
+ * @param path the file
+ * @param offset offset of the chunk
+ * @param len chunk size
+ * @param buf location in which save the chunk
+ * @return true if the whole chunk was read
+ */
+bool huff_manifest_read(const char *path, size_t offset, size_t len, unsigned char *buf)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return false;
+    bool ok = fseek(fp, offset, SEEK_SET) == 0 && fread(buf, 1, len, fp) == len;
+    fclose(fp);
+    return ok;
+}
+
+/**
+ * @brief Writes a buffer into a file, replacing it
+ *
+ * @param path the file
+ * @param buf the buffer
+ * @param len buffer size
+ * @return true if the whole buffer was written
+ */
+bool huff_manifest_write(const char *path, const unsigned char *buf, size_t len)
+{
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not write [%s]!\n", path);
+        return false;
+    }
+    bool ok = fwrite(buf, 1, len, fp) == len;
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok)
+        fprintf(stderr, "ERROR: Can not write [%s]!\n", path);
+    return ok;
+}
+
+/**
+ * @brief Path of the output of a chunk of a file, "output.partN"
+ *
+ * @param output output path of the file
+ * @param part index of the chunk
+ * @param path location in which save the path
+ * @param size size of 'path'
+ * @return 'path'
+ */
+char *huff_manifest_part_path(const char *output, int part, char *path, size_t size)
+{
+    snprintf(path, size, "%s.part%d", output, part);
+    return path;
+}
+
+/**
+ * @brief Concatenates the outputs of the chunks of a file into its output and removes them.
+ * Compressed chunks are streams of blocks, so their concatenation is the stream of the file.
+ * On failure the partial output is removed too
+ *
+ * @param output output path of the file
+ * @param nparts number of chunks
+ * @return true if every chunk was copied
+ */
+bool huff_manifest_join(const char *output, int nparts)
+{
+    char path[4096];
+    size_t n;
+    int k;
+    bool ok = true;
+    unsigned char *buf = (unsigned char *)malloc(HUFF_MANIFEST_COPY);
+    FILE *out = fopen(output, "wb");
+    if (buf == NULL || out == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not write [%s]!\n", output);
+        free(buf);
+        if (out != NULL)
+            fclose(out);
+        huff_manifest_remove_parts(output, nparts, true);
+        return false;
+    }
+    for (k = 0; k < nparts && ok; k++)
+    {
+        FILE *in = fopen(huff_manifest_part_path(output, k, path, sizeof(path)), "rb");
+        if (in == NULL)
+        {
+            ok = false;
+            break;
+        }
+        while ((n = fread(buf, 1, HUFF_MANIFEST_COPY, in)) > 0 && ok)
+            ok = fwrite(buf, 1, n, out) == n;
+        fclose(in);
+    }
+    ok = (fclose(out) == 0) && ok;
+    free(buf);
+    /* Parts are removed in any case, the output only if it is incomplete */
+    huff_manifest_remove_parts(output, nparts, !ok);
+    if (!ok)
+        fprintf(stderr, "ERROR: Can not join the chunks of [%s]!\n", output);
+    return ok;
+}
+
+/**
+ * @brief Removes the outputs of the chunks of a file, e.g after a chunk failed
+ *
+ * @param output output path of the file
+ * @param nparts number of chunks
+ * @param also_output true to remove the output of the file too
+ */
+void huff_manifest_remove_parts(const char *output, int nparts, bool also_output)
+{
+    char path[4096];
+    int k;
+    for (k = 0; k < nparts; k++)
+        remove(huff_manifest_part_path(output, k, path, sizeof(path)));
+    if (also_output)
+        remove(output);
+}
+
+/**
+ * @brief Adds the histogram of the head of a file
+ *
+ * @param path the file
+ * @param max bytes counted at most e.g HUFF_MANIFEST_SAMPLE
+ * @param freq the 256 frequencies, incremented
+ * @return counted bytes
+ */
+size_t huff_manifest_sample(const char *path, size_t max, unsigned int *freq)
+{
+    unsigned char buf[4096];
+    size_t total = 0, n, i;
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return 0;
+    while (total < max && (n = fread(buf, 1, (max - total < sizeof(buf)) ? max - total : sizeof(buf), fp)) > 0)
+    {
+        for (i = 0; i < n; i++)
+            freq[buf[i]]++;
+        total += n;
+    }
+    fclose(fp);
+    return total;
+}
+
+/**
+ * @brief Saves the code lengths of a shared table, one byte per symbol
+ *
+ * @param path the file
+ * @param t the table
+ * @return true if written
+ */
+bool huff_manifest_save_table(const char *path, const struct huff_table *t)
+{
+    return huff_manifest_write(path, t->lengths, t->nsymbols);
+}
+
+/**
+ * @brief Loads a table saved with huff_manifest_save_table()
+ *
+ * @param path the file
+ * @param t table initialized with huff_table_init()
+ * @return true if the file exists and its lengths describe a valid code
+ */
+bool huff_manifest_load_table(const char *path, struct huff_table *t)
+{
+    unsigned char lengths[HUFF_BYTE_SYMBOLS];
+    if (t->nsymbols != HUFF_BYTE_SYMBOLS || !huff_manifest_read(path, 0, HUFF_BYTE_SYMBOLS, lengths))
+        return false;
+    if (!huff_table_from_lengths(t, lengths))
+    {
+        fprintf(stderr, "ERROR: Invalid table [%s]!\n", path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file manifest_utils.h
+ * @brief Manifest of the batch mode: pairs of input and output paths, split into tasks
+ *        (whole small files, chunks of large ones) that processes and threads take,
+ *        and the file helpers of the tasks
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include "codec_utils.h"
+
+#ifndef MANIFEST_H
+# define MANIFEST_H
+
+/* Files larger than this are split into chunks that processes take independently */
+#define HUFF_MANIFEST_CHUNK (16 * 1024 * 1024)
+
+/* Tasks up to this size are grouped and spread over the threads, one file per thread */
+#define HUFF_MANIFEST_SMALL (1024 * 1024)
+
+/* Head of every file counted for the shared table */
+#define HUFF_MANIFEST_SAMPLE (64 * 1024)
+
+/* A task: one chunk of one file, a whole file when it has one part */
+struct huff_manifest_task
+{
+    int file;      /* index into the manifest */
+    int part;      /* index of the chunk into the file */
+    size_t offset; /* offset of the chunk into the file */
+    size_t len;    /* chunk size */
+};
+
+/* Files of a manifest and their tasks, largest first */
+struct huff_manifest
+{
+    char *text;                 /* manifest text, paths point into it */
+    char **inputs;              /* input path of every file */
+    char **outputs;             /* output path of every file */
+    unsigned long long *sizes;  /* input sizes, (unsigned long long)-1 if unreadable */
+    int *nparts;                /* number of chunks of every file */
+    int count;                  /* number of files */
+    struct huff_manifest_task *tasks;
+    int ntasks;
+};
+
+/**
+ * @brief Reads a whole text file
+ *
+ * @param filename the file
+ * @param len location in which save the size
+ * @return the text, NUL terminated, NULL on failure
+ */
+char *huff_manifest_load(const char *filename, size_t *len);
+
+/**
+ * @brief Splits a manifest into files: one "input output" pair per line, separated by
+ * spaces or tabs. Empty lines and lines starting with '#' are skipped
+ *
+ * @param m manifest to initialize
+ * @param text manifest text, owned by the manifest afterwards
+ * @return true if every line is a pair
+ */
+bool huff_manifest_parse(struct huff_manifest *m, char *text);
+
+/**
+ * @brief Sizes of the input files
+ *
+ * @param m the manifest
+ * @return number of unreadable files
+ */
+int huff_manifest_stat(struct huff_manifest *m);
+
+/**
+ * @brief Splits the files into tasks of at most 'chunk' bytes, largest first so that small
+ * tasks balance the end of the run. Unreadable files get no task
+ *
+ * @param m the manifest, with its sizes
+ * @param chunk max size of a task e.g HUFF_MANIFEST_CHUNK
+ * @return true if allocation did not fail
+ */
+bool huff_manifest_plan(struct huff_manifest *m, size_t chunk);
+
+/**
+ * @brief Releases the manifest
+ *
+ * @param m the manifest
+ */
+void huff_manifest_free(struct huff_manifest *m);
+
+/**
+ * @brief Reads a chunk of a file
+ *
+ * @param path the file
+ * @param offset offset of the chunk
+ * @param len chunk size
+ * @param buf location in which save the chunk
+ * @return true if the whole chunk was read
+ */
+bool huff_manifest_read(const char *path, size_t offset, size_t len, unsigned char *buf);
+
+/**
+ * @brief Writes a buffer into a file, replacing it
+ *
+ * @param path the file
+ * @param buf the buffer
+ * @param len buffer size
+ * @return true if the whole buffer was written
+ */
+bool huff_manifest_write(const char *path, const unsigned char *buf, size_t len);
+
+/**
+ * @brief Path of the output of a chunk of a file, "output.partN"
+ *
+ * @param output output path of the file
+ * @param part index of the chunk
+ * @param path location in which save the path
+ * @param size size of 'path'
+ * @return 'path'
+ */
+char *huff_manifest_part_path(const char *output, int part, char *path, size_t size);
+
+/**
+ * @brief Concatenates the outputs of the chunks of a file into its output and removes them.
+ * Compressed chunks are streams of blocks, so their concatenation is the stream of the file.
+ * On failure the partial output is removed too
+ *
+ * @param output output path of the file
+ * @param nparts number of chunks
+ * @return true if every chunk was copied
+ */
+bool huff_manifest_join(const char *output, int nparts);
+
+/**
+ * @brief Removes the outputs of the chunks of a file, e.g after a chunk failed
+ *
+ * @param output output path of the file
+ * @param nparts number of chunks
+ * @param also_output true to remove the output of the file too
+ */
+void huff_manifest_remove_parts(const char *output, int nparts, bool also_output);
+
+/**
+ * @brief Adds the histogram of the head of a file
+ *
+ * @param path the file
+ * @param max bytes counted at most e.g HUFF_MANIFEST_SAMPLE
+ * @param freq the 256 frequencies, incremented
+ * @return counted bytes
+ */
+size_t huff_manifest_sample(const char *path, size_t max, unsigned int *freq);
+
+/**
+ * @brief Saves the code lengths of a shared table, one byte per symbol
+ *
+ * @param path the file
+ * @param t the table
+ * @return true if written
+ */
+bool huff_manifest_save_table(const char *path, const struct huff_table *t);
+
+/**
+ * @brief Loads a table saved with huff_manifest_save_table()
+ *
+ * @param path the file
+ * @param t table initialized with huff_table_init()
+ * @return true if the file exists and its lengths describe a valid code
+ */
+bool huff_manifest_load_table(const char *path, struct huff_table *t);
+
+#endif
@@ -0,0 +1,493 @@
+/**
+ * Microbenchmark of the single kernels on an in-memory buffer, without MPI:
+ * histogram, tree build, code-word table, encoding and decoding of the original
+ * string pipeline next to their table-driven (codec_utils.h) and tANS (ans_utils.h)
+ * counterparts. The serial pipeline is run once as reference and its round trip
+ * is verified; every kernel is then timed alone and its last output checked
+ * against the reference.
+ * @file microbench.c
+ * @brief Usage: ./microbench [file] [--iters N] [--warmup N] [--size N[K|M]] [--cpu N] [--kernels a,b] [--json]
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#ifdef __linux__
+# define _GNU_SOURCE
+# include <sched.h>
+#endif
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "tree_utils.h"
+#include "codeword_utils.h"
+#include "frequencies_utils.h"
+#include "codec_utils.h"
+#include "ans_utils.h"
+#include "corpus_utils.h"
+
+/* Default input size: the INPUT_SIZE read by main.c. String kernels are quadratic in it */
+#define MB_DEFAULT_SIZE 200000
+
+/* Options of a run */
+struct mb_options
+{
+    char *filename;
+    size_t size;    /* bytes of the file to use */
+    int iters;      /* timed iterations */
+    int warmup;     /* untimed iterations before */
+    int cpu;        /* cpu to pin to, -1 to not pin */
+    char *kernels;  /* comma separated list of kernels, NULL for all */
+    bool json;
+};
+
+/* Reference data of the serial pipeline and outputs of the kernels */
+struct mb_state
+{
+    char *input;                                /* input string */
+    size_t len;                                 /* input length */
+
+    /* Original string pipeline */
+    int freq[sizeof(DEFAULT_ALPHABET)];         /* frequency of each alphabet char */
+    char *used_chars;                           /* chars with a frequency */
+    int *used_freq;                             /* their frequency */
+    int count;                                  /* number of used chars */
+    struct MinHeapNode *root;                   /* Huffman tree */
+    struct nlist codes[HASHSIZE];               /* code-word table */
+    char *bits;                                 /* encoded string of '0' and '1' */
+
+    /* Table-driven and tANS codecs */
+    unsigned int bfreq[HUFF_BYTE_SYMBOLS];      /* frequency of each byte */
+    struct huff_table table;
+    unsigned char *packed;                      /* Huffman encoded bytes */
+    size_t packed_len;
+    struct ans_table ans;
+    unsigned char *ans_out;                     /* tANS encoded bytes */
+    size_t ans_len;
+
+    /* Outputs of the last run of a kernel */
+    int out_freq[sizeof(DEFAULT_ALPHABET)];
+    unsigned int out_bfreq[HUFF_BYTE_SYMBOLS];
+    struct MinHeapNode *out_root;
+    struct huff_table out_table;
+    char *out_bits;
+    struct decoded_node *out_nodes;
+    unsigned char *out_buf;                     /* encoded or decoded bytes */
+    size_t out_len;
+};
+
+/* A kernel: 'run' is timed, 'check' validates the output of the last run */
+struct mb_kernel
+{
+    const char *name;
+    bool per_byte;   /* throughput is reported per input byte */
+    void (*run)(struct mb_state *s);
+    bool (*check)(struct mb_state *s);
+};
+
+/* Frees the outputs of the string kernels between iterations */
+static void release_outputs(struct mb_state *s)
+{
+    if (s->out_root != NULL)
+        freeTree(s->out_root);
+    s->out_root = NULL;
+    free(s->out_bits);
+    s->out_bits = NULL;
+    if (s->out_nodes != NULL)
+        free(s->out_nodes[0].string);
+    free(s->out_nodes);
+    s->out_nodes = NULL;
+}
+
+static void run_histogram(struct mb_state *s)
+{
+    memset(s->out_freq, 0, sizeof(s->out_freq));
+    calculate_frequencies(alphabeth, s->input, s->out_freq);
+}
+
+static bool check_histogram(struct mb_state *s)
+{
+    return memcmp(s->out_freq, s->freq, sizeof(s->freq)) == 0;
+}
+
+static void run_histogram_table(struct mb_state *s)
+{
+    memset(s->out_bfreq, 0, sizeof(s->out_bfreq));
+    huff_histogram((unsigned char *)s->input, s->len, s->out_bfreq);
+}
+
+static bool check_histogram_table(struct mb_state *s)
+{
+    int i;
+    for (i = 0; alphabeth[i] != '\0'; i++)
+    {
+        if (s->out_bfreq[(unsigned char)alphabeth[i]] != (unsigned int)s->freq[i])
+            return false;
+    }
+    return true;
+}
+
+static void run_tree(struct mb_state *s)
+{
+    s->out_root = HuffmanCodes(s->used_chars, s->used_freq, s->count);
+}
+
+static bool check_tree(struct mb_state *s)
+{
+    return s->out_root != NULL && s->out_root->freq == (unsigned)s->len;
+}
+
+static void run_codes(struct mb_state *s)
+{
+    char arr[MAX_TREE_HT];
+    memset(codes_list, 0, sizeof(codes_list));
+    FillCodesList(s->root, arr, 0);
+}
+
+static bool check_codes(struct mb_state *s)
+{
+    return memcmp(codes_list, s->codes, sizeof(s->codes)) == 0;
+}
+
+static void run_table(struct mb_state *s)
+{
+    huff_table_from_freq(&s->out_table, s->bfreq, HUFF_DEFAULT_MAX_BITS);
+}
+
+static bool check_table(struct mb_state *s)
+{
+    return memcmp(s->out_table.lengths, s->table.lengths, HUFF_BYTE_SYMBOLS) == 0 &&
+           memcmp(s->out_table.codes, s->table.codes, HUFF_BYTE_SYMBOLS * sizeof(unsigned int)) == 0;
+}
+
+static void run_encode(struct mb_state *s)
+{
+    s->out_bits = calculate_huff_code(s->input);
+}
+
+static bool check_encode(struct mb_state *s)
+{
+    return strcmp(s->out_bits, s->bits) == 0;
+}
+
+static void run_encode_table(struct mb_state *s)
+{
+    s->out_len = huff_encode(&s->table, (unsigned char *)s->input, s->len, s->out_buf);
+}
+
+static bool check_encode_table(struct mb_state *s)
+{
+    return s->out_len == s->packed_len && memcmp(s->out_buf, s->packed, s->packed_len) == 0;
+}
+
+static void run_encode_ans(struct mb_state *s)
+{
+    s->out_len = ans_encode(&s->ans, (unsigned char *)s->input, s->len, s->out_buf);
+}
+
+static bool check_encode_ans(struct mb_state *s)
+{
+    return s->out_len == s->ans_len && memcmp(s->out_buf, s->ans_out, s->ans_len) == 0;
+}
+
+static void run_decode_tree(struct mb_state *s)
+{
+    /* One piece starting at bit 0, as thread 0 of main.c does */
+    int nbits = strlen(s->bits);
+    s->out_nodes = decode_string(s->root, s->bits, nbits, 0, 0, 1);
+}
+
+static bool check_decode_tree(struct mb_state *s)
+{
+    return strcmp(s->out_nodes[0].string, s->input) == 0;
+}
+
+static void run_decode_table(struct mb_state *s)
+{
+    s->out_len = huff_decode(&s->table, s->packed, s->packed_len, s->out_buf, s->len) ? s->len : 0;
+}
+
+static void run_decode_ans(struct mb_state *s)
+{
+    s->out_len = ans_decode(&s->ans, s->ans_out, s->ans_len, s->out_buf, s->len) ? s->len : 0;
+}
+
+static bool check_decoded(struct mb_state *s)
+{
+    return s->out_len == s->len && memcmp(s->out_buf, s->input, s->len) == 0;
+}
+
+static const struct mb_kernel kernels[] = {
+    {"histogram", true, run_histogram, check_histogram},
+    {"histogram_table", true, run_histogram_table, check_histogram_table},
+    {"tree", false, run_tree, check_tree},
+    {"codes", false, run_codes, check_codes},
+    {"table", false, run_table, check_table},
+    {"encode", true, run_encode, check_encode},
+    {"encode_table", true, run_encode_table, check_encode_table},
+    {"encode_ans", true, run_encode_ans, check_encode_ans},
+    {"decode_tree", true, run_decode_tree, check_decode_tree},
+    {"decode_table", true, run_decode_table, check_decoded},
+    {"decode_ans", true, run_decode_ans, check_decoded}};
+
+#define KERNELS (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+/**
+ * @brief Runs the serial pipeline once to build the reference data and verifies
+ * the round trip of every codec
+ *
+ * @param s state with the input set
+ * @return true if every round trip succeeded
+ */
+static bool build_reference(struct mb_state *s)
+{
+    int i;
+    char arr[MAX_TREE_HT];
+
+    memset(s->freq, 0, sizeof(s->freq));
+    calculate_frequencies(alphabeth, s->input, s->freq);
+    s->used_chars = (char *)malloc(sizeof(DEFAULT_ALPHABET));
+    s->used_freq = (int *)malloc(sizeof(DEFAULT_ALPHABET) * sizeof(int));
+    s->count = 0;
+    for (i = 0; alphabeth[i] != '\0'; i++)
+    {
+        if (s->freq[i] != 0)
+        {
+            s->used_chars[s->count] = alphabeth[i];
+            s->used_freq[s->count] = s->freq[i];
+            s->count++;
+        }
+    }
+    if (s->count < 2)
+    {
+        fprintf(stderr, "ERROR: Input needs at least two different chars!\n");
+        return false;
+    }
+    s->root = HuffmanCodes(s->used_chars, s->used_freq, s->count);
+    memset(codes_list, 0, sizeof(codes_list));
+    FillCodesList(s->root, arr, 0);
+    memcpy(s->codes, codes_list, sizeof(codes_list));
+    s->bits = calculate_huff_code(s->input);
+
+    memset(s->bfreq, 0, sizeof(s->bfreq));
+    huff_histogram((unsigned char *)s->input, s->len, s->bfreq);
+    unsigned short norm[ANS_SYMBOLS];
+    if (!huff_table_init(&s->table, HUFF_BYTE_SYMBOLS) || !huff_table_init(&s->out_table, HUFF_BYTE_SYMBOLS) ||
+        !huff_table_from_freq(&s->table, s->bfreq, HUFF_DEFAULT_MAX_BITS) ||
+        !ans_normalize(s->bfreq, norm) || !ans_table_build(&s->ans, norm))
+    {
+        fprintf(stderr, "ERROR: Can not build the code tables!\n");
+        return false;
+    }
+    size_t bound = huff_encoded_bits(&s->table, (unsigned char *)s->input, s->len) / 8 + 8;
+    if (ans_bound(s->len) > bound)
+        bound = ans_bound(s->len);
+    s->packed = (unsigned char *)malloc(bound);
+    s->ans_out = (unsigned char *)malloc(bound);
+    s->out_buf = (unsigned char *)malloc(bound > s->len ? bound : s->len);
+    s->packed_len = huff_encode(&s->table, (unsigned char *)s->input, s->len, s->packed);
+    s->ans_len = ans_encode(&s->ans, (unsigned char *)s->input, s->len, s->ans_out);
+
+    /* Round trips */
+    bool ok = true;
+    s->out_root = NULL;
+    s->out_bits = NULL;
+    s->out_nodes = NULL;
+    run_decode_tree(s);
+    ok = ok && check_decode_tree(s);
+    run_decode_table(s);
+    ok = ok && check_decoded(s);
+    run_decode_ans(s);
+    ok = ok && check_decoded(s);
+    release_outputs(s);
+    if (!ok)
+        fprintf(stderr, "ERROR: Reference round trip failed!\n");
+    return ok;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Times a kernel and prints its statistics
+ *
+ * @param o the options
+ * @param s the state
+ * @param k the kernel
+ * @return true if the output of the kernel is valid
+ */
+static bool bench_kernel(const struct mb_options *o, struct mb_state *s, const struct mb_kernel *k)
+{
+    double *times = (double *)malloc(o->iters * sizeof(double));
+    double sum = 0, sq = 0;
+    int i;
+    for (i = 0; i < o->warmup + o->iters; i++)
+    {
+        double t0 = omp_get_wtime();
+        k->run(s);
+        double t1 = omp_get_wtime();
+        if (i >= o->warmup)
+            times[i - o->warmup] = t1 - t0;
+        if (i < o->warmup + o->iters - 1)
+            release_outputs(s);
+    }
+    bool ok = k->check(s);
+    release_outputs(s);
+
+    for (i = 0; i < o->iters; i++)
+    {
+        sum += times[i];
+        sq += times[i] * times[i];
+    }
+    double mean = sum / o->iters;
+    double stddev = sqrt(fmax(sq / o->iters - mean * mean, 0));
+    qsort(times, o->iters, sizeof(double), compare_double);
+    double median = (o->iters % 2) ? times[o->iters / 2] : (times[o->iters / 2 - 1] + times[o->iters / 2]) / 2;
+    double mbps = (k->per_byte && median > 0) ? s->len / 1e6 / median : 0;
+
+    if (o->json)
+        printf("{\"kernel\": \"%s\", \"bytes\": %zu, \"iters\": %d, \"min\": %e, \"median\": %e, \"mean\": %e, "
+               "\"stddev\": %e, \"mbps\": %.1f, \"ok\": %s}\n",
+               k->name, s->len, o->iters, times[0], median, mean, stddev, mbps, ok ? "true" : "false");
+    else if (k->per_byte)
+        printf("%-16s %6d %e %e %e %e %10.1f %3s\n", k->name, o->iters, times[0], median, mean, stddev, mbps,
+               ok ? "ok" : "BAD");
+    else
+        printf("%-16s %6d %e %e %e %e %10s %3s\n", k->name, o->iters, times[0], median, mean, stddev, "-",
+               ok ? "ok" : "BAD");
+    fflush(stdout);
+    free(times);
+    return ok;
+}
+
+/* Pins the process to a cpu so that timings do not move between cores */
+static void pin_cpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        fprintf(stderr, "WARNING: Can not pin to cpu %d, running unpinned\n", cpu);
+#else
+    fprintf(stderr, "WARNING: Cpu pinning needs Linux, running unpinned\n");
+#endif
+}
+
+/* Reads the options, returns false on usage error */
+static bool parse_options(int argc, char **argv, struct mb_options *o)
+{
+    int arg;
+    o->filename = "input.txt";
+    o->size = MB_DEFAULT_SIZE;
+    o->iters = 5;
+    o->warmup = 1;
+    o->cpu = 0;
+    o->kernels = NULL;
+    o->json = false;
+    for (arg = 1; arg < argc; arg++)
+    {
+        bool has_value = arg + 1 < argc;
+        if (strcmp(argv[arg], "--json") == 0)
+            o->json = true;
+        else if (strcmp(argv[arg], "--iters") == 0 && has_value)
+            o->iters = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "--warmup") == 0 && has_value)
+            o->warmup = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "--cpu") == 0 && has_value)
+            o->cpu = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "--kernels") == 0 && has_value)
+            o->kernels = argv[++arg];
+        else if (strcmp(argv[arg], "--size") == 0 && has_value)
+        {
+            if ((o->size = corpus_parse_size(argv[++arg])) == 0)
+                return false;
+        }
+        else if (argv[arg][0] != '-')
+            o->filename = argv[arg];
+        else
+            return false;
+    }
+    return o->iters > 0 && o->warmup >= 0;
+}
+
+/* True if 'name' is in the comma separated 'list' */
+static bool in_list(const char *list, const char *name)
+{
+    size_t n = strlen(name);
+    const char *p = list;
+    while ((p = strstr(p, name)) != NULL)
+    {
+        if ((p == list || p[-1] == ',') && (p[n] == ',' || p[n] == '\0'))
+            return true;
+        p += n;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    struct mb_options o;
+    struct mb_state s;
+    int i, failed = 0;
+
+    if (!parse_options(argc, argv, &o))
+    {
+        fprintf(stderr, "Usage: %s [file] [--iters N] [--warmup N] [--size N[K|M]] [--cpu N|-1] [--json]\n"
+                        "       [--kernels histogram,histogram_table,tree,codes,table,encode,encode_table,\n"
+                        "                  encode_ans,decode_tree,decode_table,decode_ans]\n", argv[0]);
+        return 1;
+    }
+
+    /* Reading the input as main.c does: newlines become spaces */
+    FILE *fp = fopen(o.filename, "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not read [%s]!\n", o.filename);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fclose(fp);
+    size_t maxlen = (o.size < (size_t)file_size) ? o.size : (size_t)file_size;
+    memset(&s, 0, sizeof(s));
+    s.input = (char *)calloc(maxlen + 1, sizeof(char));
+    if (!read_input_string(s.input, maxlen, o.filename))
+        return 1;
+    s.len = strlen(s.input);
+    if (strspn(s.input, alphabeth) != s.len)
+    {
+        fprintf(stderr, "ERROR: Input has chars out of the alphabet!\n");
+        return 1;
+    }
+
+    if (o.cpu >= 0)
+        pin_cpu(o.cpu);
+    if (!build_reference(&s))
+        return 1;
+
+    if (!o.json)
+        printf("%-16s %6s %12s %12s %12s %12s %10s %3s\n", "kernel", "iters", "min", "median", "mean", "stddev",
+               "MB/s", "ok");
+    for (i = 0; i < KERNELS; i++)
+    {
+        if (o.kernels == NULL || in_list(o.kernels, kernels[i].name))
+            failed += !bench_kernel(&o, &s, &kernels[i]);
+    }
+
+    freeTree(s.root);
+    huff_table_free(&s.table);
+    huff_table_free(&s.out_table);
+    free(s.used_chars);
+    free(s.used_freq);
+    free(s.bits);
+    free(s.packed);
+    free(s.ans_out);
+    free(s.out_buf);
+    free(s.input);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,312 @@
+/**
+ * @file numa_utils.c
+ * @brief Implementation of the NUMA placement and thread pinning
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#ifdef __linux__
+# define _GNU_SOURCE
+# include <sched.h>
+# include <dirent.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+#include "numa_utils.h"
+#include <omp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Memory policy of mbind(), see set_mempolicy(2) */
+#define HUFF_MPOL_INTERLEAVE 3
+
+static enum huff_numa_policy numa_policy = HUFF_NUMA_DEFAULT;
+
+/* Reads a list like "0,2,4-7" into 'out', returns the number of entries */
+static int parse_list(const char *list, int *out, int max)
+{
+    int count = 0, first, last, n;
+    while (sscanf(list, "%d%n", &first, &n) == 1)
+    {
+        list += n;
+        last = first;
+        if (*list == '-' && sscanf(list + 1, "%d%n", &last, &n) == 1)
+            list += 1 + n;
+        for (; first <= last && count < max; first++)
+            out[count++] = first;
+        if (*list != ',')
+            break;
+        list++;
+    }
+    return count;
+}
+
+/* Page size, 4K if unknown */
+static size_t page_size(void)
+{
+#ifdef __linux__
+    long size = sysconf(_SC_PAGESIZE);
+    if (size > 0)
+        return size;
+#endif
+    return 4096;
+}
+
+/**
+ * @brief Sets the placement of the next huff_numa_calloc() buffers
+ *
+ * @param policy the placement
+ */
+void huff_numa_set_policy(enum huff_numa_policy policy)
+{
+    numa_policy = policy;
+}
+
+/**
+ * @return the placement of the huff_numa_calloc() buffers
+ */
+enum huff_numa_policy huff_numa_get_policy(void)
+{
+    return numa_policy;
+}
+
+/**
+ * @return number of NUMA nodes, 1 without NUMA support
+ */
+int huff_numa_nodes(void)
+{
+    char line[256];
+    int nodes[HUFF_NUMA_MAX_CPUS], count = 0;
+    FILE *fp = fopen("/sys/devices/system/node/online", "r");
+    if (fp == NULL)
+        return 1;
+    if (fgets(line, sizeof(line), fp) != NULL)
+        count = parse_list(line, nodes, HUFF_NUMA_MAX_CPUS);
+    fclose(fp);
+    return (count > 0) ? nodes[count - 1] + 1 : 1;
+}
+
+/**
+ * @brief NUMA node of a cpu
+ *
+ * @param cpu the cpu
+ * @return the node, 0 if unknown
+ */
+int huff_numa_node_of_cpu(int cpu)
+{
+    int node = 0;
+#ifdef __linux__
+    char path[64];
+    struct dirent *entry;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return 0;
+    /* The directory of a cpu links its node as 'nodeN' */
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && sscanf(entry->d_name + 4, "%d", &node) == 1)
+            break;
+    }
+    closedir(dir);
+#endif
+    return node;
+}
+
+/* Spreads the pages of a buffer over every node, returns false if the kernel refuses */
+static bool interleave(void *addr, size_t size)
+{
+#ifdef __linux__
+    unsigned long mask[HUFF_NUMA_MAX_CPUS / (8 * sizeof(unsigned long))] = {0};
+    int nodes = huff_numa_nodes(), i;
+    for (i = 0; i < nodes && i < HUFF_NUMA_MAX_CPUS; i++)
+        mask[i / (8 * sizeof(unsigned long))] |= 1UL << (i % (8 * sizeof(unsigned long)));
+    return syscall(SYS_mbind, addr, size, HUFF_MPOL_INTERLEAVE, mask, HUFF_NUMA_MAX_CPUS, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Zeroed buffer placed with the current policy. With first touch the buffer is split
+ * into as many equal slices as OpenMP threads, like the initial ranges of the scheduler
+ * (sched_utils.h). Not to be called within a parallel region. Released with free()
+ *
+ * @param count number of elements
+ * @param size size of an element
+ * @return the buffer, NULL on failure
+ */
+void *huff_numa_calloc(size_t count, size_t size)
+{
+    size_t page = page_size(), bytes = count * size;
+    if (numa_policy == HUFF_NUMA_DEFAULT)
+        return calloc(count, size);
+
+    /* Whole pages, so that the first byte written decides the node of a page */
+    size_t rounded = (bytes + page - 1) / page * page;
+    char *buf = (char *)aligned_alloc(page, (rounded > 0) ? rounded : page);
+    if (buf == NULL)
+        return NULL;
+    if (numa_policy == HUFF_NUMA_INTERLEAVE)
+    {
+        if (interleave(buf, rounded))
+        {
+            memset(buf, 0, rounded);
+            return buf;
+        }
+        fprintf(stderr, "ERROR: mbind failed, buffer placed by first touch!\n");
+    }
+
+    #pragma omp parallel
+    {
+        size_t t = omp_get_thread_num(), nthreads = omp_get_num_threads();
+        size_t first = rounded / page * t / nthreads * page, last = rounded / page * (t + 1) / nthreads * page;
+        memset(buf + first, 0, last - first);
+    }
+    return buf;
+}
+
+/**
+ * @brief Pins every OpenMP thread to one cpu, chosen among the cpus the process may run on.
+ * Later parallel regions with the same number of threads reuse the pinned threads
+ *
+ * @param layout "compact" (consecutive cpus), "spread" (round-robin over the nodes)
+ *        or a list of cpus e.g "0,2,4-7"
+ * @return true if every thread was pinned
+ */
+bool huff_bind_threads(const char *layout)
+{
+#ifdef __linux__
+    static int cpus[HUFF_NUMA_MAX_CPUS];
+    int allowed[HUFF_NUMA_MAX_CPUS], ncpus = 0, nallowed = 0, failed = 0, cpu, node, i;
+    cpu_set_t set;
+
+    /* Cpus given to the process, e.g by the binding of mpirun */
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return false;
+    for (cpu = 0; cpu < CPU_SETSIZE && cpu < HUFF_NUMA_MAX_CPUS; cpu++)
+    {
+        if (CPU_ISSET(cpu, &set))
+            allowed[nallowed++] = cpu;
+    }
+
+    if (strcmp(layout, "compact") == 0)
+    {
+        memcpy(cpus, allowed, nallowed * sizeof(int));
+        ncpus = nallowed;
+    }
+    else if (strcmp(layout, "spread") == 0)
+    {
+        /* The i-th cpu of every node, then the (i+1)-th */
+        int nodes = huff_numa_nodes(), taken[HUFF_NUMA_MAX_CPUS] = {0};
+        int before = -1;
+        while (ncpus < nallowed && ncpus != before)
+        {
+            before = ncpus;
+            for (node = 0; node < nodes; node++)
+            {
+                for (i = 0; i < nallowed; i++)
+                {
+                    if (!taken[i] && huff_numa_node_of_cpu(allowed[i]) == node)
+                    {
+                        taken[i] = 1;
+                        cpus[ncpus++] = allowed[i];
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    else
+        ncpus = parse_list(layout, cpus, HUFF_NUMA_MAX_CPUS);
+    if (ncpus == 0)
+    {
+        fprintf(stderr, "ERROR: Invalid thread layout [%s]!\n", layout);
+        return false;
+    }
+
+    #pragma omp parallel reduction(+ : failed)
+    {
+        cpu_set_t mine;
+        int c = cpus[omp_get_thread_num() % ncpus];
+        CPU_ZERO(&mine);
+        CPU_SET(c, &mine);
+        if (sched_setaffinity(0, sizeof(mine), &mine) != 0)
+        {
+            fprintf(stderr, "ERROR: Can not pin thread %d to cpu %d!\n", omp_get_thread_num(), c);
+            failed++;
+        }
+    }
+    return failed == 0;
+#else
+    fprintf(stderr, "ERROR: Thread pinning needs Linux!\n");
+    return false;
+#endif
+}
+
+/**
+ * @brief Prints the cpu and node every OpenMP thread runs on
+ */
+void huff_numa_report_threads(void)
+{
+#ifdef __linux__
+    int cpus[HUFF_NUMA_MAX_CPUS], nthreads = 1, t;
+    #pragma omp parallel
+    {
+        #pragma omp single
+        nthreads = omp_get_num_threads();
+        if (omp_get_thread_num() < HUFF_NUMA_MAX_CPUS)
+            cpus[omp_get_thread_num()] = sched_getcpu();
+    }
+    for (t = 0; t < nthreads && t < HUFF_NUMA_MAX_CPUS; t++)
+        printf("Numa: thread %d on cpu %d, node %d\n", t, cpus[t], huff_numa_node_of_cpu(cpus[t]));
+#endif
+}
+
+/**
+ * @brief Prints the share of the pages of a buffer on every node, sampling up to
+ * HUFF_NUMA_REPORT_PAGES pages
+ *
+ * @param name name of the buffer
+ * @param addr the buffer
+ * @param size size of the buffer
+ */
+void huff_numa_report(const char *name, const void *addr, size_t size)
+{
+#ifdef __linux__
+    size_t page = page_size();
+    uintptr_t first = (uintptr_t)addr / page * page;
+    size_t npages = ((uintptr_t)addr + size - first + page - 1) / page;
+    int nsample = (npages < HUFF_NUMA_REPORT_PAGES) ? npages : HUFF_NUMA_REPORT_PAGES;
+    int nodes = huff_numa_nodes(), i, missing = 0;
+    void *pages[HUFF_NUMA_REPORT_PAGES];
+    int status[HUFF_NUMA_REPORT_PAGES], per_node[nodes];
+
+    if (addr == NULL || nsample == 0)
+        return;
+    for (i = 0; i < nsample; i++)
+        pages[i] = (void *)(first + (npages * i / nsample) * page);
+    /* Without target nodes move_pages() only tells where each page is */
+    if (syscall(SYS_move_pages, 0, nsample, pages, NULL, status, 0) != 0)
+    {
+        printf("Numa: %s placement unavailable\n", name);
+        return;
+    }
+    memset(per_node, 0, sizeof(per_node));
+    for (i = 0; i < nsample; i++)
+    {
+        if (status[i] >= 0 && status[i] < nodes)
+            per_node[status[i]]++;
+        else
+            missing++;
+    }
+    printf("Numa: %s, %zu pages:", name, npages);
+    for (i = 0; i < nodes; i++)
+        printf(" node %d %.0f%%", i, 100.0 * per_node[i] / nsample);
+    if (missing > 0)
+        printf(", not touched %.0f%%", 100.0 * missing / nsample);
+    printf("\n");
+#endif
+}
@@ -0,0 +1,91 @@
+/**
+ * @file numa_utils.h
+ * @brief NUMA placement of the large buffers of process 0 (first touch by the threads that
+ *        will process each slice, or interleaving), pinning of OpenMP threads and a
+ *        report of where threads run and pages live. Linux system calls, no libnuma
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef NUMA_H
+# define NUMA_H
+
+/* Max number of cpus handled by pinning and reports */
+#define HUFF_NUMA_MAX_CPUS 1024
+
+/* Pages sampled by huff_numa_report() */
+#define HUFF_NUMA_REPORT_PAGES 256
+
+/* Placement of the buffers allocated with huff_numa_calloc() */
+enum huff_numa_policy
+{
+    HUFF_NUMA_DEFAULT,     /* plain calloc(): pages land where the allocating thread runs */
+    HUFF_NUMA_FIRST_TOUCH, /* thread t zeroes slice t, the slice it will process first */
+    HUFF_NUMA_INTERLEAVE   /* pages spread round-robin over the nodes (mbind) */
+};
+
+/**
+ * @brief Sets the placement of the next huff_numa_calloc() buffers
+ *
+ * @param policy the placement
+ */
+void huff_numa_set_policy(enum huff_numa_policy policy);
+
+/**
+ * @return the placement of the huff_numa_calloc() buffers
+ */
+enum huff_numa_policy huff_numa_get_policy(void);
+
+/**
+ * @return number of NUMA nodes, 1 without NUMA support
+ */
+int huff_numa_nodes(void);
+
+/**
+ * @brief NUMA node of a cpu
+ *
+ * @param cpu the cpu
+ * @return the node, 0 if unknown
+ */
+int huff_numa_node_of_cpu(int cpu);
+
+/**
+ * @brief Zeroed buffer placed with the current policy. With first touch the buffer is split
+ * into as many equal slices as OpenMP threads, like the initial ranges of the scheduler
+ * (sched_utils.h). Not to be called within a parallel region. Released with free()
+ *
+ * @param count number of elements
+ * @param size size of an element
+ * @return the buffer, NULL on failure
+ */
+void *huff_numa_calloc(size_t count, size_t size);
+
+/**
+ * @brief Pins every OpenMP thread to one cpu, chosen among the cpus the process may run on.
+ * Later parallel regions with the same number of threads reuse the pinned threads
+ *
+ * @param layout "compact" (consecutive cpus), "spread" (round-robin over the nodes)
+ *        or a list of cpus e.g "0,2,4-7"
+ * @return true if every thread was pinned
+ */
+bool huff_bind_threads(const char *layout);
+
+/**
+ * @brief Prints the cpu and node every OpenMP thread runs on
+ */
+void huff_numa_report_threads(void);
+
+/**
+ * @brief Prints the share of the pages of a buffer on every node, sampling up to
+ * HUFF_NUMA_REPORT_PAGES pages
+ *
+ * @param name name of the buffer
+ * @param addr the buffer
+ * @param size size of the buffer
+ */
+void huff_numa_report(const char *name, const void *addr, size_t size);
+
+#endif
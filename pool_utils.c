@@ -0,0 +1,123 @@
+/**
+ * @file pool_utils.c
+ * @brief Implementation of the buffer pool
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "pool_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Bytes of the buffers of a class */
+static size_t class_size(int cls)
+{
+    return (size_t)1 << (HUFF_POOL_MIN_SHIFT + cls);
+}
+
+/* Smallest class holding 'size' bytes, -1 if too large */
+static int class_of(size_t size)
+{
+    int cls = 0;
+    while (cls < HUFF_POOL_CLASSES && class_size(cls) < size)
+        cls++;
+    return (cls < HUFF_POOL_CLASSES) ? cls : -1;
+}
+
+/**
+ * @param pool pool to initialize
+ * @param max_cached bytes kept on the free lists at most, larger releases go to free()
+ */
+void huff_pool_init(struct huff_pool *pool, size_t max_cached)
+{
+    memset(pool->free, 0, sizeof(pool->free));
+    pool->max_cached = max_cached;
+    pool->cached = 0;
+    pool->hits = 0;
+    pool->allocs = 0;
+    omp_init_lock(&pool->lock);
+}
+
+/**
+ * @brief Buffer of at least 'size' bytes, from the free list of its class when not empty
+ *
+ * @param pool the pool
+ * @param size requested size, at most the largest class
+ * @return the buffer, NULL on failure
+ */
+void *huff_pool_get(struct huff_pool *pool, size_t size)
+{
+    int cls = class_of(size);
+    union huff_pool_header *h;
+    if (cls < 0)
+    {
+        fprintf(stderr, "ERROR: Buffer of %zu bytes is larger than the pool classes!\n", size);
+        return NULL;
+    }
+
+    omp_set_lock(&pool->lock);
+    h = pool->free[cls];
+    if (h != NULL)
+    {
+        pool->free[cls] = h->next;
+        pool->cached -= class_size(cls);
+        pool->hits++;
+    }
+    else
+        pool->allocs++;
+    omp_unset_lock(&pool->lock);
+
+    /* Allocation out of the lock, other threads keep taking buffers meanwhile */
+    if (h == NULL && (h = (union huff_pool_header *)malloc(sizeof(union huff_pool_header) + class_size(cls))) == NULL)
+        return NULL;
+    h->cls = cls;
+    return h + 1;
+}
+
+/**
+ * @brief Gives a buffer back to the free list of its class
+ *
+ * @param pool pool the buffer was taken from
+ * @param buf the buffer, NULL is ignored
+ */
+void huff_pool_put(struct huff_pool *pool, void *buf)
+{
+    if (buf == NULL)
+        return;
+    union huff_pool_header *h = (union huff_pool_header *)buf - 1;
+    int cls = h->cls;
+
+    omp_set_lock(&pool->lock);
+    bool keep = pool->cached + class_size(cls) <= pool->max_cached;
+    if (keep)
+    {
+        h->next = pool->free[cls];
+        pool->free[cls] = h;
+        pool->cached += class_size(cls);
+    }
+    omp_unset_lock(&pool->lock);
+    if (!keep)
+        free(h);
+}
+
+/**
+ * @brief Releases the buffers on the free lists. Buffers still in use must be put back before
+ *
+ * @param pool the pool
+ */
+void huff_pool_free(struct huff_pool *pool)
+{
+    int cls;
+    for (cls = 0; cls < HUFF_POOL_CLASSES; cls++)
+    {
+        while (pool->free[cls] != NULL)
+        {
+            union huff_pool_header *h = pool->free[cls];
+            pool->free[cls] = h->next;
+            free(h);
+        }
+    }
+    pool->cached = 0;
+    omp_destroy_lock(&pool->lock);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file pool_utils.h
+ * @brief Size-classed pool of buffers, e.g the outputs of the blocks of a long-running
+ *        service: released buffers are kept on a free list of their class and handed out
+ *        again, so that a warm pool does not allocate
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <omp.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef POOL_H
+# define POOL_H
+
+/* Smallest class, 4K, and number of classes: class c holds buffers of 4K << c bytes, up to 1G */
+#define HUFF_POOL_MIN_SHIFT 12
+#define HUFF_POOL_CLASSES 19
+
+/* Header in front of every buffer: the class while in use, the next free buffer on a list */
+union huff_pool_header
+{
+    int cls;                       /* class of the buffer */
+    union huff_pool_header *next;  /* next buffer of the free list */
+    max_align_t align;             /* buffers keep the alignment of malloc() */
+};
+
+/* Pool shared by the threads of a process */
+struct huff_pool
+{
+    union huff_pool_header *free[HUFF_POOL_CLASSES]; /* free list of every class */
+    size_t max_cached;                                /* bytes kept on the free lists at most */
+    size_t cached;                                    /* bytes on the free lists */
+    unsigned long long hits;                          /* requests served by a free list */
+    unsigned long long allocs;                        /* requests that called malloc() */
+    omp_lock_t lock;
+};
+
+/**
+ * @param pool pool to initialize
+ * @param max_cached bytes kept on the free lists at most, larger releases go to free()
+ */
+void huff_pool_init(struct huff_pool *pool, size_t max_cached);
+
+/**
+ * @brief Buffer of at least 'size' bytes, from the free list of its class when not empty
+ *
+ * @param pool the pool
+ * @param size requested size, at most the largest class
+ * @return the buffer, NULL on failure
+ */
+void *huff_pool_get(struct huff_pool *pool, size_t size);
+
+/**
+ * @brief Gives a buffer back to the free list of its class
+ *
+ * @param pool pool the buffer was taken from
+ * @param buf the buffer, NULL is ignored
+ */
+void huff_pool_put(struct huff_pool *pool, void *buf);
+
+/**
+ * @brief Releases the buffers on the free lists. Buffers still in use must be put back before
+ *
+ * @param pool the pool
+ */
+void huff_pool_free(struct huff_pool *pool);
+
+#endif
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Benchmark sweep: every corpus at every size, serial, multithreaded and hybrid runs.
+# Usage: ./runbench.sh [processes] [threads] [sizes...]   e.g ./runbench.sh 4 8 1K 1M 1G 10G
+# Results go to bench.csv (and bench.json), one row per configuration.
+PROCS=${1:-2}
+THREADS=${2:-4}
+shift $(( $# < 2 ? $# : 2 ))
+SIZES=${@:-1K 1M 64M}
+MPIRUN=${MPIRUN:-mpirun}
+
+# Compiling
+mpicc -O2 -Wall -fopenmp -o ./bench ./bench.c ./corpus_utils.c ./block_utils.c ./sched_utils.c ./codec_utils.c ./ans_utils.c ./tree_utils.c ./pool_utils.c ./crc_utils.c -lm || exit 1
+
+echo "config,corpus,size,ranks,threads,coded,ratio,bits_per_symbol,entropy,enc_mbps,dec_mbps,ok" > bench.csv
+: > bench.json
+for corpus in uniform zipf english binary; do
+    for size in $SIZES; do
+        $MPIRUN -np $PROCS ./bench $corpus $size --threads $THREADS --no-header | tee -a bench.csv
+        $MPIRUN -np $PROCS ./bench $corpus $size --threads $THREADS --json --configs hybrid >> bench.json
+    done
+done
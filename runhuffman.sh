@@ -10,7 +10,7 @@
 #PBS -e ./stderr.txt
 module load mpich-3.2
 # Compiling
-mpicc -g -Wall -fopenmp -o ./huffman-final/main ./huffman-final/frequencies_utils.c ./huffman-final/main.c ./huffman-final/tree_utils.c -lm
+mpicc -g -Wall -fopenmp -o ./huffman-final/main ./huffman-final/frequencies_utils.c ./huffman-final/main.c ./huffman-final/tree_utils.c ./huffman-final/codeword_utils.c ./huffman-final/codec_utils.c ./huffman-final/block_utils.c ./huffman-final/sched_utils.c ./huffman-final/numa_utils.c ./huffman-final/crc_utils.c ./huffman-final/manifest_utils.c ./huffman-final/pool_utils.c ./huffman-final/stream_utils.c ./huffman-final/token_utils.c ./huffman-final/context_utils.c ./huffman-final/ans_utils.c ./huffman-final/adaptive_utils.c ./huffman-final/timer_utils.c ./huffman-final/counter_utils.c ./huffman-final/tune_utils.c -lm
 # Change to the PBS working directory where qsub was started from.
 cd ${PBS_O_WORKDIR}
 
@@ -0,0 +1,64 @@
+#!/bin/bash
+# Local strong and weak scaling sweep with mpirun, no PBS needed.
+# Every processes x threads split (powers of two up to the given maximum) runs the
+# hybrid configuration of bench.c. Strong scaling keeps the size fixed, weak scaling
+# gives 'size' bytes to every worker (processes * threads).
+# Usage: ./runscaling.sh [max processes] [max threads] [corpus] [sizes...]   e.g ./runscaling.sh 4 8 english 64M 256M
+# Results go to scaling.csv: time is compression plus decompression of the slowest process,
+# speedup and efficiency are against the 1x1 run of the same size, Karp-Flatt is the
+# experimentally determined serial fraction.
+MAX_PROCS=${1:-4}
+MAX_THREADS=${2:-4}
+CORPUS=${3:-english}
+shift $(( $# < 3 ? $# : 3 ))
+SIZES=${@:-16M 64M}
+MPIRUN=${MPIRUN:-mpirun}
+MODES=${MODES:-strong weak}
+
+# Compiling
+mpicc -O2 -Wall -fopenmp -o ./bench ./bench.c ./corpus_utils.c ./block_utils.c ./sched_utils.c ./codec_utils.c ./ans_utils.c ./tree_utils.c ./pool_utils.c ./crc_utils.c -lm || exit 1
+
+# Size in bytes of a size with K, M or G suffix
+bytes() {
+    echo $1 | awk '{ n = $0 + 0; u = toupper(substr($0, length($0))); if (u == "K") n *= 1024; else if (u == "M") n *= 1048576; else if (u == "G") n *= 1073741824; printf "%.0f\n", n }'
+}
+
+# Compression plus decompression seconds of one hybrid run
+run_time() {
+    $MPIRUN -np $1 ./bench $CORPUS $3 --threads $2 --json --configs hybrid |
+        awk -v size=$3 '/"config"/ {
+            match($0, /"enc_mbps": [0-9.]+/); enc = substr($0, RSTART + 12, RLENGTH - 12);
+            match($0, /"dec_mbps": [0-9.]+/); dec = substr($0, RSTART + 12, RLENGTH - 12);
+            ok = ($0 ~ /"ok": true/);
+            if (enc > 0 && dec > 0) printf "%.6f %.6f %d\n", size / 1e6 / enc, size / 1e6 / dec, ok; else print "0 0 0" }'
+}
+
+echo "mode,corpus,size,ranks,threads,workers,enc_time,dec_time,time,speedup,efficiency,karp_flatt,ok" > scaling.csv
+for mode in $MODES; do
+    for size in $SIZES; do
+        base=$(bytes $size)
+        t1=""
+        procs=1
+        while [ $procs -le $MAX_PROCS ]; do
+            threads=1
+            while [ $threads -le $MAX_THREADS ]; do
+                workers=$((procs * threads))
+                total=$base
+                [ $mode = weak ] && total=$((base * workers))
+                read enc dec ok <<< "$(run_time $procs $threads $total)"
+                time=$(awk -v e=$enc -v d=$dec 'BEGIN { printf "%.6f", e + d }')
+                [ -z "$t1" ] && t1=$time
+                awk -v mode=$mode -v corpus=$CORPUS -v size=$total -v p=$procs -v t=$threads -v w=$workers \
+                    -v enc=$enc -v dec=$dec -v time=$time -v t1=$t1 -v ok=$ok 'BEGIN {
+                    # Weak scaling: scaled speedup, the 1x1 run did 1/w of the work
+                    s = (time > 0) ? t1 / time : 0;
+                    if (mode == "weak") s *= w;
+                    kf = (w > 1 && s > 0) ? sprintf("%.4f", (1 / s - 1 / w) / (1 - 1 / w)) : "";
+                    printf "%s,%s,%d,%d,%d,%d,%s,%s,%s,%.3f,%.3f,%s,%d\n", mode, corpus, size, p, t, w, enc, dec, time, s, s / w, kf, ok
+                }' | tee -a scaling.csv
+                threads=$((threads * 2))
+            done
+            procs=$((procs * 2))
+        done
+    done
+done
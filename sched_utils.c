@@ -0,0 +1,114 @@
+/**
+ * @file sched_utils.c
+ * @brief Implementation of the work-stealing scheduler
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "sched_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t pack(uint64_t next, uint64_t end)
+{
+    return (end << 32) | next;
+}
+
+/**
+ * @brief Gives every thread a contiguous share of the tasks, so that threads that never
+ * steal process consecutive tasks
+ *
+ * @param s the scheduler
+ * @param ntasks number of tasks, below 2^32
+ * @param nthreads number of threads that will call huff_sched_next()
+ * @return true if allocation did not fail
+ */
+bool huff_sched_init(struct huff_sched *s, size_t ntasks, int nthreads)
+{
+    s->capacity = (nthreads > 0) ? nthreads : 1;
+    s->ranges = (struct huff_sched_range *)aligned_alloc(HUFF_SCHED_LINE,
+                                                         s->capacity * sizeof(struct huff_sched_range));
+    if (s->ranges == NULL || !huff_sched_reset(s, ntasks, s->capacity))
+    {
+        fprintf(stderr, "ERROR: Scheduler initialization failed!\n");
+        free(s->ranges);
+        s->ranges = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Starts a new set of tasks without allocating, e.g for the next buffer
+ *
+ * @param s the scheduler
+ * @param ntasks number of tasks, below 2^32
+ * @param nthreads number of threads, at most the ones given to huff_sched_init()
+ * @return true if the scheduler can hold them
+ */
+bool huff_sched_reset(struct huff_sched *s, size_t ntasks, int nthreads)
+{
+    int i;
+    if (ntasks > UINT32_MAX || nthreads > s->capacity)
+        return false;
+    s->nthreads = (nthreads > 0) ? nthreads : 1;
+    for (i = 0; i < s->nthreads; i++)
+        atomic_init(&s->ranges[i].range, pack(ntasks * i / s->nthreads, ntasks * (i + 1) / s->nthreads));
+    return true;
+}
+
+/**
+ * @brief Next task of a thread: the next one of its range, otherwise the first one
+ * of the upper half stolen from another thread. Lock-free
+ *
+ * @param s the scheduler
+ * @param tid thread number, below 'nthreads'
+ * @param task location in which save the task index
+ * @return false when no task is left
+ */
+bool huff_sched_next(struct huff_sched *s, int tid, size_t *task)
+{
+    _Atomic uint64_t *own = &s->ranges[tid].range;
+    uint64_t r = atomic_load(own);
+    int i;
+
+    /* Own range: thieves may shrink it meanwhile, the compare-and-swap then retries */
+    while ((uint32_t)r < (r >> 32))
+    {
+        if (atomic_compare_exchange_weak(own, &r, pack((uint32_t)r + 1, r >> 32)))
+        {
+            *task = (uint32_t)r;
+            return true;
+        }
+    }
+
+    /* Stealing: victims in round-robin order from the next thread, so thieves spread out */
+    for (i = 1; i < s->nthreads; i++)
+    {
+        _Atomic uint64_t *victim = &s->ranges[(tid + i) % s->nthreads].range;
+        uint64_t v = atomic_load(victim);
+        while ((uint32_t)v < (v >> 32))
+        {
+            uint64_t next = (uint32_t)v, end = v >> 32, first = end - (end - next + 1) / 2;
+            if (atomic_compare_exchange_weak(victim, &v, pack(next, first)))
+            {
+                /* Tasks after the first one become the new own range, the old one is empty */
+                atomic_store(own, pack(first + 1, end));
+                *task = first;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Releases the scheduler
+ *
+ * @param s the scheduler
+ */
+void huff_sched_free(struct huff_sched *s)
+{
+    free(s->ranges);
+    s->ranges = NULL;
+}
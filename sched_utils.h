@@ -0,0 +1,75 @@
+/**
+ * @file sched_utils.h
+ * @brief Work-stealing scheduler of block tasks: every thread owns a range of task
+ *        indices and, once it is empty, steals half of the range of another thread
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SCHED_H
+# define SCHED_H
+
+/* Size of a cache line: ranges of different threads never share one */
+#define HUFF_SCHED_LINE 64
+
+/* Task indices owned by a thread, packed as (end << 32) | next. The owner takes 'next',
+ * thieves take the upper half, both with a compare-and-swap of the whole word */
+struct huff_sched_range
+{
+    _Atomic uint64_t range;
+    char pad[HUFF_SCHED_LINE - sizeof(uint64_t)];
+};
+
+/* Scheduler of 'ntasks' tasks over 'nthreads' threads */
+struct huff_sched
+{
+    struct huff_sched_range *ranges; /* one per thread */
+    int nthreads;                    /* number of threads */
+    int capacity;                    /* ranges allocated */
+};
+
+/**
+ * @brief Gives every thread a contiguous share of the tasks, so that threads that never
+ * steal process consecutive tasks
+ *
+ * @param s the scheduler
+ * @param ntasks number of tasks, below 2^32
+ * @param nthreads number of threads that will call huff_sched_next()
+ * @return true if allocation did not fail
+ */
+bool huff_sched_init(struct huff_sched *s, size_t ntasks, int nthreads);
+
+/**
+ * @brief Starts a new set of tasks without allocating, e.g for the next buffer
+ *
+ * @param s the scheduler
+ * @param ntasks number of tasks, below 2^32
+ * @param nthreads number of threads, at most the ones given to huff_sched_init()
+ * @return true if the scheduler can hold them
+ */
+bool huff_sched_reset(struct huff_sched *s, size_t ntasks, int nthreads);
+
+/**
+ * @brief Next task of a thread: the next one of its range, otherwise the first one
+ * of the upper half stolen from another thread. Lock-free
+ *
+ * @param s the scheduler
+ * @param tid thread number, below 'nthreads'
+ * @param task location in which save the task index
+ * @return false when no task is left
+ */
+bool huff_sched_next(struct huff_sched *s, int tid, size_t *task);
+
+/**
+ * @brief Releases the scheduler
+ *
+ * @param s the scheduler
+ */
+void huff_sched_free(struct huff_sched *s);
+
+#endif
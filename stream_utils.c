@@ -0,0 +1,270 @@
+/**
+ * @file stream_utils.c
+ * @brief Implementation of the streaming decompression
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "stream_utils.h"
+#include "crc_utils.h"
+#include <fcntl.h>
+#include <omp.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Shared state of the threads of a decompression */
+struct stream_state
+{
+    struct huff_stream_slot *ring;
+    int nslots;
+    FILE *in;
+    int out;
+    _Atomic size_t nread;    /* blocks read, block i is in slot i % nslots */
+    _Atomic size_t ndecode;  /* next block to decode */
+    _Atomic size_t nwritten; /* blocks written, their slots are free */
+    _Atomic int eof;         /* true once the last block was read */
+    _Atomic int failed;
+    int table_block;         /* last block that carried a table, -1 if none */
+    unsigned char table[HUFF_TABLE_BYTES];
+    size_t offset;           /* output offset of the next block to write */
+};
+
+/* Grows a buffer of a slot, its content is not kept */
+static bool reserve(unsigned char **buf, size_t *cap, size_t size)
+{
+    if (size <= *cap)
+        return true;
+    free(*buf);
+    *buf = (unsigned char *)malloc(size);
+    *cap = (*buf != NULL) ? size : 0;
+    return *buf != NULL;
+}
+
+/* Reads blocks into the free slots. Only thread 0 calls it */
+static void read_blocks(struct stream_state *s, struct huff_stream_stats *stats)
+{
+    size_t n = atomic_load(&s->nread);
+    while (!atomic_load(&s->eof) && !atomic_load(&s->failed) && n - atomic_load(&s->nwritten) < (size_t)s->nslots)
+    {
+        struct huff_stream_slot *slot = &s->ring[n % s->nslots];
+        unsigned char header[HUFF_BLOCK_HEADER];
+        size_t got = fread(header, 1, HUFF_BLOCK_HEADER, s->in);
+        if (got == 0 && feof(s->in))
+        {
+            atomic_store(&s->eof, 1);
+            break;
+        }
+        size_t size = (got == HUFF_BLOCK_HEADER) ? huff_block_header(header, &slot->raw_len, &slot->crc) : 0;
+        if (size == 0 || !reserve(&slot->in, &slot->in_cap, size) ||
+            !reserve(&slot->out, &slot->out_cap, slot->raw_len + 1))
+        {
+            fprintf(stderr, "ERROR: Malformed stream!\n");
+            atomic_store(&s->failed, 1);
+            break;
+        }
+        memcpy(slot->in, header, HUFF_BLOCK_HEADER);
+        if (fread(slot->in + HUFF_BLOCK_HEADER, 1, size - HUFF_BLOCK_HEADER, s->in) != size - HUFF_BLOCK_HEADER)
+        {
+            fprintf(stderr, "ERROR: Truncated stream!\n");
+            atomic_store(&s->failed, 1);
+            break;
+        }
+        slot->in_len = size;
+
+        /* Blocks reusing a table get a copy of it, decoders may take them before its block */
+        slot->table_block = -1;
+        if (header[8] & HUFF_BLOCK_TABLE)
+        {
+            s->table_block = n;
+            memcpy(s->table, slot->in + HUFF_BLOCK_HEADER, HUFF_TABLE_BYTES);
+        }
+        else if (!(header[8] & (HUFF_BLOCK_RAW | HUFF_BLOCK_ANS | HUFF_BLOCK_SHARED)))
+        {
+            if (s->table_block < 0)
+            {
+                fprintf(stderr, "ERROR: Malformed stream!\n");
+                atomic_store(&s->failed, 1);
+                break;
+            }
+            slot->table_block = s->table_block;
+            memcpy(slot->table, s->table, HUFF_TABLE_BYTES);
+        }
+        atomic_store(&slot->state, 0);
+        atomic_store(&s->nread, ++n);
+        if (stats != NULL && (int)(n - atomic_load(&s->nwritten)) > stats->max_inflight)
+            stats->max_inflight = n - atomic_load(&s->nwritten);
+    }
+}
+
+/* Writes the decoded blocks that follow the last written one. Only thread 0 calls it */
+static void write_blocks(struct stream_state *s, struct huff_stream_stats *stats, double start)
+{
+    size_t n = atomic_load(&s->nwritten);
+    while (n < atomic_load(&s->nread) && !atomic_load(&s->failed))
+    {
+        struct huff_stream_slot *slot = &s->ring[n % s->nslots];
+        int state = atomic_load(&slot->state);
+        if (state == 0)
+            break;
+        size_t done = 0;
+        while (state > 0 && done < slot->raw_len)
+        {
+            ssize_t w = pwrite(s->out, slot->out + done, slot->raw_len - done, s->offset + done);
+            if (w <= 0)
+            {
+                fprintf(stderr, "ERROR: Can not write the output!\n");
+                state = -1;
+            }
+            else
+                done += w;
+        }
+        if (state < 0)
+        {
+            atomic_store(&s->failed, 1);
+            break;
+        }
+        if (stats != NULL)
+        {
+            if (stats->raw_bytes == 0 && slot->raw_len > 0)
+                stats->first_byte = omp_get_wtime() - start;
+            stats->blocks++;
+            stats->raw_bytes += slot->raw_len;
+            stats->crc = huff_crc32c_combine(stats->crc, slot->crc, slot->raw_len);
+        }
+        s->offset += slot->raw_len;
+        atomic_store(&s->nwritten, ++n);
+    }
+}
+
+/* Takes the next block read and not yet taken, returns false if there is none now */
+static bool next_block(struct stream_state *s, size_t *block)
+{
+    size_t d = atomic_load(&s->ndecode);
+    while (d < atomic_load(&s->nread))
+    {
+        if (atomic_compare_exchange_weak(&s->ndecode, &d, d + 1))
+        {
+            *block = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Decompresses a stream of blocks from a file into another one. Thread 0 reads
+ * the blocks sequentially into a ring of slots and writes the decoded ones in order with
+ * pwrite(); every thread, thread 0 included when it has no I/O to do, takes the next block
+ * read and decodes it. A block is read only when its slot was written, so at most 'slots'
+ * blocks are in memory. The checksum of every block is verified by its decoder
+ *
+ * @param ctx decoders, one per thread. Shared table as set by huff_block_ctx_share()
+ * @param in_path compressed file e.g written by huff_compress_fused()
+ * @param out_path decoded file, replaced. Removed on failure
+ * @param slots slots of the ring, 0 for HUFF_STREAM_SLOTS per thread
+ * @param stats location in which save the figures, NULL if not needed
+ * @return true if the whole stream was decoded and written
+ */
+bool huff_decompress_stream(struct huff_block_ctx *ctx, const char *in_path, const char *out_path, int slots,
+                            struct huff_stream_stats *stats)
+{
+    struct stream_state s;
+    int threads = (omp_get_max_threads() < ctx->nthreads) ? omp_get_max_threads() : ctx->nthreads, i;
+    double start = omp_get_wtime();
+
+    memset(&s, 0, sizeof(s));
+    s.nslots = (slots > 0) ? slots : HUFF_STREAM_SLOTS * threads;
+    s.table_block = -1;
+    atomic_init(&s.nread, 0);
+    atomic_init(&s.ndecode, 0);
+    atomic_init(&s.nwritten, 0);
+    atomic_init(&s.eof, 0);
+    atomic_init(&s.failed, 0);
+    if (stats != NULL)
+        memset(stats, 0, sizeof(struct huff_stream_stats));
+    s.in = fopen(in_path, "rb");
+    if (s.in == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not read [%s]!\n", in_path);
+        return false;
+    }
+    s.out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    s.ring = (struct huff_stream_slot *)calloc(s.nslots, sizeof(struct huff_stream_slot));
+    if (s.out < 0 || s.ring == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not write [%s]!\n", out_path);
+        fclose(s.in);
+        if (s.out >= 0)
+            close(s.out);
+        free(s.ring);
+        return false;
+    }
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int tid = omp_get_thread_num(), loaded = -1;
+        struct huff_block_decoder *dec = &ctx->dec[tid];
+        size_t block;
+
+        for (;;)
+        {
+            /* Thread 0 does the I/O first: written slots are read again as soon as possible */
+            if (tid == 0)
+            {
+                write_blocks(&s, stats, start);
+                read_blocks(&s, stats);
+            }
+            if (atomic_load(&s.failed))
+                break;
+            if (next_block(&s, &block))
+            {
+                struct huff_stream_slot *slot = &s.ring[block % s.nslots];
+                size_t raw_len;
+                int state = 1;
+                if (slot->table_block >= 0 && slot->table_block != loaded)
+                    state = huff_block_decoder_load_table(dec, slot->table) ? 1 : -1;
+                if (state > 0 && huff_decompress_block(dec, slot->in, slot->in_len, slot->out, slot->raw_len,
+                                                       &raw_len) == 0)
+                    state = -1;
+                if (state < 0)
+                    fprintf(stderr, "ERROR: Can not decode block %zu!\n", block);
+                /* A block carrying a table leaves it loaded for the blocks that reuse it */
+                if (slot->in[8] & HUFF_BLOCK_TABLE)
+                    loaded = block;
+                else if (slot->table_block >= 0)
+                    loaded = slot->table_block;
+                atomic_store(&slot->state, state);
+                continue;
+            }
+            /* Done once everything read was taken, thread 0 once everything was written */
+            if (atomic_load(&s.eof) &&
+                atomic_load((tid == 0) ? &s.nwritten : &s.ndecode) == atomic_load(&s.nread))
+                break;
+            sched_yield();
+        }
+    }
+
+    bool ok = !atomic_load(&s.failed);
+    if (stats != NULL)
+    {
+        for (i = 0; i < s.nslots; i++)
+            stats->ring_bytes += s.ring[i].in_cap + s.ring[i].out_cap;
+        stats->seconds = omp_get_wtime() - start;
+    }
+    for (i = 0; i < s.nslots; i++)
+    {
+        free(s.ring[i].in);
+        free(s.ring[i].out);
+    }
+    free(s.ring);
+    fclose(s.in);
+    if (close(s.out) != 0)
+        ok = false;
+    /* No partial output is left behind */
+    if (!ok)
+        unlink(out_path);
+    return ok;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file stream_utils.h
+ * @brief Streaming decompression to disk: blocks are read one by one, decoded by a team of
+ *        threads and written in order through a bounded ring of slots, so memory does not
+ *        depend on the size of the file
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "block_utils.h"
+
+#ifndef STREAM_H
+# define STREAM_H
+
+/* Default slots of the ring per thread: one decoding, one waiting to be decoded or written */
+#define HUFF_STREAM_SLOTS 2
+
+/* A block in flight, from the read of its compressed bytes to the write of its decoded ones */
+struct huff_stream_slot
+{
+    unsigned char *in;                       /* compressed block, header included */
+    size_t in_cap;                           /* allocated bytes of 'in' */
+    size_t in_len;                           /* size of the block */
+    unsigned char *out;                      /* decoded bytes */
+    size_t out_cap;                          /* allocated bytes of 'out' */
+    size_t raw_len;                          /* decoded size from the header */
+    uint32_t crc;                            /* CRC32C of the decoded bytes from the header */
+    int table_block;                         /* index of the block carrying the table, -1 if none is needed */
+    unsigned char table[HUFF_TABLE_BYTES];   /* copy of that table, its block may be written already */
+    _Atomic int state;                       /* 0 waiting, 1 decoded, -1 failed */
+};
+
+/* Figures of a streaming decompression */
+struct huff_stream_stats
+{
+    size_t blocks;     /* decoded blocks */
+    size_t raw_bytes;  /* written bytes */
+    int max_inflight;  /* most blocks read and not yet written at once */
+    size_t ring_bytes; /* bytes allocated by the slots */
+    double first_byte; /* seconds from the start to the first written byte */
+    double seconds;    /* seconds of the whole decompression */
+    uint32_t crc;      /* CRC32C of the output, combined from the block checksums */
+};
+
+/**
+ * @brief Decompresses a stream of blocks from a file into another one. Thread 0 reads
+ * the blocks sequentially into a ring of slots and writes the decoded ones in order with
+ * pwrite(); every thread, thread 0 included when it has no I/O to do, takes the next block
+ * read and decodes it. A block is read only when its slot was written, so at most 'slots'
+ * blocks are in memory. The checksum of every block is verified by its decoder
+ *
+ * @param ctx decoders, one per thread. Shared table as set by huff_block_ctx_share()
+ * @param in_path compressed file e.g written by huff_compress_fused()
+ * @param out_path decoded file, replaced. Removed on failure
+ * @param slots slots of the ring, 0 for HUFF_STREAM_SLOTS per thread
+ * @param stats location in which save the figures, NULL if not needed
+ * @return true if the whole stream was decoded and written
+ */
+bool huff_decompress_stream(struct huff_block_ctx *ctx, const char *in_path, const char *out_path, int slots,
+                            struct huff_stream_stats *stats);
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ * @file timer_utils.c
+ * @brief Implementation of the per-phase timers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "timer_utils.h"
+#include "counter_utils.h"
+#include <omp.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Timers of one thread, padded so that threads do not share cache lines */
+struct thread_timers
+{
+    double elapsed[PHASE_COUNT];
+    double started[PHASE_COUNT];
+    unsigned int calls[PHASE_COUNT];
+    unsigned long long bytes[PHASE_COUNT];
+    uint64_t counts[PHASE_COUNT][COUNTER_EVENTS];         /* counter deltas of each phase */
+    uint64_t started_counts[PHASE_COUNT][COUNTER_EVENTS]; /* counter values at timer_begin() */
+    struct counter_group group;                           /* counters of the thread */
+    int group_state;                                      /* 0 not opened yet, 1 open, -1 unavailable */
+    char pad[64];
+};
+
+static struct thread_timers timers[TIMER_MAX_THREADS];
+static enum timer_format timers_format = TIMER_OFF;
+static bool timers_counters = false;
+
+static const char *phase_names[PHASE_COUNT] = {
+    "read", "scatter", "histogram", "reduce", "tree", "code_table",
+    "bcast", "encode", "gather", "decode", "merge", "verify"};
+
+/**
+ * @brief Clears all timers and selects the format. With TIMER_OFF begin/end do nothing
+ *
+ * @param format the output format
+ * @param counters true to also read hardware counters (see counter_utils.h)
+ */
+void timers_init(enum timer_format format, bool counters)
+{
+    memset(timers, 0, sizeof(timers));
+    timers_format = format;
+    timers_counters = counters && format != TIMER_OFF;
+}
+
+/* Counters of the calling thread, opened on first use. NULL if unavailable */
+static struct counter_group *thread_counters(struct thread_timers *t)
+{
+    if (!timers_counters)
+        return NULL;
+    if (t->group_state == 0)
+        t->group_state = counters_open(&t->group) ? 1 : -1;
+    return (t->group_state > 0) ? &t->group : NULL;
+}
+
+/**
+ * @brief Starts a phase on the calling thread
+ *
+ * @param phase the phase
+ */
+void timer_begin(enum huff_phase phase)
+{
+    int tid = omp_get_thread_num();
+    if (timers_format == TIMER_OFF || tid >= TIMER_MAX_THREADS)
+        return;
+    struct counter_group *g = thread_counters(&timers[tid]);
+    if (g != NULL)
+        counters_read(g, timers[tid].started_counts[phase]);
+    timers[tid].started[phase] = omp_get_wtime();
+}
+
+/**
+ * @brief Ends a phase on the calling thread and adds its elapsed time
+ *
+ * @param phase the phase
+ */
+void timer_end(enum huff_phase phase)
+{
+    int tid = omp_get_thread_num();
+    if (timers_format == TIMER_OFF || tid >= TIMER_MAX_THREADS)
+        return;
+    struct thread_timers *t = &timers[tid];
+    t->elapsed[phase] += omp_get_wtime() - t->started[phase];
+    t->calls[phase]++;
+
+    uint64_t now[COUNTER_EVENTS];
+    struct counter_group *g = thread_counters(t);
+    int e;
+    if (g != NULL && counters_read(g, now))
+    {
+        for (e = 0; e < COUNTER_EVENTS; e++)
+            t->counts[phase][e] += now[e] - t->started_counts[phase][e];
+    }
+}
+
+/**
+ * @brief Adds the bytes processed by the calling thread in a phase, for bytes/cycle
+ *
+ * @param phase the phase
+ * @param bytes processed bytes
+ */
+void timer_add_bytes(enum huff_phase phase, size_t bytes)
+{
+    int tid = omp_get_thread_num();
+    if (timers_format == TIMER_OFF || tid >= TIMER_MAX_THREADS)
+        return;
+    timers[tid].bytes[phase] += bytes;
+}
+
+/**
+ * @param phase the phase
+ * @return name of the phase
+ */
+const char *timer_phase_name(enum huff_phase phase)
+{
+    return phase_names[phase];
+}
+
+/**
+ * @brief Time of a phase on this rank: the slowest thread
+ *
+ * @param phase the phase
+ * @return seconds
+ */
+double timer_elapsed(enum huff_phase phase)
+{
+    double max = 0;
+    int t;
+    for (t = 0; t < TIMER_MAX_THREADS; t++)
+    {
+        if (timers[t].elapsed[phase] > max)
+            max = timers[t].elapsed[phase];
+    }
+    return max;
+}
+
+/* Ratio, or -1 when the denominator was not counted */
+static double ratio(double num, double den)
+{
+    return (den > 0) ? num / den : -1;
+}
+
+/* Prints the counters of a phase: IPC, misses per thousand instructions and bytes per cycle */
+static void print_counters(const unsigned long long *counts, unsigned long long bytes, const int *available)
+{
+    double cycles = available[COUNTER_CYCLES] ? counts[COUNTER_CYCLES] : 0;
+    double instructions = available[COUNTER_INSTRUCTIONS] ? counts[COUNTER_INSTRUCTIONS] : 0;
+    double ipc = ratio(instructions, cycles);
+    double branch_mpki = available[COUNTER_BRANCH_MISSES] ? ratio(1000.0 * counts[COUNTER_BRANCH_MISSES], instructions) : -1;
+    double llc_mpki = available[COUNTER_LLC_MISSES] ? ratio(1000.0 * counts[COUNTER_LLC_MISSES], instructions) : -1;
+    double bytes_per_cycle = (bytes > 0) ? ratio(bytes, cycles) : -1;
+
+    if (timers_format == TIMER_JSON)
+    {
+        int e;
+        printf(", \"counters\": {");
+        for (e = 0; e < COUNTER_EVENTS; e++)
+        {
+            if (available[e])
+                printf("\"%s\": %llu, ", counter_event_name(e), counts[e]);
+            else
+                printf("\"%s\": null, ", counter_event_name(e));
+        }
+        printf("\"bytes\": %llu", bytes);
+        double derived[4] = {ipc, branch_mpki, llc_mpki, bytes_per_cycle};
+        const char *names[4] = {"ipc", "branch_mpki", "llc_mpki", "bytes_per_cycle"};
+        for (e = 0; e < 4; e++)
+        {
+            if (derived[e] >= 0)
+                printf(", \"%s\": %.4f", names[e], derived[e]);
+            else
+                printf(", \"%s\": null", names[e]);
+        }
+        printf("}");
+        return;
+    }
+    printf("%14.0f %14.0f", cycles, instructions);
+    double derived[4] = {ipc, branch_mpki, llc_mpki, bytes_per_cycle};
+    int e;
+    for (e = 0; e < 4; e++)
+    {
+        if (derived[e] >= 0)
+            printf(" %12.4f", derived[e]);
+        else
+            printf(" %12s", "-");
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Reduces the timers of all ranks and prints them on rank 0. Collective over 'comm'
+ * The value of a rank is its slowest thread. Statistics of a phase are over
+ * the ranks that went through it. Counters and bytes are summed over threads and ranks.
+ *
+ * @param comm the communicator
+ */
+void timers_report(MPI_Comm comm)
+{
+    /* Per rank values */
+    double value[PHASE_COUNT], square[PHASE_COUNT], ran_value[PHASE_COUNT];
+    double sum[PHASE_COUNT], sum_square[PHASE_COUNT], min[PHASE_COUNT];
+    struct { double value; int rank; } local[PHASE_COUNT], max[PHASE_COUNT];
+    int threads[PHASE_COUNT], max_threads[PHASE_COUNT], ran[PHASE_COUNT], ranks[PHASE_COUNT];
+    unsigned long long counts[PHASE_COUNT][COUNTER_EVENTS], total_counts[PHASE_COUNT][COUNTER_EVENTS];
+    unsigned long long bytes[PHASE_COUNT], total_bytes[PHASE_COUNT];
+    int available[COUNTER_EVENTS], any_available[COUNTER_EVENTS];
+    int myrank, world_size, p, t, e;
+
+    if (timers_format == TIMER_OFF)
+        return;
+    MPI_Comm_rank(comm, &myrank);
+    MPI_Comm_size(comm, &world_size);
+    memset(counts, 0, sizeof(counts));
+    memset(available, 0, sizeof(available));
+    for (t = 0; t < TIMER_MAX_THREADS; t++)
+    {
+        if (timers[t].group_state <= 0)
+            continue;
+        for (e = 0; e < COUNTER_EVENTS; e++)
+            available[e] |= counters_available(&timers[t].group, e);
+        counters_close(&timers[t].group);
+        timers[t].group_state = 0;
+    }
+    for (p = 0; p < PHASE_COUNT; p++)
+    {
+        value[p] = timer_elapsed(p);
+        square[p] = value[p] * value[p];
+        local[p].value = value[p];
+        local[p].rank = myrank;
+        threads[p] = 0;
+        bytes[p] = 0;
+        for (t = 0; t < TIMER_MAX_THREADS; t++)
+        {
+            threads[p] += (timers[t].calls[p] > 0);
+            bytes[p] += timers[t].bytes[p];
+            for (e = 0; e < COUNTER_EVENTS; e++)
+                counts[p][e] += timers[t].counts[p][e];
+        }
+        ran[p] = (threads[p] > 0);
+        /* Ranks that did not go through a phase do not count for its statistics */
+        ran_value[p] = ran[p] ? value[p] : HUGE_VAL;
+    }
+
+    MPI_Reduce(value, sum, PHASE_COUNT, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce(square, sum_square, PHASE_COUNT, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce(ran_value, min, PHASE_COUNT, MPI_DOUBLE, MPI_MIN, 0, comm);
+    MPI_Reduce(local, max, PHASE_COUNT, MPI_DOUBLE_INT, MPI_MAXLOC, 0, comm);
+    MPI_Reduce(threads, max_threads, PHASE_COUNT, MPI_INT, MPI_MAX, 0, comm);
+    MPI_Reduce(ran, ranks, PHASE_COUNT, MPI_INT, MPI_SUM, 0, comm);
+    MPI_Reduce(counts, total_counts, PHASE_COUNT * COUNTER_EVENTS, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, comm);
+    MPI_Reduce(bytes, total_bytes, PHASE_COUNT, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, comm);
+    MPI_Reduce(available, any_available, COUNTER_EVENTS, MPI_INT, MPI_MAX, 0, comm);
+    if (myrank != 0)
+        return;
+
+    bool with_counters = false;
+    for (e = 0; e < COUNTER_EVENTS; e++)
+        with_counters |= any_available[e];
+    if (timers_format == TIMER_JSON)
+    {
+        printf("{\"ranks\": %d, ", world_size);
+        if (timers_counters && !with_counters)
+            printf("\"counters_unavailable\": \"%s\", ", counters_error());
+        printf("\"phases\": {");
+    }
+    else
+        printf("%-11s %6s %7s %12s %12s %12s %12s %8s\n", "phase", "ranks", "threads", "min", "max", "mean",
+               "stddev", "slowest");
+    bool first = true;
+    for (p = 0; p < PHASE_COUNT; p++)
+    {
+        /* Phases no rank went through are not printed */
+        if (ranks[p] == 0)
+            continue;
+        double mean = sum[p] / ranks[p];
+        double variance = sum_square[p] / ranks[p] - mean * mean;
+        double stddev = (variance > 0) ? sqrt(variance) : 0;
+        if (timers_format == TIMER_JSON)
+        {
+            printf("%s\"%s\": {\"ranks\": %d, \"threads\": %d, \"min\": %e, \"max\": %e, \"mean\": %e, "
+                   "\"stddev\": %e, \"slowest_rank\": %d",
+                   first ? "" : ", ", phase_names[p], ranks[p], max_threads[p], min[p], max[p].value, mean,
+                   stddev, max[p].rank);
+            if (with_counters)
+                print_counters(total_counts[p], total_bytes[p], any_available);
+            printf("}");
+        }
+        else
+            printf("%-11s %6d %7d %12e %12e %12e %12e %8d\n", phase_names[p], ranks[p], max_threads[p], min[p],
+                   max[p].value, mean, stddev, max[p].rank);
+        first = false;
+    }
+    if (timers_format == TIMER_JSON)
+        printf("}}\n");
+
+    /* Counters table, summed over all threads and ranks */
+    if (timers_format == TIMER_TEXT && timers_counters)
+    {
+        if (!with_counters)
+            printf("counters: unavailable (%s)\n", counters_error());
+        else
+        {
+            printf("%-11s %14s %14s %12s %12s %12s %12s\n", "phase", "cycles", "instructions", "ipc",
+                   "branch_mpki", "llc_mpki", "bytes/cycle");
+            for (p = 0; p < PHASE_COUNT; p++)
+            {
+                if (ranks[p] == 0)
+                    continue;
+                printf("%-11s ", phase_names[p]);
+                print_counters(total_counts[p], total_bytes[p], any_available);
+            }
+        }
+    }
+    fflush(stdout);
+}
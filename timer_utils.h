@@ -0,0 +1,97 @@
+/**
+ * @file timer_utils.h
+ * @brief Named per-phase timers, recorded on every rank and thread and
+ *        reduced across ranks (min/max/mean/stddev) at exit. Optionally hardware
+ *        counters are read at the same points.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <mpi.h>
+
+#ifndef TIMER_H
+# define TIMER_H
+
+/* Phases of the pipeline */
+enum huff_phase
+{
+    PHASE_READ,
+    PHASE_SCATTER,
+    PHASE_HISTOGRAM,
+    PHASE_REDUCE,
+    PHASE_TREE,
+    PHASE_CODE_TABLE,
+    PHASE_BCAST,
+    PHASE_ENCODE,
+    PHASE_GATHER,
+    PHASE_DECODE,
+    PHASE_MERGE,
+    PHASE_VERIFY,
+    PHASE_COUNT
+};
+
+/* Threads with a higher id are not recorded */
+#define TIMER_MAX_THREADS 256
+
+/* Output formats of the report */
+enum timer_format
+{
+    TIMER_OFF,   /* timers are not recorded */
+    TIMER_TEXT,  /* human readable table */
+    TIMER_JSON   /* one JSON object */
+};
+
+/**
+ * @brief Clears all timers and selects the format. With TIMER_OFF begin/end do nothing
+ *
+ * @param format the output format
+ * @param counters true to also read hardware counters (see counter_utils.h)
+ */
+void timers_init(enum timer_format format, bool counters);
+
+/**
+ * @brief Starts a phase on the calling thread
+ *
+ * @param phase the phase
+ */
+void timer_begin(enum huff_phase phase);
+
+/**
+ * @brief Ends a phase on the calling thread and adds its elapsed time
+ *
+ * @param phase the phase
+ */
+void timer_end(enum huff_phase phase);
+
+/**
+ * @brief Adds the bytes processed by the calling thread in a phase, for bytes/cycle
+ *
+ * @param phase the phase
+ * @param bytes processed bytes
+ */
+void timer_add_bytes(enum huff_phase phase, size_t bytes);
+
+/**
+ * @param phase the phase
+ * @return name of the phase
+ */
+const char *timer_phase_name(enum huff_phase phase);
+
+/**
+ * @brief Time of a phase on this rank: the slowest thread
+ *
+ * @param phase the phase
+ * @return seconds
+ */
+double timer_elapsed(enum huff_phase phase);
+
+/**
+ * @brief Reduces the timers of all ranks and prints them on rank 0. Collective over 'comm'
+ *
+ * @param comm the communicator
+ */
+void timers_report(MPI_Comm comm);
+
+#endif
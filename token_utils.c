@@ -0,0 +1,404 @@
+/**
+ * @file token_utils.c
+ * @brief Implementation of token level coding
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "token_utils.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VOCAB_INITIAL_CAPACITY 1024
+
+/* Word bytes: letters, digits, '_' and non-ASCII bytes (so UTF-8 words stay whole) */
+static int is_word(unsigned char b)
+{
+    return isalnum(b) || b == '_' || b >= 0x80;
+}
+
+/* Size of the token starting at 'in': a run of word bytes or a run of separators */
+static size_t next_token(const unsigned char *in, size_t len)
+{
+    size_t n = 1;
+    int word = is_word(in[0]);
+    while (n < len && n < HUFF_TOKEN_MAX_LEN && is_word(in[n]) == word)
+        n++;
+    return n;
+}
+
+static uint32_t hash_token(const unsigned char *token, int len)
+{
+    uint32_t h = 2166136261u;
+    int i;
+    for (i = 0; i < len; i++)
+        h = (h ^ token[i]) * 16777619u;
+    return h;
+}
+
+static bool vocab_init(struct huff_vocab *v)
+{
+    memset(v, 0, sizeof(struct huff_vocab));
+    v->capacity = VOCAB_INITIAL_CAPACITY;
+    v->pool_capacity = VOCAB_INITIAL_CAPACITY * 8;
+    v->nslots = 2 * VOCAB_INITIAL_CAPACITY;
+    v->pool = (unsigned char *)malloc(v->pool_capacity);
+    v->offsets = (size_t *)malloc(v->capacity * sizeof(size_t));
+    v->lens = (unsigned char *)malloc(v->capacity);
+    v->counts = (unsigned int *)calloc(v->capacity, sizeof(unsigned int));
+    v->slots = (int *)malloc(v->nslots * sizeof(int));
+    if (v->pool == NULL || v->offsets == NULL || v->lens == NULL || v->counts == NULL || v->slots == NULL)
+        return false;
+    memset(v->slots, -1, v->nslots * sizeof(int));
+    return true;
+}
+
+static void vocab_free(struct huff_vocab *v)
+{
+    free(v->pool);
+    free(v->offsets);
+    free(v->lens);
+    free(v->counts);
+    free(v->slots);
+    memset(v, 0, sizeof(struct huff_vocab));
+}
+
+static int vocab_slot(const struct huff_vocab *v, const unsigned char *token, int len)
+{
+    int slot = hash_token(token, len) & (v->nslots - 1);
+    while (v->slots[slot] >= 0)
+    {
+        int id = v->slots[slot];
+        if (v->lens[id] == len && memcmp(v->pool + v->offsets[id], token, len) == 0)
+            break;
+        slot = (slot + 1) & (v->nslots - 1);
+    }
+    return slot;
+}
+
+/* Grows arrays and hash when the vocabulary is half full */
+static bool vocab_reserve(struct huff_vocab *v, int len)
+{
+    if (v->pool_size + len > v->pool_capacity)
+    {
+        size_t cap = 2 * v->pool_capacity + len;
+        unsigned char *pool = (unsigned char *)realloc(v->pool, cap);
+        if (pool == NULL)
+            return false;
+        v->pool = pool;
+        v->pool_capacity = cap;
+    }
+    if (v->ntokens + 1 > v->capacity)
+    {
+        int cap = 2 * v->capacity;
+        size_t *offsets = (size_t *)realloc(v->offsets, cap * sizeof(size_t));
+        unsigned char *lens = (unsigned char *)realloc(v->lens, cap);
+        unsigned int *counts = (unsigned int *)realloc(v->counts, cap * sizeof(unsigned int));
+        if (offsets != NULL)
+            v->offsets = offsets;
+        if (lens != NULL)
+            v->lens = lens;
+        if (counts != NULL)
+            v->counts = counts;
+        if (offsets == NULL || lens == NULL || counts == NULL)
+            return false;
+        v->capacity = cap;
+    }
+    if (2 * (v->ntokens + 1) > v->nslots)
+    {
+        int i;
+        free(v->slots);
+        v->nslots *= 2;
+        v->slots = (int *)malloc(v->nslots * sizeof(int));
+        if (v->slots == NULL)
+            return false;
+        memset(v->slots, -1, v->nslots * sizeof(int));
+        for (i = 0; i < v->ntokens; i++)
+            v->slots[vocab_slot(v, v->pool + v->offsets[i], v->lens[i])] = i;
+    }
+    return true;
+}
+
+/* Adds 'count' occurrences of a token, inserting it if needed. Returns its id */
+static int vocab_add(struct huff_vocab *v, const unsigned char *token, int len, unsigned int count)
+{
+    int slot = vocab_slot(v, token, len);
+    if (v->slots[slot] < 0)
+    {
+        if (!vocab_reserve(v, len))
+            return -1;
+        slot = vocab_slot(v, token, len);
+        int id = v->ntokens++;
+        memcpy(v->pool + v->pool_size, token, len);
+        v->offsets[id] = v->pool_size;
+        v->lens[id] = len;
+        v->counts[id] = 0;
+        v->pool_size += len;
+        v->slots[slot] = id;
+    }
+    v->counts[v->slots[slot]] += count;
+    return v->slots[slot];
+}
+
+/* Inserts the 256 single bytes, so that their id is their value */
+static bool vocab_add_bytes(struct huff_vocab *v)
+{
+    int i;
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+    {
+        unsigned char b = i;
+        if (vocab_add(v, &b, 1, 0) != i)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @param c codec to initialize
+ * @return true if allocation did not fail
+ */
+bool huff_token_init(struct huff_token_codec *c)
+{
+    memset(c, 0, sizeof(struct huff_token_codec));
+    if (!vocab_init(&c->vocab) || !vocab_add_bytes(&c->vocab) || !huff_table_init(&c->table, HUFF_BYTE_SYMBOLS))
+    {
+        huff_token_free(c);
+        return false;
+    }
+    return true;
+}
+
+void huff_token_free(struct huff_token_codec *c)
+{
+    vocab_free(&c->vocab);
+    huff_table_free(&c->table);
+}
+
+/**
+ * @brief Tokenizes the input and adds the counts to the vocabulary
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size
+ * @return true if allocation did not fail
+ */
+bool huff_token_count(struct huff_token_codec *c, const unsigned char *in, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len)
+    {
+        size_t n = next_token(in + pos, len - pos);
+        if (vocab_add(&c->vocab, in + pos, n, 1) < 0)
+            return false;
+        pos += n;
+    }
+    return true;
+}
+
+/**
+ * @brief Adds a token with zero count e.g while merging vocabularies
+ *
+ * @param c the codec
+ * @param token token bytes
+ * @param len token size
+ * @return id of the token, -1 on error
+ */
+int huff_token_add(struct huff_token_codec *c, const unsigned char *token, int len)
+{
+    return vocab_add(&c->vocab, token, len, 0);
+}
+
+/**
+ * @brief Looks for a token
+ *
+ * @param c the codec
+ * @param token token bytes
+ * @param len token size
+ * @return id of the token, -1 if not found
+ */
+int huff_token_find(const struct huff_token_codec *c, const unsigned char *token, int len)
+{
+    return c->vocab.slots[vocab_slot(&c->vocab, token, len)];
+}
+
+/**
+ * @brief Drops rare tokens (their bytes are counted instead) and builds the table
+ *
+ * @param c the codec, after the counts
+ * @return true if table is valid
+ */
+bool huff_token_finish(struct huff_token_codec *c)
+{
+    struct huff_vocab kept;
+    struct huff_vocab *v = &c->vocab;
+    int i, k;
+
+    if (!vocab_init(&kept) || !vocab_add_bytes(&kept))
+    {
+        vocab_free(&kept);
+        return false;
+    }
+    for (i = 0; i < HUFF_BYTE_SYMBOLS; i++)
+        kept.counts[i] = v->counts[i];
+    for (i = HUFF_BYTE_SYMBOLS; i < v->ntokens; i++)
+    {
+        const unsigned char *token = v->pool + v->offsets[i];
+        if (v->counts[i] >= HUFF_TOKEN_MIN_COUNT)
+        {
+            if (vocab_add(&kept, token, v->lens[i], v->counts[i]) < 0)
+            {
+                vocab_free(&kept);
+                return false;
+            }
+        }
+        else
+        {
+            for (k = 0; k < v->lens[i]; k++)
+                kept.counts[token[k]] += v->counts[i];
+        }
+    }
+    vocab_free(v);
+    *v = kept;
+
+    if (v->ntokens > c->table.capacity)
+    {
+        huff_table_free(&c->table);
+        if (!huff_table_init(&c->table, v->ntokens))
+            return false;
+    }
+    c->table.nsymbols = v->ntokens;
+    return huff_table_from_freq(&c->table, v->counts, HUFF_TOKEN_MAX_BITS);
+}
+
+/**
+ * @brief Serializes the multi-byte tokens as (size, bytes) pairs
+ *
+ * @param c the codec
+ * @param out output buffer, NULL to only compute the size
+ * @return written bytes
+ */
+size_t huff_token_write_vocab(const struct huff_token_codec *c, unsigned char *out)
+{
+    const struct huff_vocab *v = &c->vocab;
+    size_t pos = 0;
+    int i;
+    for (i = HUFF_BYTE_SYMBOLS; i < v->ntokens; i++)
+    {
+        if (out != NULL)
+        {
+            out[pos] = v->lens[i];
+            memcpy(out + pos + 1, v->pool + v->offsets[i], v->lens[i]);
+        }
+        pos += 1 + v->lens[i];
+    }
+    return pos;
+}
+
+/**
+ * @brief Adds the tokens written by huff_token_write_vocab() with zero count
+ *
+ * @param c the codec
+ * @param in serialized tokens
+ * @param len size of the serialized tokens
+ * @return true if the input is well formed
+ */
+bool huff_token_read_vocab(struct huff_token_codec *c, const unsigned char *in, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len)
+    {
+        int n = in[pos];
+        if (n == 0 || pos + 1 + n > len || huff_token_add(c, in + pos + 1, n) < 0)
+            return false;
+        pos += 1 + n;
+    }
+    return true;
+}
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by huff_token_encode()
+ */
+size_t huff_token_bound(size_t len)
+{
+    return (len * HUFF_TOKEN_MAX_BITS + 7) / 8;
+}
+
+/**
+ * @brief Encodes a buffer. Tokens out of the vocabulary are spelled byte by byte
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least huff_token_bound(len) bytes
+ * @param nsymbols location in which save the number of coded symbols
+ * @return written bytes, 0 on error
+ */
+size_t huff_token_encode(const struct huff_token_codec *c, const unsigned char *in, size_t len, unsigned char *out, size_t *nsymbols)
+{
+    struct bit_writer w;
+    size_t pos = 0, count = 0;
+    bw_init(&w, out);
+    while (pos < len)
+    {
+        size_t k, n = next_token(in + pos, len - pos);
+        int id = huff_token_find(c, in + pos, n);
+        if (id >= 0 && c->table.lengths[id] != 0)
+        {
+            bw_put(&w, c->table.codes[id], c->table.lengths[id]);
+            count++;
+        }
+        else
+        {
+            for (k = 0; k < n; k++)
+            {
+                if (c->table.lengths[in[pos + k]] == 0)
+                {
+                    fprintf(stderr, "ERROR: byte %d has no code!\n", in[pos + k]);
+                    return 0;
+                }
+                bw_put(&w, c->table.codes[in[pos + k]], c->table.lengths[in[pos + k]]);
+                count++;
+            }
+        }
+        pos += n;
+    }
+    *nsymbols = count;
+    return bw_flush(&w);
+}
+
+/**
+ * @brief Decodes 'nsymbols' tokens
+ *
+ * @param c the codec
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param nsymbols number of tokens to decode
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the input is a valid encoding
+ */
+bool huff_token_decode(const struct huff_token_codec *c, const unsigned char *in, size_t in_len, size_t nsymbols,
+                       unsigned char *out, size_t out_cap, size_t *out_len)
+{
+    const struct huff_vocab *v = &c->vocab;
+    struct bit_reader r;
+    size_t i, pos = 0;
+    br_init(&r, in, in_len);
+    for (i = 0; i < nsymbols; i++)
+    {
+        br_refill(&r);
+        int id = huff_decode_symbol(&c->table, &r);
+        if (id < 0 || id >= v->ntokens || pos + v->lens[id] > out_cap)
+            return false;
+        memcpy(out + pos, v->pool + v->offsets[id], v->lens[id]);
+        pos += v->lens[id];
+    }
+    *out_len = pos;
+    return br_consumed(&r) <= in_len * 8;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file token_utils.h
+ * @brief Token level coding: input is split into words and separators and
+ *        every token of the vocabulary is a single symbol
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "codec_utils.h"
+
+#ifndef TOKEN_H
+# define TOKEN_H
+
+/* Longer words are split into tokens of this size */
+#define HUFF_TOKEN_MAX_LEN 32
+
+/* Tokens seen less often are spelled byte by byte */
+#define HUFF_TOKEN_MIN_COUNT 2
+
+/* Length limit for token alphabets */
+#define HUFF_TOKEN_MAX_BITS 20
+
+/* Vocabulary. Ids 0..255 are the single bytes, so any token can be spelled */
+struct huff_vocab
+{
+    unsigned char *pool;  /* bytes of all tokens */
+    size_t pool_size;     /* used bytes of the pool */
+    size_t pool_capacity; /* allocated bytes of the pool */
+    size_t *offsets;      /* position of each token into the pool */
+    unsigned char *lens;  /* size of each token */
+    unsigned int *counts; /* occurrences of each token */
+    int ntokens;          /* tokens into the vocabulary */
+    int capacity;         /* tokens allocated */
+    int *slots;           /* hash slots, token id or -1 */
+    int nslots;           /* number of slots, power of two */
+};
+
+/* Token codec */
+struct huff_token_codec
+{
+    struct huff_vocab vocab; /* tokens and their counts */
+    struct huff_table table; /* table over token ids */
+};
+
+/**
+ * @param c codec to initialize
+ * @return true if allocation did not fail
+ */
+bool huff_token_init(struct huff_token_codec *c);
+void huff_token_free(struct huff_token_codec *c);
+
+/**
+ * @brief Tokenizes the input and adds the counts to the vocabulary
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size
+ * @return true if allocation did not fail
+ */
+bool huff_token_count(struct huff_token_codec *c, const unsigned char *in, size_t len);
+
+/**
+ * @brief Drops rare tokens (their bytes are counted instead) and builds the table
+ *
+ * @param c the codec, after the counts
+ * @return true if table is valid
+ */
+bool huff_token_finish(struct huff_token_codec *c);
+
+/**
+ * @brief Adds a token with zero count e.g while merging vocabularies
+ *
+ * @param c the codec
+ * @param token token bytes
+ * @param len token size
+ * @return id of the token, -1 on error
+ */
+int huff_token_add(struct huff_token_codec *c, const unsigned char *token, int len);
+
+/**
+ * @brief Looks for a token
+ *
+ * @param c the codec
+ * @param token token bytes
+ * @param len token size
+ * @return id of the token, -1 if not found
+ */
+int huff_token_find(const struct huff_token_codec *c, const unsigned char *token, int len);
+
+/**
+ * @brief Serializes the multi-byte tokens as (size, bytes) pairs
+ *
+ * @param c the codec
+ * @param out output buffer, NULL to only compute the size
+ * @return written bytes
+ */
+size_t huff_token_write_vocab(const struct huff_token_codec *c, unsigned char *out);
+
+/**
+ * @brief Adds the tokens written by huff_token_write_vocab() with zero count
+ *
+ * @param c the codec
+ * @param in serialized tokens
+ * @param len size of the serialized tokens
+ * @return true if the input is well formed
+ */
+bool huff_token_read_vocab(struct huff_token_codec *c, const unsigned char *in, size_t len);
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by huff_token_encode()
+ */
+size_t huff_token_bound(size_t len);
+
+/**
+ * @brief Encodes a buffer. Tokens out of the vocabulary are spelled byte by byte
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least huff_token_bound(len) bytes
+ * @param nsymbols location in which save the number of coded symbols
+ * @return written bytes, 0 on error
+ */
+size_t huff_token_encode(const struct huff_token_codec *c, const unsigned char *in, size_t len, unsigned char *out, size_t *nsymbols);
+
+/**
+ * @brief Decodes 'nsymbols' tokens
+ *
+ * @param c the codec
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param nsymbols number of tokens to decode
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the input is a valid encoding
+ */
+bool huff_token_decode(const struct huff_token_codec *c, const unsigned char *in, size_t in_len, size_t nsymbols,
+                       unsigned char *out, size_t out_cap, size_t *out_len);
+
+#endif
@@ -9,20 +9,6 @@
 // calculating height of Huffman Tree
 #define MAX_TREE_HT 100
 
-// A Huffman tree node
-struct MinHeapNode
-{
-
-    // One of the input characters
-    char data;
-
-    // Frequency of the character
-    unsigned freq;
-
-    // Left and right child of this node
-    struct MinHeapNode *left, *right;
-};
-
 // A Min Heap:  Collection of
 // min-heap (or Huffman tree) nodes
 struct MinHeap
@@ -39,15 +25,32 @@ struct MinHeap
 };
 
 
+/**
+ * @brief Order of the heap: by frequency, equal frequencies by creation order.
+ * It is a total order, so the tree only depends on the input arrays and every
+ * process building it from the same frequencies gets the same codes
+ * 
+ * @param a the first node
+ * @param b the second node
+ * 
+ * @return 1 if 'a' comes before 'b', 0 otherwise
+ */
+int nodeLess(struct MinHeapNode *a, struct MinHeapNode *b)
+{
+    return a->freq < b->freq || (a->freq == b->freq && a->order < b->order);
+}
+
+
 /**
  * @brief Utility function to allocate a new min heap node
  * 
- * @param data character
+ * @param data character or symbol index
  * @param freq frequency
+ * @param order creation order
  * 
  * @return the min heap node
  * **/
-struct MinHeapNode *newNode(char data, unsigned freq)
+struct MinHeapNode *newNode(int data, unsigned freq, unsigned order)
 {
     struct MinHeapNode *temp = (struct MinHeapNode *)malloc(
         sizeof(struct MinHeapNode));
@@ -55,6 +58,7 @@ struct MinHeapNode *newNode(char data, unsigned freq)
     temp->left = temp->right = NULL;
     temp->data = data;
     temp->freq = freq;
+    temp->order = order;
 
     return temp;
 }
@@ -114,10 +118,10 @@ void minHeapify(struct MinHeap *minHeap, int idx)
     int left = 2 * idx + 1;
     int right = 2 * idx + 2;
 
-    if (left < minHeap->size && minHeap->array[left]->freq < minHeap->array[smallest]->freq)
+    if (left < minHeap->size && nodeLess(minHeap->array[left], minHeap->array[smallest]))
         smallest = left;
 
-    if (right < minHeap->size && minHeap->array[right]->freq < minHeap->array[smallest]->freq)
+    if (right < minHeap->size && nodeLess(minHeap->array[right], minHeap->array[smallest]))
         smallest = right;
 
     if (smallest != idx)
@@ -179,7 +183,7 @@ void insertMinHeap(struct MinHeap *minHeap,
     ++minHeap->size;
     int i = minHeap->size - 1;
 
-    while (i && minHeapNode->freq < minHeap->array[(i - 1) / 2]->freq)
+    while (i && nodeLess(minHeapNode, minHeap->array[(i - 1) / 2]))
     {
 
         minHeap->array[i] = minHeap->array[(i - 1) / 2];
@@ -221,53 +225,53 @@ int isLeaf(struct MinHeapNode *root)
 }
 
 
-/** 
- * @brief Creates a min heap and inserts all character of data[] in min heap
+/**
+ * @brief Node of a build: taken from the arena nodes if given, otherwise allocated.
+ * Creation orders are unique, so node 'order' of the arena is free
  * 
- * @param data array of characters
- * @param freq array of frequencies
- * @param size capacity of min heap
+ * @param pool arena nodes or NULL
+ * @param data character or symbol index
+ * @param freq frequency
+ * @param order creation order
  * 
- * @return the min heap
+ * @return the node
  */
-struct MinHeap *createAndBuildMinHeap(char data[],
-                                      int freq[], int size)
-
+static struct MinHeapNode *takeNode(struct MinHeapNode *pool, int data, unsigned freq, unsigned order)
 {
-
-    int i;
-    struct MinHeap *minHeap = createMinHeap(size);
-
-    for (i = 0; i < size; ++i)
-        minHeap->array[i] = newNode(data[i], freq[i]);
-
-    minHeap->size = size;
-    buildMinHeap(minHeap);
-
-    return minHeap;
+    if (pool == NULL)
+        return newNode(data, freq, order);
+    struct MinHeapNode *temp = &pool[order];
+    temp->left = temp->right = NULL;
+    temp->data = data;
+    temp->freq = freq;
+    temp->order = order;
+    return temp;
 }
 
 
-
 /**
- * @brief The main function that builds Huffman tree
+ * @brief Builds the Huffman tree into a min heap of at least 'size' capacity
  * 
- * @param data array of character
+ * @param minHeap the min heap
+ * @param data array of characters or symbol indices
  * @param freq array of corresponding frequences
  * @param size size of the previous arrays
+ * @param pool arena nodes (2 * size - 1) or NULL to allocate every node
  * 
  * @return the root of the tree
  */
-struct MinHeapNode *buildHuffmanTree(char data[],
-                                     int freq[], int size)
-
+static struct MinHeapNode *growTree(struct MinHeap *minHeap, int data[], int freq[], int size,
+                                   struct MinHeapNode *pool)
 {
     struct MinHeapNode *left, *right, *top;
+    unsigned order = size;
+    int i;
 
-    // Step 1: Create a min heap of capacity
-    // equal to size.  Initially, there are
-    // modes equal to size.
-    struct MinHeap *minHeap = createAndBuildMinHeap(data, freq, size);
+    // Step 1: Insert all the leaves in the min heap
+    for (i = 0; i < size; ++i)
+        minHeap->array[i] = takeNode(pool, data[i], freq[i], i);
+    minHeap->size = size;
+    buildMinHeap(minHeap);
 
     // Iterate while size of heap doesn't become 1
     while (!isSizeOne(minHeap))
@@ -286,7 +290,7 @@ struct MinHeapNode *buildHuffmanTree(char data[],
         // Add this node to the min heap
         // '$' is a special value for internal nodes, not
         // used
-        top = newNode('$', left->freq + right->freq);
+        top = takeNode(pool, '$', left->freq + right->freq, order++);
 
         top->left = left;
         top->right = right;
@@ -299,14 +303,133 @@ struct MinHeapNode *buildHuffmanTree(char data[],
     return extractMin(minHeap);
 }
 
+
+/**
+ * @brief The main function that builds Huffman tree
+ * 
+ * @param data array of characters or symbol indices
+ * @param freq array of corresponding frequences
+ * @param size size of the previous arrays
+ * 
+ * @return the root of the tree
+ */
+struct MinHeapNode *buildHuffmanTree(int data[],
+                                     int freq[], int size)
+
+{
+    struct MinHeap *minHeap = createMinHeap(size);
+    struct MinHeapNode *top = growTree(minHeap, data, freq, size, NULL);
+    free(minHeap->array);
+    free(minHeap);
+    return top;
+}
+
 // The main function that builds a
 // Huffman Tree and print codes by traversing
 // the built Huffman Tree
 struct MinHeapNode *HuffmanCodes(char data[], int freq[], int size)
 {
+    int i;
+    int *symbols = (int *)malloc(size * sizeof(int));
+    for (i = 0; i < size; i++)
+        symbols[i] = data[i];
 
     // Construct Huffman Tree
-    struct MinHeapNode *root = buildHuffmanTree(data, freq, size);
+    struct MinHeapNode *root = buildHuffmanTree(symbols, freq, size);
 
+    free(symbols);
     return root;
 }
+
+/**
+ * @brief Builds the Huffman tree of a generic alphabet e.g 16-bit units,
+ * code points or tokens. Leaves hold the given symbol indices.
+ * 
+ * @param data array of symbol indices
+ * @param freq array of corresponding frequences
+ * @param size size of the previous arrays
+ * 
+ * @return the root of the tree
+ */
+struct MinHeapNode *HuffmanCodesSymbols(int data[], int freq[], int size)
+{
+    return buildHuffmanTree(data, freq, size);
+}
+
+
+/**
+ * @brief Releases every node of a tree built by HuffmanCodes()
+ * 
+ * @param root the root of the tree
+ */
+void freeTree(struct MinHeapNode *root)
+{
+    if (root == NULL)
+        return;
+    freeTree(root->left);
+    freeTree(root->right);
+    free(root);
+}
+
+
+/**
+ * @brief Makes room in the arena for trees of up to 'leaves' leaves. Grows only,
+ * so once the largest alphabet was seen builds do not allocate
+ * 
+ * @param arena the arena, zeroed before the first call
+ * @param leaves number of leaves
+ * 
+ * @return 1 if allocation did not fail, 0 otherwise
+ */
+int huff_tree_arena_reserve(struct huff_tree_arena *arena, int leaves)
+{
+    if (leaves <= arena->capacity)
+        return 1;
+    struct MinHeapNode *nodes = (struct MinHeapNode *)realloc(arena->nodes, (2 * leaves - 1) * sizeof(struct MinHeapNode));
+    if (nodes == NULL)
+        return 0;
+    arena->nodes = nodes;
+    struct MinHeapNode **heap = (struct MinHeapNode **)realloc(arena->heap, leaves * sizeof(struct MinHeapNode *));
+    if (heap == NULL)
+        return 0;
+    arena->heap = heap;
+    arena->capacity = leaves;
+    return 1;
+}
+
+/**
+ * @brief Builds the Huffman tree into the arena: no allocation once the arena is large
+ * enough. The tree is the same of HuffmanCodesSymbols() and lives until the next build,
+ * it must not be released with freeTree()
+ * 
+ * @param arena the arena
+ * @param data array of symbol indices
+ * @param freq array of corresponding frequences
+ * @param size size of the previous arrays
+ * 
+ * @return the root of the tree, NULL if allocation failed
+ */
+struct MinHeapNode *HuffmanCodesArena(struct huff_tree_arena *arena, int data[], int freq[], int size)
+{
+    struct MinHeap minHeap;
+    if (!huff_tree_arena_reserve(arena, size))
+        return NULL;
+    minHeap.size = 0;
+    minHeap.capacity = arena->capacity;
+    minHeap.array = arena->heap;
+    return growTree(&minHeap, data, freq, size, arena->nodes);
+}
+
+/**
+ * @brief Releases the memory of the arena
+ * 
+ * @param arena the arena
+ */
+void huff_tree_arena_free(struct huff_tree_arena *arena)
+{
+    free(arena->nodes);
+    free(arena->heap);
+    arena->nodes = NULL;
+    arena->heap = NULL;
+    arena->capacity = 0;
+}
@@ -1,3 +1,23 @@
+#ifndef TREE_UTILS_H
+# define TREE_UTILS_H
+
+/* A Huffman tree node */
+struct MinHeapNode
+{
+    int data;                         /* defined char or symbol index */
+    unsigned freq;                    /* frequency */
+    unsigned order;                   /* creation order, breaks ties between equal frequencies */
+    struct MinHeapNode *left, *right; /* pointers to left and right nodes */
+};
+
+/* Storage reused by every tree built with HuffmanCodesArena(). Zeroed before first use */
+struct huff_tree_arena
+{
+    struct MinHeapNode *nodes; /* 2 * capacity - 1 nodes */
+    struct MinHeapNode **heap; /* min heap of capacity nodes */
+    int capacity;              /* max number of leaves */
+};
+
 /**
  * @brief Compute the huffman tree.
  * 
@@ -8,6 +28,16 @@
  */
 struct MinHeapNode *HuffmanCodes(char data[], int freq[], int size);
 
+/**
+ * @brief Compute the huffman tree of a generic alphabet e.g code points.
+ * 
+ * @param data array of symbol indices
+ * @param freq array of corresponding frequences
+ * @param size size of the previous arrays
+ * @return the tree as MinHeapNode structure
+ */
+struct MinHeapNode *HuffmanCodesSymbols(int data[], int freq[], int size);
+
 /** 
  * @brief Utility function to check if this node is leaf
  * 
@@ -15,4 +45,45 @@ struct MinHeapNode *HuffmanCodes(char data[], int freq[], int size);
  * 
  * @return 1 if is a leaf, 0 otherwise
  */
-int isLeaf(struct MinHeapNode *root);
\ No newline at end of file
+int isLeaf(struct MinHeapNode *root);
+
+/**
+ * @brief Releases every node of a tree built by HuffmanCodes()
+ * 
+ * @param root the root of the tree
+ */
+void freeTree(struct MinHeapNode *root);
+
+/**
+ * @brief Makes room in the arena for trees of up to 'leaves' leaves. Grows only,
+ * so once the largest alphabet was seen builds do not allocate
+ * 
+ * @param arena the arena, zeroed before the first call
+ * @param leaves number of leaves
+ * 
+ * @return 1 if allocation did not fail, 0 otherwise
+ */
+int huff_tree_arena_reserve(struct huff_tree_arena *arena, int leaves);
+
+/**
+ * @brief Builds the Huffman tree into the arena: no allocation once the arena is large
+ * enough. The tree is the same of HuffmanCodesSymbols() and lives until the next build,
+ * it must not be released with freeTree()
+ * 
+ * @param arena the arena
+ * @param data array of symbol indices
+ * @param freq array of corresponding frequences
+ * @param size size of the previous arrays
+ * 
+ * @return the root of the tree, NULL if allocation failed
+ */
+struct MinHeapNode *HuffmanCodesArena(struct huff_tree_arena *arena, int data[], int freq[], int size);
+
+/**
+ * @brief Releases the memory of the arena
+ * 
+ * @param arena the arena
+ */
+void huff_tree_arena_free(struct huff_tree_arena *arena);
+
+#endif
@@ -0,0 +1,257 @@
+/**
+ * @file tune_utils.c
+ * @brief Implementation of the autotuning
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "tune_utils.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Buffers of a calibration */
+struct tune_state
+{
+    const unsigned char *in;
+    size_t len;
+    enum huff_backend backend;
+    unsigned char *coded;
+    size_t coded_len;
+    unsigned char *decoded;
+    struct huff_block_ctx ctx;
+};
+
+/**
+ * @brief Fills the profile with the built-in defaults
+ *
+ * @param p the profile
+ */
+void huff_profile_defaults(struct huff_profile *p)
+{
+    memset(p, 0, sizeof(struct huff_profile));
+    p->block_size = HUFF_BLOCK_SIZE;
+    p->lookup_bits = HUFF_LOOKUP_BITS;
+    p->threads = 0;
+    p->ranks_per_node = 1;
+}
+
+/**
+ * @brief Reads a profile file. Missing keys keep their value
+ *
+ * @param p location in which save the profile
+ * @param filename the file e.g HUFF_PROFILE_FILE
+ * @return true if the file exists and is valid
+ */
+bool huff_profile_load(struct huff_profile *p, const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+        return false;
+
+    struct huff_profile loaded = *p;
+    char line[128], key[64];
+    double value;
+    bool ok = true;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (line[0] == '#' || sscanf(line, "%63s %lf", key, &value) != 2)
+            continue;
+        if (strcmp(key, "block_size") == 0)
+            loaded.block_size = (size_t)value;
+        else if (strcmp(key, "lookup_bits") == 0)
+            loaded.lookup_bits = (int)value;
+        else if (strcmp(key, "threads") == 0)
+            loaded.threads = (int)value;
+        else if (strcmp(key, "ranks_per_node") == 0)
+            loaded.ranks_per_node = (int)value;
+        else if (strcmp(key, "hist_mbps") == 0)
+            loaded.hist_mbps = value;
+        else if (strcmp(key, "enc_mbps") == 0)
+            loaded.enc_mbps = value;
+        else if (strcmp(key, "dec_mbps") == 0)
+            loaded.dec_mbps = value;
+    }
+    fclose(fp);
+
+    if (loaded.block_size < 1024 || loaded.block_size > HUFF_TUNE_MAX_BLOCK * 64 ||
+        loaded.lookup_bits < HUFF_MIN_LOOKUP_BITS || loaded.lookup_bits > HUFF_MAX_LOOKUP_BITS || loaded.threads < 0)
+        ok = false;
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Invalid profile [%s], using defaults!\n", filename);
+        return false;
+    }
+    *p = loaded;
+    return true;
+}
+
+/**
+ * @param p the profile
+ * @param filename the file e.g HUFF_PROFILE_FILE
+ * @return true if write did not fail
+ */
+bool huff_profile_save(const struct huff_profile *p, const char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: Can not write profile [%s]!\n", filename);
+        return false;
+    }
+    fprintf(fp, "# Written by --autotune, loaded by the next runs\n");
+    fprintf(fp, "block_size %zu\n", p->block_size);
+    fprintf(fp, "lookup_bits %d\n", p->lookup_bits);
+    fprintf(fp, "threads %d\n", p->threads);
+    fprintf(fp, "ranks_per_node %d\n", p->ranks_per_node);
+    fprintf(fp, "hist_mbps %.1f\n", p->hist_mbps);
+    fprintf(fp, "enc_mbps %.1f\n", p->enc_mbps);
+    fprintf(fp, "dec_mbps %.1f\n", p->dec_mbps);
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief Sets the decode table width and, if given, the number of threads. Not to be
+ * called within a parallel region
+ *
+ * @param p the profile
+ */
+void huff_profile_apply(const struct huff_profile *p)
+{
+    huff_set_lookup_bits(p->lookup_bits);
+    if (p->threads > 0)
+        omp_set_num_threads(p->threads);
+}
+
+/**
+ * @brief Best times of compression and/or decompression of the sample
+ *
+ * @param s the calibration buffers
+ * @param block_size block size
+ * @param encode true to time compression, otherwise 's->coded' is decoded
+ * @param enc_time location in which save the best compression time
+ * @param dec_time location in which save the best decompression time
+ * @return true if the sample round-tripped
+ */
+static bool time_pass(struct tune_state *s, size_t block_size, bool encode, double *enc_time, double *dec_time)
+{
+    double spent = 0;
+    int reps;
+    *enc_time = *dec_time = 1e30;
+    for (reps = 0; reps < HUFF_TUNE_MIN_REPS || spent < HUFF_TUNE_MIN_TIME; reps++)
+    {
+        size_t decoded_len;
+        double t0 = omp_get_wtime();
+        if (encode)
+            s->coded_len = huff_compress_fused_ctx(&s->ctx, s->in, s->len, block_size, s->coded);
+        double t1 = omp_get_wtime();
+        bool ok = s->coded_len > 0 &&
+                  huff_decompress_blocks_ctx(&s->ctx, s->coded, s->coded_len, s->decoded, s->len, &decoded_len);
+        double t2 = omp_get_wtime();
+        if (!ok || decoded_len != s->len || memcmp(s->decoded, s->in, s->len) != 0)
+            return false;
+        if (t1 - t0 < *enc_time)
+            *enc_time = t1 - t0;
+        if (t2 - t1 < *dec_time)
+            *dec_time = t2 - t1;
+        spent += t2 - t0;
+    }
+    return true;
+}
+
+/**
+ * @brief Measures compression and decompression of the sample for every thread count
+ * and block size, then every decode table width, and keeps the fastest configuration.
+ * Leaves the number of threads and the table width as they were
+ *
+ * @param sample input sample, e.g the piece of one process
+ * @param len sample size
+ * @param backend backends the blocks can be coded with
+ * @param p location in which save the profile
+ * @return true if every calibration pass round-tripped
+ */
+bool huff_autotune(const unsigned char *sample, size_t len, enum huff_backend backend, struct huff_profile *p)
+{
+    struct tune_state s;
+    int procs = omp_get_num_procs(), saved_threads = omp_get_max_threads(), saved_bits = huff_get_lookup_bits();
+    int threads, bits;
+    double best = 1e30, enc_time, dec_time;
+    size_t block;
+    bool ok = true;
+
+    huff_profile_defaults(p);
+    if (len == 0)
+        return false;
+    s.in = sample;
+    s.len = len;
+    s.backend = backend;
+    s.coded = (unsigned char *)malloc(huff_fused_bound(len, HUFF_TUNE_MIN_BLOCK));
+    s.decoded = (unsigned char *)malloc(len);
+    if (s.coded == NULL || s.decoded == NULL || !huff_block_ctx_init(&s.ctx, backend, procs))
+    {
+        fprintf(stderr, "ERROR: Autotune allocation failed!\n");
+        free(s.coded);
+        free(s.decoded);
+        return false;
+    }
+
+    /* Histogram of one thread, the lower bound of every pass */
+    unsigned int freq[HUFF_BYTE_SYMBOLS];
+    double t0 = omp_get_wtime();
+    memset(freq, 0, sizeof(freq));
+    huff_histogram(sample, len, freq);
+    double t1 = omp_get_wtime();
+    p->hist_mbps = (t1 > t0) ? len / 1e6 / (t1 - t0) : 0;
+
+    /* Threads and block size together: fewer blocks than threads leave threads idle */
+    for (threads = 1; threads <= procs && ok; threads = (threads < procs && threads * 2 > procs) ? procs : threads * 2)
+    {
+        omp_set_num_threads(threads);
+        for (block = HUFF_TUNE_MIN_BLOCK; block <= HUFF_TUNE_MAX_BLOCK && ok; block *= 2)
+        {
+            ok = time_pass(&s, block, true, &enc_time, &dec_time);
+            if (ok && enc_time + dec_time < best)
+            {
+                best = enc_time + dec_time;
+                p->threads = threads;
+                p->block_size = block;
+                p->enc_mbps = len / 1e6 / enc_time;
+                p->dec_mbps = len / 1e6 / dec_time;
+            }
+            /* Larger blocks than the sample all give one block */
+            if (block >= len)
+                break;
+        }
+        if (threads == procs)
+            break;
+    }
+
+    /* Table width only changes decoding, the stream is coded once */
+    omp_set_num_threads(p->threads);
+    if (ok)
+        ok = time_pass(&s, p->block_size, true, &enc_time, &dec_time);
+    best = 1e30;
+    for (bits = HUFF_TUNE_MIN_LOOKUP; bits <= HUFF_TUNE_MAX_LOOKUP && ok; bits++)
+    {
+        huff_set_lookup_bits(bits);
+        ok = time_pass(&s, p->block_size, false, &enc_time, &dec_time);
+        if (ok && dec_time < best)
+        {
+            best = dec_time;
+            p->lookup_bits = bits;
+            p->dec_mbps = len / 1e6 / dec_time;
+        }
+    }
+    p->ranks_per_node = (procs / p->threads > 0) ? procs / p->threads : 1;
+
+    omp_set_num_threads(saved_threads);
+    huff_set_lookup_bits(saved_bits);
+    free(s.coded);
+    free(s.decoded);
+    huff_block_ctx_free(&s.ctx);
+    if (!ok)
+        fprintf(stderr, "ERROR: Autotune round trip failed!\n");
+    return ok;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file tune_utils.h
+ * @brief Autotuning of the block codec: short calibration passes on a sample of the
+ *        input choose block size, decode table width and threads, saved to a profile
+ *        file that later runs load
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include "block_utils.h"
+
+#ifndef TUNE_H
+# define TUNE_H
+
+/* Default profile file, into the working directory */
+#define HUFF_PROFILE_FILE "huffman.profile"
+
+/* A calibration pass is repeated at least HUFF_TUNE_MIN_REPS times and for HUFF_TUNE_MIN_TIME seconds */
+#define HUFF_TUNE_MIN_REPS 3
+#define HUFF_TUNE_MIN_TIME 0.02
+
+/* Candidate block sizes: powers of two in this range */
+#define HUFF_TUNE_MIN_BLOCK (8 * 1024)
+#define HUFF_TUNE_MAX_BLOCK (1024 * 1024)
+
+/* Candidate decode table widths */
+#define HUFF_TUNE_MIN_LOOKUP 8
+#define HUFF_TUNE_MAX_LOOKUP 12
+
+/* Tuned configuration */
+struct huff_profile
+{
+    size_t block_size;  /* block size of the fused mode */
+    int lookup_bits;    /* width of the root decode table */
+    int threads;        /* OpenMP threads of each process, 0 for the OpenMP default */
+    int ranks_per_node; /* suggested processes per node: cores / threads */
+    double hist_mbps;   /* histogram throughput of one thread */
+    double enc_mbps;    /* compression throughput with this configuration */
+    double dec_mbps;    /* decompression throughput with this configuration */
+};
+
+/**
+ * @brief Fills the profile with the built-in defaults
+ *
+ * @param p the profile
+ */
+void huff_profile_defaults(struct huff_profile *p);
+
+/**
+ * @brief Reads a profile file. Missing keys keep their value
+ *
+ * @param p location in which save the profile
+ * @param filename the file e.g HUFF_PROFILE_FILE
+ * @return true if the file exists and is valid
+ */
+bool huff_profile_load(struct huff_profile *p, const char *filename);
+
+/**
+ * @param p the profile
+ * @param filename the file e.g HUFF_PROFILE_FILE
+ * @return true if write did not fail
+ */
+bool huff_profile_save(const struct huff_profile *p, const char *filename);
+
+/**
+ * @brief Sets the decode table width and, if given, the number of threads. Not to be
+ * called within a parallel region
+ *
+ * @param p the profile
+ */
+void huff_profile_apply(const struct huff_profile *p);
+
+/**
+ * @brief Measures compression and decompression of the sample for every thread count
+ * and block size, then every decode table width, and keeps the fastest configuration.
+ * Leaves the number of threads and the table width as they were
+ *
+ * @param sample input sample, e.g the piece of one process
+ * @param len sample size
+ * @param backend backends the blocks can be coded with
+ * @param p location in which save the profile
+ * @return true if every calibration pass round-tripped
+ */
+bool huff_autotune(const unsigned char *sample, size_t len, enum huff_backend backend, struct huff_profile *p);
+
+#endif
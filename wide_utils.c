@@ -0,0 +1,471 @@
+/**
+ * @file wide_utils.c
+ * @brief Implementation of symbol-width generic coding
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include "wide_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAP_INITIAL_CAPACITY 1024
+
+static bool map_alloc(struct huff_symbol_map *m, int capacity)
+{
+    m->keys = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    m->counts = (unsigned int *)calloc(capacity, sizeof(unsigned int));
+    m->index = (int *)calloc(capacity, sizeof(int));
+    m->capacity = capacity;
+    m->size = 0;
+    return m->keys != NULL && m->counts != NULL && m->index != NULL;
+}
+
+static void map_release(struct huff_symbol_map *m)
+{
+    free(m->keys);
+    free(m->counts);
+    free(m->index);
+    memset(m, 0, sizeof(struct huff_symbol_map));
+}
+
+static int map_slot(const struct huff_symbol_map *m, uint32_t key)
+{
+    int slot = (key * 2654435761u) & (m->capacity - 1);
+    while (m->counts[slot] != 0 && m->keys[slot] != key)
+        slot = (slot + 1) & (m->capacity - 1);
+    return slot;
+}
+
+/* Doubles the map when it is half full */
+static bool map_grow(struct huff_symbol_map *m)
+{
+    struct huff_symbol_map bigger;
+    int i;
+    if (!map_alloc(&bigger, m->capacity * 2))
+    {
+        map_release(&bigger);
+        return false;
+    }
+    for (i = 0; i < m->capacity; i++)
+    {
+        if (m->counts[i] == 0)
+            continue;
+        int slot = map_slot(&bigger, m->keys[i]);
+        bigger.keys[slot] = m->keys[i];
+        bigger.counts[slot] = m->counts[i];
+        bigger.index[slot] = m->index[i];
+        bigger.size++;
+    }
+    map_release(m);
+    *m = bigger;
+    return true;
+}
+
+static bool map_add(struct huff_symbol_map *m, uint32_t key)
+{
+    int slot = map_slot(m, key);
+    if (m->counts[slot] == 0)
+    {
+        if (2 * (m->size + 1) > m->capacity)
+        {
+            if (!map_grow(m))
+                return false;
+            slot = map_slot(m, key);
+        }
+        m->keys[slot] = key;
+        m->size++;
+    }
+    m->counts[slot]++;
+    return true;
+}
+
+/**
+ * @brief Reads the next symbol. Invalid UTF-8 sequences produce escaped bytes
+ * so that any input is coded losslessly.
+ *
+ * @return size in bytes of the symbol
+ */
+static int next_symbol(int mode, const unsigned char *in, size_t len, uint32_t *symbol)
+{
+    if (mode == HUFF_SYMBOLS_8)
+    {
+        *symbol = in[0];
+        return 1;
+    }
+    if (mode == HUFF_SYMBOLS_16)
+    {
+        *symbol = in[0] | (in[1] << 8);
+        return 2;
+    }
+
+    unsigned char c = in[0];
+    int n, i;
+    uint32_t cp, min;
+    if (c < 0x80)
+    {
+        *symbol = c;
+        return 1;
+    }
+    else if ((c & 0xe0) == 0xc0)
+    {
+        n = 2;
+        cp = c & 0x1f;
+        min = 0x80;
+    }
+    else if ((c & 0xf0) == 0xe0)
+    {
+        n = 3;
+        cp = c & 0x0f;
+        min = 0x800;
+    }
+    else if ((c & 0xf8) == 0xf0)
+    {
+        n = 4;
+        cp = c & 0x07;
+        min = 0x10000;
+    }
+    else
+        n = 0;
+
+    if (n == 0 || (size_t)n > len)
+    {
+        *symbol = HUFF_UTF8_ESCAPE + c;
+        return 1;
+    }
+    for (i = 1; i < n; i++)
+    {
+        if ((in[i] & 0xc0) != 0x80)
+        {
+            *symbol = HUFF_UTF8_ESCAPE + c;
+            return 1;
+        }
+        cp = (cp << 6) | (in[i] & 0x3f);
+    }
+    /* Overlong forms and surrogates would not be written back the same way */
+    if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+    {
+        *symbol = HUFF_UTF8_ESCAPE + c;
+        return 1;
+    }
+    *symbol = cp;
+    return n;
+}
+
+/* Writes a symbol back, returns its size in bytes or 0 if it does not fit */
+static int put_symbol(int mode, uint32_t symbol, unsigned char *out, size_t cap)
+{
+    if (mode == HUFF_SYMBOLS_8 || (mode == HUFF_SYMBOLS_UTF8 && (symbol < 0x80 || symbol >= HUFF_UTF8_ESCAPE)))
+    {
+        if (cap < 1)
+            return 0;
+        out[0] = (symbol < 0x80) ? symbol : symbol - ((mode == HUFF_SYMBOLS_8) ? 0 : HUFF_UTF8_ESCAPE);
+        return 1;
+    }
+    if (mode == HUFF_SYMBOLS_16)
+    {
+        if (cap < 2)
+            return 0;
+        out[0] = symbol & 0xff;
+        out[1] = symbol >> 8;
+        return 2;
+    }
+    if (symbol < 0x800)
+    {
+        if (cap < 2)
+            return 0;
+        out[0] = 0xc0 | (symbol >> 6);
+        out[1] = 0x80 | (symbol & 0x3f);
+        return 2;
+    }
+    if (symbol < 0x10000)
+    {
+        if (cap < 3)
+            return 0;
+        out[0] = 0xe0 | (symbol >> 12);
+        out[1] = 0x80 | ((symbol >> 6) & 0x3f);
+        out[2] = 0x80 | (symbol & 0x3f);
+        return 3;
+    }
+    if (cap < 4)
+        return 0;
+    out[0] = 0xf0 | (symbol >> 18);
+    out[1] = 0x80 | ((symbol >> 12) & 0x3f);
+    out[2] = 0x80 | ((symbol >> 6) & 0x3f);
+    out[3] = 0x80 | (symbol & 0x3f);
+    return 4;
+}
+
+static int compare_symbols(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Makes room for 'n' dictionary entries and a table over them */
+static bool reserve_symbols(struct huff_wide_codec *c, int n)
+{
+    if (n > c->dict_capacity)
+    {
+        uint32_t *tmp = (uint32_t *)realloc(c->symbols, n * sizeof(uint32_t));
+        if (tmp == NULL)
+            return false;
+        c->symbols = tmp;
+        c->dict_capacity = n;
+    }
+    if (n > c->table.capacity)
+    {
+        huff_table_free(&c->table);
+        if (!huff_table_init(&c->table, n))
+            return false;
+    }
+    c->table.nsymbols = (n > 0) ? n : 1;
+    c->nsymbols = n;
+    return true;
+}
+
+/**
+ * @param c codec to initialize
+ * @param mode one of HUFF_SYMBOLS_*
+ * @return true if allocation did not fail
+ */
+bool huff_wide_init(struct huff_wide_codec *c, int mode)
+{
+    memset(c, 0, sizeof(struct huff_wide_codec));
+    c->mode = mode;
+    if (!map_alloc(&c->map, MAP_INITIAL_CAPACITY) || !huff_table_init(&c->table, HUFF_BYTE_SYMBOLS))
+    {
+        huff_wide_free(c);
+        return false;
+    }
+    return true;
+}
+
+void huff_wide_free(struct huff_wide_codec *c)
+{
+    map_release(&c->map);
+    huff_table_free(&c->table);
+    free(c->symbols);
+    memset(c, 0, sizeof(struct huff_wide_codec));
+}
+
+/**
+ * @brief Counts the symbols of the input and builds dictionary and table
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size, even in 16-bit mode
+ * @return true if table is valid
+ */
+bool huff_wide_build(struct huff_wide_codec *c, const unsigned char *in, size_t len)
+{
+    size_t pos = 0;
+    int i, k = 0;
+    uint32_t symbol;
+
+    if (c->mode == HUFF_SYMBOLS_16 && len % 2 != 0)
+    {
+        fprintf(stderr, "ERROR: 16-bit mode needs an even input size!\n");
+        return false;
+    }
+
+    /* Sparse histogram */
+    memset(c->map.counts, 0, c->map.capacity * sizeof(unsigned int));
+    c->map.size = 0;
+    while (pos < len)
+    {
+        pos += next_symbol(c->mode, in + pos, len - pos, &symbol);
+        if (!map_add(&c->map, symbol))
+            return false;
+    }
+
+    /* Dictionary sorted by value, so that it can be stored as deltas */
+    if (!reserve_symbols(c, c->map.size))
+        return false;
+    for (i = 0; i < c->map.capacity; i++)
+    {
+        if (c->map.counts[i] != 0)
+            c->symbols[k++] = c->map.keys[i];
+    }
+    qsort(c->symbols, c->nsymbols, sizeof(uint32_t), compare_symbols);
+
+    unsigned int *freq = (unsigned int *)calloc(c->table.nsymbols, sizeof(unsigned int));
+    for (i = 0; i < c->nsymbols; i++)
+    {
+        int slot = map_slot(&c->map, c->symbols[i]);
+        c->map.index[slot] = i;
+        freq[i] = c->map.counts[slot];
+    }
+    bool res = huff_table_from_freq(&c->table, freq, HUFF_WIDE_MAX_BITS);
+    free(freq);
+    return res;
+}
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by huff_wide_encode()
+ */
+size_t huff_wide_bound(size_t len)
+{
+    return (len * HUFF_WIDE_MAX_BITS + 7) / 8;
+}
+
+/**
+ * @brief Encodes a buffer. Every symbol must be into the dictionary
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least huff_wide_bound(len) bytes
+ * @param nsymbols location in which save the number of coded symbols
+ * @return written bytes, 0 on error
+ */
+size_t huff_wide_encode(struct huff_wide_codec *c, const unsigned char *in, size_t len, unsigned char *out, size_t *nsymbols)
+{
+    struct bit_writer w;
+    size_t pos = 0, count = 0;
+    uint32_t symbol;
+
+    if (c->mode == HUFF_SYMBOLS_16 && len % 2 != 0)
+        return 0;
+    bw_init(&w, out);
+    while (pos < len)
+    {
+        pos += next_symbol(c->mode, in + pos, len - pos, &symbol);
+        int slot = map_slot(&c->map, symbol);
+        if (c->map.counts[slot] == 0)
+        {
+            fprintf(stderr, "ERROR: symbol %u not in the dictionary!\n", symbol);
+            return 0;
+        }
+        int idx = c->map.index[slot];
+        bw_put(&w, c->table.codes[idx], c->table.lengths[idx]);
+        count++;
+    }
+    *nsymbols = count;
+    return bw_flush(&w);
+}
+
+/**
+ * @brief Decodes 'nsymbols' symbols
+ *
+ * @param c the codec
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param nsymbols number of symbols to decode
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the input is a valid encoding
+ */
+bool huff_wide_decode(struct huff_wide_codec *c, const unsigned char *in, size_t in_len, size_t nsymbols,
+                      unsigned char *out, size_t out_cap, size_t *out_len)
+{
+    struct bit_reader r;
+    size_t i, pos = 0;
+    br_init(&r, in, in_len);
+    for (i = 0; i < nsymbols; i++)
+    {
+        br_refill(&r);
+        int idx = huff_decode_symbol(&c->table, &r);
+        if (idx < 0 || idx >= c->nsymbols)
+            return false;
+        int n = put_symbol(c->mode, c->symbols[idx], out + pos, out_cap - pos);
+        if (n == 0)
+            return false;
+        pos += n;
+    }
+    *out_len = pos;
+    return br_consumed(&r) <= in_len * 8;
+}
+
+/**
+ * @brief Serializes mode, dictionary and code lengths.
+ * Layout: mode (1 byte), nsymbols (4 bytes), then for each symbol the delta
+ * from the previous one as varint and its code length (1 byte).
+ *
+ * @param c the codec
+ * @param out output of at least 5 + 6 * nsymbols bytes
+ * @return written bytes
+ */
+size_t huff_wide_write_table(struct huff_wide_codec *c, unsigned char *out)
+{
+    size_t pos = 0;
+    uint32_t prev = 0;
+    int i;
+    out[pos++] = c->mode;
+    for (i = 0; i < 4; i++)
+        out[pos++] = (c->nsymbols >> (8 * i)) & 0xff;
+    for (i = 0; i < c->nsymbols; i++)
+    {
+        uint32_t delta = c->symbols[i] - prev;
+        prev = c->symbols[i];
+        while (delta >= 0x80)
+        {
+            out[pos++] = 0x80 | (delta & 0x7f);
+            delta >>= 7;
+        }
+        out[pos++] = delta;
+        out[pos++] = c->table.lengths[i];
+    }
+    return pos;
+}
+
+/**
+ * @brief Reads what huff_wide_write_table() wrote and builds the table
+ *
+ * @param c codec initialized with huff_wide_init()
+ * @param in serialized table
+ * @param len available bytes
+ * @return consumed bytes, 0 on error
+ */
+size_t huff_wide_read_table(struct huff_wide_codec *c, const unsigned char *in, size_t len)
+{
+    size_t pos = 5;
+    uint32_t prev = 0;
+    int i, n = 0;
+    if (len < 5)
+        return 0;
+    c->mode = in[0];
+    for (i = 0; i < 4; i++)
+        n |= in[1 + i] << (8 * i);
+    if (n < 0 || !reserve_symbols(c, n))
+        return 0;
+
+    unsigned char *lengths = (unsigned char *)calloc(c->table.nsymbols, sizeof(unsigned char));
+    memset(c->map.counts, 0, c->map.capacity * sizeof(unsigned int));
+    c->map.size = 0;
+    for (i = 0; i < n; i++)
+    {
+        uint32_t delta = 0;
+        int shift = 0;
+        while (pos < len && (in[pos] & 0x80) && shift < 28)
+        {
+            delta |= (uint32_t)(in[pos++] & 0x7f) << shift;
+            shift += 7;
+        }
+        if (pos + 2 > len)
+        {
+            free(lengths);
+            return 0;
+        }
+        delta |= (uint32_t)in[pos++] << shift;
+        prev += delta;
+        c->symbols[i] = prev;
+        lengths[i] = in[pos++];
+
+        /* Map is needed by the encoder */
+        if (!map_add(&c->map, prev))
+        {
+            free(lengths);
+            return 0;
+        }
+        c->map.index[map_slot(&c->map, prev)] = i;
+    }
+    bool res = huff_table_from_lengths(&c->table, lengths);
+    free(lengths);
+    return res ? pos : 0;
+}
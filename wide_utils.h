@@ -0,0 +1,121 @@
+/**
+ * @file wide_utils.h
+ * @brief Symbol-width generic coding: 8-bit bytes, 16-bit units or UTF-8 code points.
+ *        Wide alphabets use a sparse histogram and a dictionary of the used symbols.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "codec_utils.h"
+
+#ifndef WIDE_H
+# define WIDE_H
+
+/* Symbol modes */
+#define HUFF_SYMBOLS_8 1    /* one symbol per byte */
+#define HUFF_SYMBOLS_16 2   /* one symbol per 16-bit little endian unit */
+#define HUFF_SYMBOLS_UTF8 3 /* one symbol per UTF-8 code point */
+
+/* Length limit for wide alphabets */
+#define HUFF_WIDE_MAX_BITS 20
+
+/* Invalid UTF-8 bytes are coded as HUFF_UTF8_ESCAPE + byte, outside the Unicode range */
+#define HUFF_UTF8_ESCAPE 0x110000
+
+/* Sparse histogram: open addressing map from symbol value to its count */
+struct huff_symbol_map
+{
+    uint32_t *keys;       /* symbol values */
+    unsigned int *counts; /* occurrences, 0 if the slot is free */
+    int *index;           /* position of the symbol into the dictionary */
+    int capacity;         /* number of slots, power of two */
+    int size;             /* used slots */
+};
+
+/* Codec of a wide alphabet */
+struct huff_wide_codec
+{
+    int mode;                   /* one of HUFF_SYMBOLS_* */
+    int nsymbols;               /* distinct symbols */
+    int dict_capacity;          /* symbols allocated into the dictionary */
+    uint32_t *symbols;          /* dictionary sorted by value e.g index -> symbol */
+    struct huff_symbol_map map; /* symbol -> count and index */
+    struct huff_table table;    /* table over dictionary indices */
+};
+
+/**
+ * @param c codec to initialize
+ * @param mode one of HUFF_SYMBOLS_*
+ * @return true if allocation did not fail
+ */
+bool huff_wide_init(struct huff_wide_codec *c, int mode);
+void huff_wide_free(struct huff_wide_codec *c);
+
+/**
+ * @brief Counts the symbols of the input and builds dictionary and table
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size, even in 16-bit mode
+ * @return true if table is valid
+ */
+bool huff_wide_build(struct huff_wide_codec *c, const unsigned char *in, size_t len);
+
+/**
+ * @brief Worst case encoded size
+ *
+ * @param len input size
+ * @return max number of bytes written by huff_wide_encode()
+ */
+size_t huff_wide_bound(size_t len);
+
+/**
+ * @brief Encodes a buffer. Every symbol must be into the dictionary
+ *
+ * @param c the codec
+ * @param in input buffer
+ * @param len input size
+ * @param out output of at least huff_wide_bound(len) bytes
+ * @param nsymbols location in which save the number of coded symbols
+ * @return written bytes, 0 on error
+ */
+size_t huff_wide_encode(struct huff_wide_codec *c, const unsigned char *in, size_t len, unsigned char *out, size_t *nsymbols);
+
+/**
+ * @brief Decodes 'nsymbols' symbols
+ *
+ * @param c the codec
+ * @param in encoded buffer
+ * @param in_len encoded size
+ * @param nsymbols number of symbols to decode
+ * @param out output buffer
+ * @param out_cap size of the output buffer
+ * @param out_len location in which save the decoded size
+ * @return true if the input is a valid encoding
+ */
+bool huff_wide_decode(struct huff_wide_codec *c, const unsigned char *in, size_t in_len, size_t nsymbols,
+                      unsigned char *out, size_t out_cap, size_t *out_len);
+
+/**
+ * @brief Serializes mode, dictionary and code lengths
+ *
+ * @param c the codec
+ * @param out output of at least 5 + 6 * nsymbols bytes
+ * @return written bytes
+ */
+size_t huff_wide_write_table(struct huff_wide_codec *c, unsigned char *out);
+
+/**
+ * @brief Reads what huff_wide_write_table() wrote and builds the table
+ *
+ * @param c codec initialized with huff_wide_init()
+ * @param in serialized table
+ * @param len available bytes
+ * @return consumed bytes, 0 on error
+ */
+size_t huff_wide_read_table(struct huff_wide_codec *c, const unsigned char *in, size_t len);
+
+#endif